@@ -3,21 +3,32 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 
-// Instanced model matrix (4 vec4s = mat4)
-layout(location = 2) in vec4 instanceModel0;
-layout(location = 3) in vec4 instanceModel1;
-layout(location = 4) in vec4 instanceModel2;
-layout(location = 5) in vec4 instanceModel3;
-
-// Instanced material properties
-layout(location = 6) in vec4 instanceAmbient;
-layout(location = 7) in vec4 instanceDiffuse;
-layout(location = 8) in vec4 instanceSpecular;
-layout(location = 9) in float instanceShininess;
+// Instanced index into the shape table
+layout(location = 2) in uint instanceShape;
+
+// Shape table (ShapeTable in shapes/shapetable.h): four texels of model matrix per shape,
+// and its index into the material table
+uniform samplerBuffer shapeModels;
+uniform usamplerBuffer shapeMaterials;
+
+// Material table, four texels per material: ambient, diffuse, specular, (shininess, 0, 0, 0)
+uniform samplerBuffer materials;
 
 uniform mat4 view;
 uniform mat4 proj;
 
+// Set when the shape's vertices are packed (PackedVertex in shapes/shape.h): positions
+// arrive at twice their size, and normals octahedral-encoded in normal.xy
+uniform bool packedVertices;
+
+vec3 octahedralDecode(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
 out vec3 worldSpacePosition;
 out vec3 worldSpaceNormal;
 out vec4 materialAmbient;
@@ -27,18 +38,26 @@ out float materialShininess;
 
 void main() {
     
-    mat4 model = mat4(instanceModel0, instanceModel1, instanceModel2, instanceModel3);
+    int shape = int(instanceShape);
+    mat4 model = mat4(texelFetch(shapeModels, shape * 4),
+                      texelFetch(shapeModels, shape * 4 + 1),
+                      texelFetch(shapeModels, shape * 4 + 2),
+                      texelFetch(shapeModels, shape * 4 + 3));
     mat4 invModel = transpose(inverse(model));
 
-    vec4 worldPosition = model * vec4(position, 1.0f);
+    vec3 objectPosition = packedVertices ? position * 0.5 : position;
+    vec3 objectNormal = packedVertices ? octahedralDecode(normal.xy) : normal;
+
+    vec4 worldPosition = model * vec4(objectPosition, 1.0f);
     worldSpacePosition = worldPosition.xyz;
 
-    worldSpaceNormal = vec3(invModel * vec4(normal, 0.0));
+    worldSpaceNormal = vec3(invModel * vec4(objectNormal, 0.0));
 
-    materialAmbient = instanceAmbient;
-    materialDiffuse = instanceDiffuse;
-    materialSpecular = instanceSpecular;
-    materialShininess = instanceShininess;
+    int material = int(texelFetch(shapeMaterials, shape).x) * 4;
+    materialAmbient = texelFetch(materials, material);
+    materialDiffuse = texelFetch(materials, material + 1);
+    materialSpecular = texelFetch(materials, material + 2);
+    materialShininess = texelFetch(materials, material + 3).x;
 
     gl_Position = proj * view * worldPosition;
 
@@ -7,6 +7,11 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 
+// Set when the shape's vertices are packed (PackedVertex in shapes/shape.h): positions
+// arrive at twice their size. Only positions are needed here.
+uniform bool packedVertices;
+
 void main() {
-    gl_Position = proj * view * model * vec4(position, 1.0);
+    vec3 objectPosition = packedVertices ? position * 0.5 : position;
+    gl_Position = proj * view * model * vec4(objectPosition, 1.0);
 }
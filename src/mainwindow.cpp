@@ -39,6 +39,12 @@ void MainWindow::initialize() {
     QLabel *ec_label = new QLabel(); // Extra Credit label
     ec_label->setText("Extra Credit");
     ec_label->setFont(font);
+    QLabel *loading_label = new QLabel(); // Scene Loading label
+    loading_label->setText("Scene Loading");
+    loading_label->setFont(font);
+    QLabel *stats_label = new QLabel(); // Statistics label
+    stats_label->setText("Statistics");
+    stats_label->setFont(font);
     QLabel *param1_label = new QLabel(); // Parameter 1 label
     param1_label->setText("Parameter 1:");
     QLabel *param2_label = new QLabel(); // Parameter 2 label
@@ -47,6 +53,8 @@ void MainWindow::initialize() {
     near_label->setText("Near Plane:");
     QLabel *far_label = new QLabel(); // Far plane label
     far_label->setText("Far Plane:");
+    QLabel *meshLod_label = new QLabel(); // Mesh levels of detail label
+    meshLod_label->setText("Mesh Levels, Ratio:");
 
 
     // From old Project 6
@@ -163,6 +171,75 @@ void MainWindow::initialize() {
     ec4->setText(QStringLiteral("Extra Credit 4"));
     ec4->setChecked(false);
 
+    shapeLod = new QCheckBox();
+    shapeLod->setText(QStringLiteral("Level of Detail"));
+    shapeLod->setChecked(settings.shapeLod);
+
+    // Levels built for each mesh, and the share of triangles each keeps from the one before
+    QGroupBox *meshLodLayout = new QGroupBox();
+    QHBoxLayout *lmeshLod = new QHBoxLayout();
+
+    meshLodLevels = new QSpinBox();
+    meshLodLevels->setMinimum(1);
+    meshLodLevels->setMaximum(8);
+    meshLodLevels->setSingleStep(1);
+    meshLodLevels->setValue(settings.meshLodLevels);
+
+    meshLodRatio = new QDoubleSpinBox();
+    meshLodRatio->setMinimum(0.1f);
+    meshLodRatio->setMaximum(0.9f);
+    meshLodRatio->setSingleStep(0.05f);
+    meshLodRatio->setValue(settings.meshLodRatio);
+
+    lmeshLod->addWidget(meshLodLevels);
+    lmeshLod->addWidget(meshLodRatio);
+    meshLodLayout->setLayout(lmeshLod);
+
+    meshletCulling = new QCheckBox();
+    meshletCulling->setText(QStringLiteral("Meshlet Culling"));
+    meshletCulling->setChecked(settings.meshletCulling);
+
+    multiDrawIndirect = new QCheckBox();
+    multiDrawIndirect->setText(QStringLiteral("Multi-Draw Indirect"));
+    multiDrawIndirect->setChecked(settings.multiDrawIndirect);
+
+    packedVertices = new QCheckBox();
+    packedVertices->setText(QStringLiteral("Packed Vertices"));
+    packedVertices->setChecked(settings.packedVertices);
+
+    // Scene Loading:
+    sceneCache = new QCheckBox();
+    sceneCache->setText(QStringLiteral("Scene and Mesh Cache"));
+    sceneCache->setChecked(settings.useSceneCache);
+
+    streamingReader = new QCheckBox();
+    streamingReader->setText(QStringLiteral("Streaming JSON Reader"));
+    streamingReader->setChecked(settings.streamingSceneReader);
+
+    parallelFlattening = new QCheckBox();
+    parallelFlattening->setText(QStringLiteral("Parallel Flattening"));
+    parallelFlattening->setChecked(settings.parallelFlattening);
+
+    watchSceneFile = new QCheckBox();
+    watchSceneFile->setText(QStringLiteral("Hot Reload Scene File"));
+    watchSceneFile->setChecked(settings.watchSceneFile);
+
+    streamChunks = new QCheckBox();
+    streamChunks->setText(QStringLiteral("Stream Chunks"));
+    streamChunks->setChecked(settings.streamChunks);
+
+    // Only shown while a scene is loading in the background
+    loadProgress = new QProgressBar();
+    loadProgress->setRange(0, 100);
+    loadProgress->setVisible(false);
+    loadProgressTimer = new QTimer(this);
+    loadProgressTimer->setInterval(50);
+
+    // Statistics: the counters change nearly every frame, so they are read once a second
+    frameStats = new QLabel();
+    frameStatsTimer = new QTimer(this);
+    frameStatsTimer->setInterval(1000);
+
     vLayout->addWidget(uploadFile);
     vLayout->addWidget(saveImage);
     vLayout->addWidget(tesselation_label);
@@ -170,6 +247,12 @@ void MainWindow::initialize() {
     vLayout->addWidget(p1Layout);
     vLayout->addWidget(param2_label);
     vLayout->addWidget(p2Layout);
+    vLayout->addWidget(shapeLod);
+    vLayout->addWidget(meshLod_label);
+    vLayout->addWidget(meshLodLayout);
+    vLayout->addWidget(meshletCulling);
+    vLayout->addWidget(multiDrawIndirect);
+    vLayout->addWidget(packedVertices);
     vLayout->addWidget(camera_label);
     vLayout->addWidget(near_label);
     vLayout->addWidget(nearLayout);
@@ -188,6 +271,19 @@ void MainWindow::initialize() {
     vLayout->addWidget(ec3);
     vLayout->addWidget(ec4);
 
+    // Scene Loading:
+    vLayout->addWidget(loading_label);
+    vLayout->addWidget(sceneCache);
+    vLayout->addWidget(streamingReader);
+    vLayout->addWidget(parallelFlattening);
+    vLayout->addWidget(watchSceneFile);
+    vLayout->addWidget(streamChunks);
+    vLayout->addWidget(loadProgress);
+
+    // Statistics:
+    vLayout->addWidget(stats_label);
+    vLayout->addWidget(frameStats);
+
     connectUIElements();
 
     // Set default values of 5 for tesselation parameters
@@ -212,9 +308,16 @@ void MainWindow::connectUIElements() {
     connectSaveImage();
     connectParam1();
     connectParam2();
+    connectShapeLod();
+    connectMeshLod();
+    connectMeshletCulling();
+    connectMultiDrawIndirect();
+    connectPackedVertices();
     connectNear();
     connectFar();
     connectExtraCredit();
+    connectSceneLoading();
+    connectFrameStats();
 }
 
 
@@ -246,6 +349,29 @@ void MainWindow::connectParam2() {
             this, &MainWindow::onValChangeP2);
 }
 
+void MainWindow::connectShapeLod() {
+    connect(shapeLod, &QCheckBox::clicked, this, &MainWindow::onShapeLod);
+}
+
+void MainWindow::connectMeshLod() {
+    connect(meshLodLevels, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &MainWindow::onMeshLodLevels);
+    connect(meshLodRatio, static_cast<void(QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged),
+            this, &MainWindow::onMeshLodRatio);
+}
+
+void MainWindow::connectMeshletCulling() {
+    connect(meshletCulling, &QCheckBox::clicked, this, &MainWindow::onMeshletCulling);
+}
+
+void MainWindow::connectMultiDrawIndirect() {
+    connect(multiDrawIndirect, &QCheckBox::clicked, this, &MainWindow::onMultiDrawIndirect);
+}
+
+void MainWindow::connectPackedVertices() {
+    connect(packedVertices, &QCheckBox::clicked, this, &MainWindow::onPackedVertices);
+}
+
 void MainWindow::connectNear() {
     connect(nearSlider, &QSlider::valueChanged, this, &MainWindow::onValChangeNearSlider);
     connect(nearBox, static_cast<void(QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged),
@@ -265,6 +391,20 @@ void MainWindow::connectExtraCredit() {
     connect(ec4, &QCheckBox::clicked, this, &MainWindow::onExtraCredit4);
 }
 
+void MainWindow::connectSceneLoading() {
+    connect(sceneCache, &QCheckBox::clicked, this, &MainWindow::onSceneCache);
+    connect(streamingReader, &QCheckBox::clicked, this, &MainWindow::onStreamingReader);
+    connect(parallelFlattening, &QCheckBox::clicked, this, &MainWindow::onParallelFlattening);
+    connect(watchSceneFile, &QCheckBox::clicked, this, &MainWindow::onWatchSceneFile);
+    connect(streamChunks, &QCheckBox::clicked, this, &MainWindow::onStreamChunks);
+    connect(loadProgressTimer, &QTimer::timeout, this, &MainWindow::onLoadProgress);
+}
+
+void MainWindow::connectFrameStats() {
+    connect(frameStatsTimer, &QTimer::timeout, this, &MainWindow::onFrameStats);
+    frameStatsTimer->start();
+}
+
 // From old Project 6
 // void MainWindow::onPerPixelFilter() {
 //     settings.perPixelFilter = !settings.perPixelFilter;
@@ -295,6 +435,7 @@ void MainWindow::onUploadFile() {
     std::cout << "Loaded scenefile: \"" << configFilePath.toStdString() << "\"." << std::endl;
 
     realtime->sceneChanged();
+    loadProgressTimer->start();
 }
 
 void MainWindow::onSaveImage() {
@@ -332,6 +473,41 @@ void MainWindow::onValChangeP2(int newValue) {
     realtime->settingsChanged();
 }
 
+// Off draws every instance at the full tessellation
+void MainWindow::onShapeLod() {
+    settings.shapeLod = !settings.shapeLod;
+    realtime->settingsChanged();
+}
+
+// Meshes are rebuilt with the new chain, or read from a cache built with it
+void MainWindow::onMeshLodLevels(int newValue) {
+    settings.meshLodLevels = newValue;
+    realtime->settingsChanged();
+}
+
+void MainWindow::onMeshLodRatio(double newValue) {
+    settings.meshLodRatio = newValue;
+    realtime->settingsChanged();
+}
+
+// Off draws every mesh instance whole, however little of it is visible
+void MainWindow::onMeshletCulling() {
+    settings.meshletCulling = !settings.meshletCulling;
+    realtime->settingsChanged();
+}
+
+// Off issues a call per batch even where the context could submit them all in one
+void MainWindow::onMultiDrawIndirect() {
+    settings.multiDrawIndirect = !settings.multiDrawIndirect;
+    realtime->settingsChanged();
+}
+
+// Off uploads the shapes as plain floats, to compare vertex bandwidth against
+void MainWindow::onPackedVertices() {
+    settings.packedVertices = !settings.packedVertices;
+    realtime->settingsChanged();
+}
+
 void MainWindow::onValChangeNearSlider(int newValue) {
     //nearSlider->setValue(newValue);
     nearBox->setValue(newValue/100.f);
@@ -381,3 +557,46 @@ void MainWindow::onExtraCredit4() {
     settings.extraCredit4 = !settings.extraCredit4;
     realtime->settingsChanged();
 }
+
+// Scene Loading:
+// These only take effect the next time a scene file is loaded
+
+void MainWindow::onSceneCache() {
+    settings.useSceneCache = !settings.useSceneCache;
+}
+
+void MainWindow::onStreamingReader() {
+    settings.streamingSceneReader = !settings.streamingSceneReader;
+}
+
+void MainWindow::onParallelFlattening() {
+    settings.parallelFlattening = !settings.parallelFlattening;
+}
+
+// These take effect right away
+void MainWindow::onWatchSceneFile() {
+    settings.watchSceneFile = !settings.watchSceneFile;
+    realtime->settingsChanged();
+}
+
+// Off loads every chunk regardless of distance or budget
+void MainWindow::onStreamChunks() {
+    settings.streamChunks = !settings.streamChunks;
+    realtime->settingsChanged();
+}
+
+// Polled while a scene loads; stops itself once the new scene has been swapped in
+void MainWindow::onLoadProgress() {
+    if (!realtime->isLoadingScene()) {
+        loadProgress->setVisible(false);
+        loadProgressTimer->stop();
+        return;
+    }
+    loadProgress->setValue(static_cast<int>(realtime->sceneLoadProgress() * 100));
+    loadProgress->setVisible(true);
+}
+
+// Polled once a second for as long as the window is open
+void MainWindow::onFrameStats() {
+    frameStats->setText(QString::fromStdString(realtime->frameStats().text()));
+}
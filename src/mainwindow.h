@@ -2,10 +2,13 @@
 
 #include <QMainWindow>
 #include <QCheckBox>
+#include <QLabel>
 #include <QSlider>
 #include <QSpinBox>
 #include <QDoubleSpinBox>
 #include <QPushButton>
+#include <QProgressBar>
+#include <QTimer>
 #include "realtime.h"
 #include "utils/aspectratiowidget/aspectratiowidget.hpp"
 
@@ -21,6 +24,11 @@ private:
     void connectUIElements();
     void connectParam1();
     void connectParam2();
+    void connectShapeLod();
+    void connectMeshLod();
+    void connectMeshletCulling();
+    void connectMultiDrawIndirect();
+    void connectPackedVertices();
     void connectNear();
     void connectFar();
 
@@ -31,6 +39,8 @@ private:
     void connectUploadFile();
     void connectSaveImage();
     void connectExtraCredit();
+    void connectSceneLoading();
+    void connectFrameStats();
 
     Realtime *realtime;
     AspectRatioWidget *aspectRatioWidget;
@@ -45,6 +55,12 @@ private:
     QSlider *p2Slider;
     QSpinBox *p1Box;
     QSpinBox *p2Box;
+    QCheckBox *shapeLod;
+    QSpinBox *meshLodLevels;
+    QDoubleSpinBox *meshLodRatio;
+    QCheckBox *meshletCulling;
+    QCheckBox *multiDrawIndirect;
+    QCheckBox *packedVertices;
     QSlider *nearSlider;
     QSlider *farSlider;
     QDoubleSpinBox *nearBox;
@@ -56,6 +72,19 @@ private:
     QCheckBox *ec3;
     QCheckBox *ec4;
 
+    // Scene Loading:
+    QCheckBox *sceneCache;
+    QCheckBox *streamingReader;
+    QCheckBox *parallelFlattening;
+    QCheckBox *watchSceneFile;
+    QCheckBox *streamChunks;
+    QProgressBar *loadProgress;
+    QTimer *loadProgressTimer;
+
+    // Statistics:
+    QLabel *frameStats;
+    QTimer *frameStatsTimer;
+
 private slots:
     // From old Project 6
     // void onPerPixelFilter();
@@ -65,6 +94,12 @@ private slots:
     void onSaveImage();
     void onValChangeP1(int newValue);
     void onValChangeP2(int newValue);
+    void onShapeLod();
+    void onMeshLodLevels(int newValue);
+    void onMeshLodRatio(double newValue);
+    void onMeshletCulling();
+    void onMultiDrawIndirect();
+    void onPackedVertices();
     void onValChangeNearSlider(int newValue);
     void onValChangeFarSlider(int newValue);
     void onValChangeNearBox(double newValue);
@@ -75,4 +110,15 @@ private slots:
     void onExtraCredit2();
     void onExtraCredit3();
     void onExtraCredit4();
+
+    // Scene Loading:
+    void onSceneCache();
+    void onStreamingReader();
+    void onParallelFlattening();
+    void onWatchSceneFile();
+    void onStreamChunks();
+    void onLoadProgress();
+
+    // Statistics:
+    void onFrameStats();
 };
@@ -4,17 +4,17 @@
 #include <QMouseEvent>
 #include <QKeyEvent>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
 #include "glm/ext/matrix_clip_space.hpp"
 #include "glm/ext/matrix_transform.hpp"
+#include "glm/gtc/constants.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "settings.h"
 
 #include "utils/shaderloader.h"
 
-#include "shapes/cube.h"
-#include "shapes/sphere.h"
-#include "shapes/cone.h"
-#include "shapes/cylinder.h"
 
 // ================== Rendering the Scene!
 
@@ -41,15 +41,50 @@ Realtime::Realtime(QWidget *parent)
     m_global.kd = 0.5f;
     m_global.ks = 0.5f;
 
+    // Hot reload: re-parse the scene a moment after its file changes on disk. A chunk
+    // file is only re-parsed itself.
+    m_sceneReloadTimer.setSingleShot(true);
+    m_sceneReloadTimer.setInterval(100);
+    connect(&m_sceneWatcher, &QFileSystemWatcher::fileChanged, this, [this](const QString &path) {
+        std::string file = path.toStdString();
+        if (file == settings.sceneFilePath) {
+            m_sceneFileChanged = true;
+        } else if (std::find(m_changedChunks.begin(), m_changedChunks.end(), file) == m_changedChunks.end()) {
+            m_changedChunks.push_back(file);
+        }
+        m_sceneReloadTimer.start();
+    });
+    connect(&m_sceneReloadTimer, &QTimer::timeout, this, [this]() {
+        for (const std::string &file : m_changedChunks) {
+            std::cout << "Reloading chunk: " << file << std::endl;
+            m_chunkStreamer.reload(file);
+        }
+        m_changedChunks.clear();
 
+        if (m_sceneFileChanged) {
+            m_sceneFileChanged = false;
+            startSceneLoad(true);
+        } else {
+            updateSceneWatcher();
+        }
+    });
 
 }
 
 void Realtime::finish() {
     killTimer(m_timer);
+
+    // The loader thread writes to m_loadProgress, so it must not outlive us
+    if (m_loadingScene.valid()) {
+        m_loadingScene.wait();
+    }
     this->makeCurrent();
 
     // Students: anything requiring OpenGL calls when the program exits should be done here
+    m_geometryCache.clear();
+    m_shapeTable.release();
+    m_primitiveDraws.release();
+    m_meshDraws.release();
 
     this->doneCurrent();
 }
@@ -69,6 +104,10 @@ void Realtime::initializeGL() {
     }
     std::cout << "Initialized GL: Version " << glewGetString(GLEW_VERSION) << std::endl;
 
+    // Otherwise the instanced batches are drawn one call each
+    m_multiDrawIndirect = DrawList::multiDrawIndirectSupported();
+    std::cout << "Multi-draw indirect: " << (m_multiDrawIndirect ? "supported" : "not supported") << std::endl;
+
     // Allows OpenGL to draw objects appropriately on top of one another
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
@@ -340,151 +379,120 @@ void Realtime::initializeShapeGeometry() {
     int param1 = settings.shapeParameter1;
     int param2 = settings.shapeParameter2;
 
-    // Initializing Sphere VBOs & VAOs --
-    std::vector<float> sphere = Sphere::generateSphereData(param1, param2);
+    VertexFormat format = settings.packedVertices ? VertexFormat::Packed : VertexFormat::Float;
 
-    glGenBuffers(1, &m_sphereGeometry.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_sphereGeometry.vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 sphere.size() * sizeof(GLfloat),
-                 sphere.data(),
-                 GL_STATIC_DRAW);
-
-    glGenVertexArrays(1, &m_sphereGeometry.vao);
-    glBindVertexArray(m_sphereGeometry.vao);
-
-    // Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
-                          6 * sizeof(GLfloat),
-                          (void*)0);
-
-    // Normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
-                          6 * sizeof(GLfloat),
-                          (void*)(3 * sizeof(GLfloat)));
-
-    // Setup instance buffers (will be filled during rendering)
-    glGenBuffers(1, &m_sphereGeometry.instanceVBO);
-    glGenBuffers(1, &m_sphereGeometry.materialVBO);
-
-    m_sphereGeometry.verticies = sphere.size() / 6;
-
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-
-    // Initializing Cube VBOs & VAOs  --
-    std::vector<float> cube = Cube::generateCubeData(param1);
-
-    glGenBuffers(1, &m_cubeGeometry.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_cubeGeometry.vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 cube.size() * sizeof(GLfloat),
-                 cube.data(),
-                 GL_STATIC_DRAW);
-
-    glGenVertexArrays(1, &m_cubeGeometry.vao);
-    glBindVertexArray(m_cubeGeometry.vao);
+    for (int lod = 0; lod < GeometryCache::kLodLevels; lod++) {
+        m_sphereGeometry[lod] = m_geometryCache.get(PrimitiveType::PRIMITIVE_SPHERE, param1, param2, lod, format);
+        m_cubeGeometry[lod] = m_geometryCache.get(PrimitiveType::PRIMITIVE_CUBE, param1, param2, lod, format);
+        m_cylinderGeometry[lod] = m_geometryCache.get(PrimitiveType::PRIMITIVE_CYLINDER, param1, param2, lod, format);
+        m_coneGeometry[lod] = m_geometryCache.get(PrimitiveType::PRIMITIVE_CONE, param1, param2, lod, format);
+    }
 
-    // Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
-                          6 * sizeof(GLfloat),
-                          (void*)0);
+    currParam1 = param1;
+    currParam2 = param2;
+    currVertexFormat = format;
 
-    // Normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
-                          6 * sizeof(GLfloat),
-                          (void*)(3 * sizeof(GLfloat)));
+    std::cout << "Shape geometry: " << (format == VertexFormat::Packed ? "packed" : "float")
+              << " vertices, " << m_geometryCache.residentBytes() / (1024 * 1024) << " MB resident in "
+              << m_geometryCache.arenaBytes() / (1024 * 1024) << " MB of buffers" << std::endl;
 
-    // Setup instance buffers
-    glGenBuffers(1, &m_cubeGeometry.instanceVBO);
-    glGenBuffers(1, &m_cubeGeometry.materialVBO);
+}
 
-    // Vertex Count
-    m_cubeGeometry.verticies = cube.size() / 6;
+// Looks up the geometry of every mesh primitive in m_renderData, and releases the meshes
+// no longer used. Files not yet resident start loading in the background; their
+// primitives are skipped until paintGL has collected them and called this again.
+void Realtime::uploadMeshes() {
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_geometryCache.setMeshLodOptions({settings.meshLodLevels, settings.meshLodRatio});
 
+    m_meshGeometry.clear();
+    m_primitiveMeshes.assign(m_renderData.primitives.size(), -1);
+    m_meshLodLevels = 1;
 
-    // Initializing Cylinder VBOs & VAOs --
-    std::vector<float> cylinder = Cylinder::generateCylinderData(param1, param2);
+    std::unordered_set<std::string> used;
+    std::unordered_map<GLuint, int> meshByFirstIndex;  // meshes all share the float arena
 
-    glGenBuffers(1, &m_cylinderGeometry.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_cylinderGeometry.vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 cylinder.size() * sizeof(GLfloat),
-                 cylinder.data(),
-                 GL_STATIC_DRAW);
+    for (size_t i = 0; i < m_renderData.primitives.size(); i++) {
 
-    glGenVertexArrays(1, &m_cylinderGeometry.vao);
-    glBindVertexArray(m_cylinderGeometry.vao);
-
-    // Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
-                          6 * sizeof(GLfloat),
-                          (void*)0);
+        const ScenePrimitive& primitive = m_renderData.primitives[i];
+        if (primitive.type != PrimitiveType::PRIMITIVE_MESH) {
+            continue;
+        }
 
-    // Normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
-                          6 * sizeof(GLfloat),
-                          (void*)(3 * sizeof(GLfloat)));
+        used.insert(primitive.meshfile);
+        const ShapeGeometry& geometry = m_geometryCache.getMesh(primitive.meshfile, settings.useSceneCache);
+        if (geometry.vao == 0) {
+            continue;
+        }
 
-    // Setup instance buffers
-    glGenBuffers(1, &m_cylinderGeometry.instanceVBO);
-    glGenBuffers(1, &m_cylinderGeometry.materialVBO);
+        auto [found, inserted] = meshByFirstIndex.emplace(geometry.firstIndex, m_meshGeometry.size());
+        if (inserted) {
+            m_meshGeometry.push_back(geometry);
+            m_meshLodLevels = std::max<int>(m_meshLodLevels, geometry.lods.size());
+        }
+        m_primitiveMeshes[i] = found->second;
 
-    // Vertex Count
-    m_cylinderGeometry.verticies = cylinder.size() / 6;
+    }
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_geometryCache.releaseMeshes(used);
 
+}
 
-    // Initializing Cone VBOs & VAOs --
-    std::vector<float> cone = Cone::generateConeData(param1, param2);
+// Packs m_renderData.materials into the texture buffer the phong shader indexes with
+// each instance's material index.
+void Realtime::uploadMaterials() {
 
-    glGenBuffers(1, &m_coneGeometry.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_coneGeometry.vbo);
-    glBufferData(GL_ARRAY_BUFFER,
-                 cone.size() * sizeof(GLfloat),
-                 cone.data(),
-                 GL_STATIC_DRAW);
+    std::vector<glm::vec4> materialData;
+    materialData.reserve(m_renderData.materials.size() * 4);
 
-    glGenVertexArrays(1, &m_coneGeometry.vao);
-    glBindVertexArray(m_coneGeometry.vao);
+    for (const SceneMaterial& material : m_renderData.materials) {
+        materialData.push_back(material.cAmbient);
+        materialData.push_back(material.cDiffuse);
+        materialData.push_back(material.cSpecular);
+        materialData.push_back(glm::vec4(material.shininess, 0.0f, 0.0f, 0.0f));
+    }
 
-    // Positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
-                          6 * sizeof(float),
-                          (void*)0);
+    // Keeps the texture valid for empty scenes
+    if (materialData.empty()) {
+        materialData.resize(4, glm::vec4(0.0f));
+    }
 
-    // Normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
-                          6 * sizeof(float),
-                          (void*)(3 * sizeof(float)));
+    if (m_material_buffer == 0) {
+        glGenBuffers(1, &m_material_buffer);
+        glGenTextures(1, &m_material_texture);
+    }
 
-    // Setup instance buffers
-    glGenBuffers(1, &m_coneGeometry.instanceVBO);
-    glGenBuffers(1, &m_coneGeometry.materialVBO);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_material_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, materialData.size() * sizeof(glm::vec4),
+                 materialData.data(), GL_STATIC_DRAW);
 
-    m_coneGeometry.verticies = cone.size() / 6;
+    glBindTexture(GL_TEXTURE_BUFFER, m_material_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_material_buffer);
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
 }
 
 void Realtime::paintGL() {
 
+    // Swap in a scene that finished loading in the background
+    if (sceneLoadFinished()) {
+        swapInLoadedScene();
+    }
+    updateChunks();
+    m_geometryCache.collectOptimized();
+    if (m_geometryCache.collectMeshes()) {
+        uploadMeshes();
+    }
+
+    // Evictions leave the shape buffers' space unused until they are compacted, which
+    // moves every shape, so their geometry is looked up again
+    if (m_geometryCache.compact()) {
+        initializeShapeGeometry();
+        uploadMeshes();
+    }
+
     int width  = size().width() * m_devicePixelRatio;
     int height = size().height() * m_devicePixelRatio;
 
@@ -607,6 +615,8 @@ void Realtime::render() {
                        1, GL_FALSE, &m_view[0][0]);
     glUniformMatrix4fv(glGetUniformLocation(m_phong_shader, "proj"),
                        1, GL_FALSE, &m_projection[0][0]);
+    glUniform1i(glGetUniformLocation(m_phong_shader, "packedVertices"),
+                currVertexFormat == VertexFormat::Packed);
 
     glm::vec3 camPosition = m_camera.getInverseViewMatrix()[3];
     glUniform3fv(glGetUniformLocation(m_phong_shader, "cameraPosition"),
@@ -618,6 +628,20 @@ void Realtime::render() {
 
     passLightsToShader(m_phong_shader);
 
+    // Only the shapes that changed since the last frame are sent
+    m_stats.uploadedBytes = m_shapeTable.upload();
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, m_shapeTable.modelTexture());
+    glUniform1i(glGetUniformLocation(m_phong_shader, "shapeModels"), 1);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_BUFFER, m_shapeTable.materialTexture());
+    glUniform1i(glGetUniformLocation(m_phong_shader, "shapeMaterials"), 2);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, m_material_texture);
+    glUniform1i(glGetUniformLocation(m_phong_shader, "materials"), 0);
+
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
 
@@ -628,6 +652,10 @@ void Realtime::render() {
         renderShapesNonInstanced();
     }
 
+    for (int unit = 2; unit >= 0; unit--) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
     glUseProgram(0);
 
 }
@@ -658,6 +686,12 @@ void Realtime::copy(GLuint text) {
 
 }
 
+// Draws a shape's full level of detail. Its arena's vertex array must be bound.
+static void drawElements(const ShapeGeometry& geometry) {
+    glDrawElementsBaseVertex(GL_TRIANGLES, geometry.indices, GL_UNSIGNED_INT,
+                             (void*)(geometry.firstIndex * sizeof(GLuint)), geometry.baseVertex);
+}
+
 // Renders all objects as black, and all light sources as white through
 // the m_occlusion_shader. Saves to m_occlusion_fbo to later blend with crepuscular rays.
 void Realtime::renderOcclusion() {
@@ -680,6 +714,8 @@ void Realtime::renderOcclusion() {
                        1, GL_FALSE, &m_view[0][0]);
     glUniformMatrix4fv(glGetUniformLocation(m_occlusion_shader, "proj"),
                        1, GL_FALSE, &m_projection[0][0]);
+    GLint packedLoc = glGetUniformLocation(m_occlusion_shader, "packedVertices");
+    glUniform1i(packedLoc, currVertexFormat == VertexFormat::Packed);
 
     // // Render all geometry as black .
     GLint colorLoc = glGetUniformLocation(m_occlusion_shader, "occlusionColor");
@@ -689,37 +725,42 @@ void Realtime::renderOcclusion() {
         glUniformMatrix4fv(glGetUniformLocation(m_occlusion_shader, "model"),
                            1, GL_FALSE, &shape.ctm[0][0]);
 
-        GLuint vao;
-        int verticies;
+        const ShapeGeometry* geometry;
 
-        switch(shape.primitive.type) {
+        switch(m_renderData.primitiveOf(shape).type) {
         case PrimitiveType::PRIMITIVE_CUBE:
-            vao = m_cubeGeometry.vao;
-            verticies = m_cubeGeometry.verticies;
+            geometry = &m_cubeGeometry[0];
             break;
         case PrimitiveType::PRIMITIVE_SPHERE:
-            vao = m_sphereGeometry.vao;
-            verticies = m_sphereGeometry.verticies;
+            geometry = &m_sphereGeometry[0];
             break;
         case PrimitiveType::PRIMITIVE_CONE:
-            vao = m_coneGeometry.vao;
-            verticies = m_coneGeometry.verticies;
+            geometry = &m_coneGeometry[0];
             break;
         case PrimitiveType::PRIMITIVE_CYLINDER:
-            vao = m_cylinderGeometry.vao;
-            verticies = m_cylinderGeometry.verticies;
+            geometry = &m_cylinderGeometry[0];
             break;
         case PrimitiveType::PRIMITIVE_MESH:
-            continue;
+            if (m_primitiveMeshes[shape.primitive] < 0) {
+                continue;
+            }
+            geometry = &m_meshGeometry[m_primitiveMeshes[shape.primitive]];
+            break;
         default:
             continue;
         }
 
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, verticies);
-        glBindVertexArray(0);
+        // Meshes are always stored as floats
+        glUniform1i(packedLoc, currVertexFormat == VertexFormat::Packed
+                                   && m_renderData.primitiveOf(shape).type != PrimitiveType::PRIMITIVE_MESH);
+
+        // Shapes of one vertex format share a vertex array, so this only switches between formats
+        glBindVertexArray(geometry->vao);
+        drawElements(*geometry);
     }
+    glBindVertexArray(0);
 
+    glUniform1i(packedLoc, currVertexFormat == VertexFormat::Packed);
     glUniform4f(colorLoc, 1.0f, 1.0f, 1.0f, 1.0f);
 
     for (const auto& light : m_renderData.lights) {
@@ -750,8 +791,8 @@ void Realtime::renderOcclusion() {
                            1, GL_FALSE, &lightModel[0][0]);
 
         // Renders light as a sphere.
-        glBindVertexArray(m_sphereGeometry.vao);
-        glDrawArrays(GL_TRIANGLES, 0, m_sphereGeometry.verticies);
+        glBindVertexArray(m_sphereGeometry[0].vao);
+        drawElements(m_sphereGeometry[0]);
         glBindVertexArray(0);
 
     }
@@ -1062,7 +1103,7 @@ void Realtime::drawShape(const RenderShapeData& shape, GLuint shader) {
 
     if (ambientLoc != -1 || diffuseLoc != -1 || specularLoc != -1 || shininessLoc != -1) {
 
-        auto info = shape.primitive.material;
+        auto info = m_renderData.primitiveOf(shape).material;
 
         glm::vec4 ambient = info.cAmbient;
         glm::vec4 diffuse = info.cDiffuse;
@@ -1075,200 +1116,385 @@ void Realtime::drawShape(const RenderShapeData& shape, GLuint shader) {
 
     }
 
-    GLuint vao;
-    int verticies;
+    const ShapeGeometry* geometry = nullptr;
 
-    switch(shape.primitive.type) {
+    switch(m_renderData.primitiveOf(shape).type) {
 
     case PrimitiveType::PRIMITIVE_CUBE:
-        vao = m_cubeGeometry.vao;
-        verticies = m_cubeGeometry.verticies;
+        geometry = &m_cubeGeometry[0];
         break;
 
     case PrimitiveType::PRIMITIVE_SPHERE:
-        vao = m_sphereGeometry.vao;
-        verticies = m_sphereGeometry.verticies;
+        geometry = &m_sphereGeometry[0];
         break;
 
     case PrimitiveType::PRIMITIVE_CONE:
-        vao = m_coneGeometry.vao;
-        verticies = m_coneGeometry.verticies;
+        geometry = &m_coneGeometry[0];
         break;
 
     case PrimitiveType::PRIMITIVE_CYLINDER:
-        vao = m_cylinderGeometry.vao;
-        verticies = m_cylinderGeometry.verticies;
+        geometry = &m_cylinderGeometry[0];
         break;
 
     case PrimitiveType::PRIMITIVE_MESH:
-        return;
+        if (m_primitiveMeshes[shape.primitive] < 0) {
+            return;
+        }
+        geometry = &m_meshGeometry[m_primitiveMeshes[shape.primitive]];
         break;
 
     }
 
-    glBindVertexArray(vao);
-    glDrawArrays(GL_TRIANGLES, 0, verticies);
+    if (!geometry) {
+        return;
+    }
+
+    // Meshes are always stored as floats
+    glUniform1i(glGetUniformLocation(shader, "packedVertices"),
+                currVertexFormat == VertexFormat::Packed
+                    && m_renderData.primitiveOf(shape).type != PrimitiveType::PRIMITIVE_MESH);
+
+    glBindVertexArray(geometry->vao);
+    drawElements(*geometry);
     glBindVertexArray(0);
 
 }
 
+// Silhouette edges of a primitive are kept about this long on screen
+static const float kLodSegmentPixels = 4.f;
+
+// A shape keeps its level until it is this far past either boundary, in halvings of its
+// tessellation, so shapes near a boundary do not pop back and forth between levels
+static const float kLodHysteresis = 0.25f;
+
+// Radius of the sphere bounding each unit primitive
+static float boundingRadius(PrimitiveType type) {
+
+    switch (type) {
+    case PrimitiveType::PRIMITIVE_CUBE:
+        return 0.8660254f;
+    case PrimitiveType::PRIMITIVE_SPHERE:
+        return 0.5f;
+    default:
+        return 0.7071068f;
+    }
+
+}
+
+// Largest factor a shape's transform stretches any direction by
+static float maxScale(const glm::mat4& ctm) {
+    return glm::max(glm::length(glm::vec3(ctm[0])),
+                    glm::max(glm::length(glm::vec3(ctm[1])), glm::length(glm::vec3(ctm[2]))));
+}
+
+// The coarsest level of detail whose silhouette edges are no longer than
+// kLodSegmentPixels at the shape's projected radius. The full tessellation is taken to
+// have segments edges around the silhouette.
+static int selectLod(const RenderShapeData& shape, PrimitiveType type,
+                     const glm::vec3& camPosition, float pixelsPerUnit,
+                     int segments, int current) {
+
+    float scale = maxScale(shape.ctm);
+    float radius = boundingRadius(type) * scale;
+    float distance = glm::length(glm::vec3(shape.ctm[3]) - camPosition);
+
+    // The camera is inside the shape's bounds
+    if (distance <= radius) {
+        return 0;
+    }
+
+    float pixelRadius = radius / distance * pixelsPerUnit;
+    float needed = 2.f * glm::pi<float>() * pixelRadius / kLodSegmentPixels;
+    float level = std::log2(segments / glm::max(needed, 1e-6f));
+
+    if (level >= current - kLodHysteresis && level < current + 1 + kLodHysteresis) {
+        return current;
+    }
+    return std::clamp(int(std::floor(level)), 0, GeometryCache::kLodLevels - 1);
+
+}
+
+// A mesh's coarser levels are drawn while they stray from the full mesh by no more than
+// this on screen
+static const float kMeshLodErrorPixels = 1.f;
+
+// The coarsest level of the mesh whose error, projected at the point of its bounds
+// nearest the camera, is within kMeshLodErrorPixels
+static int selectMeshLod(const RenderShapeData& shape, const ShapeGeometry& geometry,
+                         const glm::vec3& camPosition, float pixelsPerUnit, int current) {
+
+    float scale = maxScale(shape.ctm);
+    float distance = glm::length(glm::vec3(shape.ctm[3]) - camPosition) - geometry.radius * scale;
+
+    // The camera is inside the mesh's bounds
+    if (distance <= 0.f) {
+        return 0;
+    }
+
+    int levels = geometry.lods.size();
+    auto pixels = [&](int lod) {
+        return geometry.lods[lod].error * scale / distance * pixelsPerUnit;
+    };
+
+    // Stay on the current level until an error passes the threshold by kLodHysteresis
+    if (current < levels && pixels(current) <= kMeshLodErrorPixels * (1.f + kLodHysteresis)
+        && (current + 1 == levels || pixels(current + 1) > kMeshLodErrorPixels * (1.f - kLodHysteresis))) {
+        return current;
+    }
+
+    int lod = 0;
+    while (lod + 1 < levels && pixels(lod + 1) <= kMeshLodErrorPixels) {
+        lod++;
+    }
+    return lod;
+
+}
+
 void Realtime::renderShapesInstanced() {
 
-    std::vector<const RenderShapeData*> spheres, cubes, cylinders, cones;
+    const int kLods = GeometryCache::kLodLevels;
 
-    for (const auto& shape : m_renderData.shapes) {
+    // Instances of each primitive, as shape indices, bucketed by level of detail
+    ShapeGeometry* chains[] = {m_sphereGeometry, m_cubeGeometry, m_cylinderGeometry, m_coneGeometry};
+    std::vector<GLuint> batches[4][kLods];
+
+    // Instances of each mesh file, bucketed by level of detail too
+    std::vector<std::vector<GLuint>> meshBatches(m_meshGeometry.size() * m_meshLodLevels);
 
-        switch(shape.primitive.type) {
+    glm::vec3 camPosition = m_camera.getInverseViewMatrix()[3];
+    // The camera scales view space by 1 / far before the perspective divide, so w is
+    // -z / far rather than -z, and [1][1] has to be scaled back by it
+    float pixelsPerUnit = size().height() * m_devicePixelRatio / 2.f * m_projection[1][1] / -m_projection[2][3];
+    int segments = glm::max(settings.shapeParameter1, settings.shapeParameter2);
+
+    if (m_shapesMoved || m_shapeLods.size() != m_renderData.shapes.size()) {
+        remapShapeLods();
+    }
+
+    std::vector<size_t> lodInstances(std::max(kLods, m_meshLodLevels), 0);
+    size_t trianglesDrawn = 0;
+    size_t trianglesSaved = 0;
+
+    for (size_t i = 0; i < m_renderData.shapes.size(); i++) {
+
+        const RenderShapeData& shape = m_renderData.shapes[i];
+        PrimitiveType type = m_renderData.primitiveOf(shape).type;
+
+        int batch;
+        switch(type) {
             case PrimitiveType::PRIMITIVE_SPHERE:
-                spheres.push_back(&shape);
+                batch = 0;
                 break;
 
             case PrimitiveType::PRIMITIVE_CUBE:
-                cubes.push_back(&shape);
+                batch = 1;
                 break;
 
             case PrimitiveType::PRIMITIVE_CYLINDER:
-                cylinders.push_back(&shape);
+                batch = 2;
                 break;
 
             case PrimitiveType::PRIMITIVE_CONE:
-                cones.push_back(&shape);
+                batch = 3;
                 break;
 
-            case PrimitiveType::PRIMITIVE_MESH:
-                break;
-
-        }
-    }
-
-    // Rendering batches of shapes !
-    auto renderBatch =
-        [this](const std::vector<const RenderShapeData*>& shapes, ShapeGeometry& geometry) {
+            // Meshes pick their level by screen-space error instead
+            case PrimitiveType::PRIMITIVE_MESH: {
+                int mesh = m_primitiveMeshes[shape.primitive];
+                if (mesh < 0) {
+                    continue;
+                }
+                const ShapeGeometry& geometry = m_meshGeometry[mesh];
+                int lod = 0;
+                if (settings.shapeLod) {
+                    lod = selectMeshLod(shape, geometry, camPosition, pixelsPerUnit, m_shapeLods[i]);
+                }
+                m_shapeLods[i] = lod;
+
+                meshBatches[mesh * m_meshLodLevels + lod].push_back(i);
+                lodInstances[lod]++;
+                trianglesDrawn += geometry.lods[lod].indexCount / 3;
+                trianglesSaved += (geometry.lods[0].indexCount - geometry.lods[lod].indexCount) / 3;
+                continue;
+            }
 
-        if (shapes.empty()) return;
+            default:
+                continue;
 
+        }
 
-        std::vector<glm::mat4> modelMatrices;
-        std::vector<glm::vec4> ambients, diffuses, speculars;
-        std::vector<float> shininesses;
+        int lod = 0;
+        if (settings.shapeLod) {
+            lod = selectLod(shape, type, camPosition, pixelsPerUnit, segments, m_shapeLods[i]);
+        }
+        m_shapeLods[i] = lod;
 
-        for (const auto* shape : shapes) {
+        // At low tessellations the coarser levels come out the same, so draw those
+        // instances with the finest level that shares the geometry
+        const ShapeGeometry* chain = chains[batch];
+        while (lod > 0 && chain[lod].firstIndex == chain[lod - 1].firstIndex) {
+            lod--;
+        }
 
-            modelMatrices.push_back(shape->ctm);
-            ambients.push_back(shape->primitive.material.cAmbient);
-            diffuses.push_back(shape->primitive.material.cDiffuse);
-            speculars.push_back(shape->primitive.material.cSpecular);
-            shininesses.push_back(shape->primitive.material.shininess);
+        batches[batch][lod].push_back(i);
+        lodInstances[lod]++;
+        trianglesDrawn += chain[lod].indices / 3;
+        trianglesSaved += (chain[0].indices - chain[lod].indices) / 3;
 
-        }
+    }
 
-        glBindVertexArray(geometry.vao);
+    m_stats.lodInstances = std::move(lodInstances);
+    m_stats.trianglesDrawn = trianglesDrawn;
+    m_stats.trianglesSaved = trianglesSaved;
 
-        // Upload model matrices to instance buffer
-        glBindBuffer(GL_ARRAY_BUFFER, geometry.instanceVBO);
-        glBufferData(GL_ARRAY_BUFFER, modelMatrices.size() * sizeof(glm::mat4),
-                     modelMatrices.data(), GL_DYNAMIC_DRAW);
+    bool indirect = settings.multiDrawIndirect && m_multiDrawIndirect;
+    int drawCalls = 0;
 
+    // The primitives all share the arena of the current vertex format
+    m_primitiveDraws.clear();
+    for (int batch = 0; batch < 4; batch++) {
+        for (int lod = 0; lod < kLods; lod++) {
 
-        for (int i = 0; i < 4; i++) {
+            const ShapeGeometry& geometry = chains[batch][lod];
+            if (batches[batch][lod].empty()) {
+                continue;
+            }
 
-            glEnableVertexAttribArray(2 + i);
-            glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE,
-                                sizeof(glm::mat4), (void*)(sizeof(glm::vec4) * i));
-            glVertexAttribDivisor(2 + i, 1);
+            GLuint firstInstance = m_primitiveDraws.instanceCount();
+            for (GLuint shape : batches[batch][lod]) {
+                m_primitiveDraws.addInstance(shape);
+            }
+            m_primitiveDraws.addDraw(geometry.indices, geometry.firstIndex, geometry.baseVertex,
+                                     firstInstance, batches[batch][lod].size());
 
         }
+    }
+    drawCalls += m_primitiveDraws.submit(chains[0][0].vao, indirect);
+    m_stats.uploadedBytes += m_primitiveDraws.uploadedBytes();
+
+    Frustum frustum = extractFrustum(m_projection * m_view);
+    std::vector<GLuint> counts;
+    std::vector<GLuint> firstIndices;
+    size_t meshletsVisible = 0;
+    size_t meshletsTotal = 0;
+
+    // Meshes all share the float arena. Those drawn whole are one draw per batch; culled
+    // ones are one draw per visible range of each instance.
+    m_meshDraws.clear();
+    for (size_t batch = 0; batch < meshBatches.size(); batch++) {
+
+        const ShapeGeometry& geometry = m_meshGeometry[batch / m_meshLodLevels];
+        if (meshBatches[batch].empty()) {
+            continue;
+        }
 
-        glBindBuffer(GL_ARRAY_BUFFER, geometry.materialVBO);
-
-        std::vector<float> materialData;
-        for (size_t i = 0; i < shapes.size(); i++) {
-            materialData.insert(materialData.end(), &ambients[i][0], &ambients[i][0] + 4);
-            materialData.insert(materialData.end(), &diffuses[i][0], &diffuses[i][0] + 4);
-            materialData.insert(materialData.end(), &speculars[i][0], &speculars[i][0] + 4);
-            materialData.push_back(shininesses[i]);
+        const MeshLod& lod = geometry.lods[batch % m_meshLodLevels];
+        if (!settings.meshletCulling || lod.meshletCount <= 1) {
+            GLuint firstInstance = m_meshDraws.instanceCount();
+            for (GLuint shape : meshBatches[batch]) {
+                m_meshDraws.addInstance(shape);
+            }
+            m_meshDraws.addDraw(lod.indexCount, geometry.firstIndex + lod.indexOffset, geometry.baseVertex,
+                                firstInstance, meshBatches[batch].size());
+            continue;
         }
-        glBufferData(GL_ARRAY_BUFFER, materialData.size() * sizeof(float),
-                     materialData.data(), GL_DYNAMIC_DRAW);
 
+        const Meshlet* meshlets = geometry.meshlets.data() + lod.meshletOffset;
+        for (GLuint shape : meshBatches[batch]) {
+
+            counts.clear();
+            firstIndices.clear();
+            meshletsVisible += cullMeshlets(meshlets, lod.meshletCount, geometry.firstIndex,
+                                            m_renderData.shapes[shape].ctm,
+                                            frustum, camPosition, counts, firstIndices);
+            meshletsTotal += lod.meshletCount;
+            if (counts.empty()) {
+                continue;
+            }
 
-        size_t stride = 13 * sizeof(float);
-        glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, stride, (void*)0);
-        glVertexAttribDivisor(6, 1);
+            GLuint instance = m_meshDraws.addInstance(shape);
+            for (size_t i = 0; i < counts.size(); i++) {
+                m_meshDraws.addDraw(counts[i], firstIndices[i], geometry.baseVertex, instance, 1);
+            }
 
-        glEnableVertexAttribArray(7);
-        glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, stride, (void*)(4 * sizeof(float)));
-        glVertexAttribDivisor(7, 1);
+        }
 
-        glEnableVertexAttribArray(8);
-        glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, stride, (void*)(8 * sizeof(float)));
-        glVertexAttribDivisor(8, 1);
+    }
 
-        glEnableVertexAttribArray(9);
-        glVertexAttribPointer(9, 1, GL_FLOAT, GL_FALSE, stride, (void*)(12 * sizeof(float)));
-        glVertexAttribDivisor(9, 1);
+    if (!m_meshDraws.empty()) {
 
+        // Meshes are always stored as floats
+        GLint packedLoc = glGetUniformLocation(m_phong_shader, "packedVertices");
+        glUniform1i(packedLoc, false);
 
-        glDrawArraysInstanced(GL_TRIANGLES, 0, geometry.verticies, shapes.size());
+        const ShapeGeometry& shared = m_meshGeometry[0];
+        drawCalls += m_meshDraws.submit(shared.vao, indirect);
+        m_stats.uploadedBytes += m_meshDraws.uploadedBytes();
 
-        glBindVertexArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glUniform1i(packedLoc, currVertexFormat == VertexFormat::Packed);
 
-    };
+    }
 
-    // Rendering all shapes using their vbos, and lambda / mini function above.
-    renderBatch(spheres, m_sphereGeometry);
-    renderBatch(cubes, m_cubeGeometry);
-    renderBatch(cylinders, m_cylinderGeometry);
-    renderBatch(cones, m_coneGeometry);
+    m_stats.drawCommands = m_primitiveDraws.drawCount() + m_meshDraws.drawCount();
+    m_stats.drawCalls = drawCalls;
+    m_stats.multiDrawIndirect = indirect;
+    m_stats.meshletsVisible = meshletsVisible;
+    m_stats.meshletsTotal = meshletsTotal;
 
 }
 
 void Realtime::renderShapesNonInstanced() {
 
-    for (const auto& shape : m_renderData.shapes) {
+    GLint packedLoc = glGetUniformLocation(m_phong_shader, "packedVertices");
+
+    for (size_t index = 0; index < m_renderData.shapes.size(); index++) {
 
-        // Attaching model for specific shape !
-        glUniformMatrix4fv(glGetUniformLocation(m_phong_shader, "model"), 1, GL_FALSE, &shape.ctm[0][0]);
+        const RenderShapeData& shape = m_renderData.shapes[index];
 
-        // Setting material properties
-        glUniform4fv(glGetUniformLocation(m_phong_shader, "materialAmbient"), 1, &shape.primitive.material.cAmbient[0]);
-        glUniform4fv(glGetUniformLocation(m_phong_shader, "materialDiffuse"), 1, &shape.primitive.material.cDiffuse[0]);
-        glUniform4fv(glGetUniformLocation(m_phong_shader, "materialSpecular"), 1, &shape.primitive.material.cSpecular[0]);
-        glUniform1f(glGetUniformLocation(m_phong_shader, "materialShininess"), shape.primitive.material.shininess);
+        // The phong shader reads the shape index as a per-instance attribute, so here it
+        // is passed as a constant attribute value instead of an array
+        glVertexAttribI4ui(2, index, 0, 0, 0);
 
         ShapeGeometry* geometry = nullptr;
 
-        switch(shape.primitive.type) {
+        switch(m_renderData.primitiveOf(shape).type) {
             case PrimitiveType::PRIMITIVE_SPHERE:
-                geometry = &m_sphereGeometry;
+                geometry = &m_sphereGeometry[0];
                 break;
 
             case PrimitiveType::PRIMITIVE_CUBE:
-                geometry = &m_cubeGeometry;
+                geometry = &m_cubeGeometry[0];
                 break;
 
             case PrimitiveType::PRIMITIVE_CYLINDER:
-                geometry = &m_cylinderGeometry;
+                geometry = &m_cylinderGeometry[0];
                 break;
 
             case PrimitiveType::PRIMITIVE_CONE:
-                geometry = &m_coneGeometry;
+                geometry = &m_coneGeometry[0];
                 break;
 
             case PrimitiveType::PRIMITIVE_MESH:
-                continue;  // Skip meshes for now
+                if (m_primitiveMeshes[shape.primitive] >= 0) {
+                    geometry = &m_meshGeometry[m_primitiveMeshes[shape.primitive]];
+                }
+                break;
         }
 
         if (geometry) {
 
+            // Meshes are always stored as floats
+            glUniform1i(packedLoc, currVertexFormat == VertexFormat::Packed
+                                       && m_renderData.primitiveOf(shape).type != PrimitiveType::PRIMITIVE_MESH);
+
             glBindVertexArray(geometry->vao);
-            glDrawArrays(GL_TRIANGLES, 0, geometry->verticies);
+            glDisableVertexAttribArray(2);
+            drawElements(*geometry);
 
         }
     }
 
+    glUniform1i(packedLoc, currVertexFormat == VertexFormat::Packed);
     glBindVertexArray(0);
 }
 
@@ -1284,6 +1510,10 @@ void Realtime::resizeGL(int w, int h) {
 }
 
 void Realtime::sceneChanged() {
+    startSceneLoad(false);
+}
+
+void Realtime::startSceneLoad(bool hotReload) {
 
     // Get the scene file path
     std::string sceneFilepath = settings.sceneFilePath;
@@ -1293,18 +1523,178 @@ void Realtime::sceneChanged() {
         return;
     }
 
-    std::cout << "Loading scene: " << sceneFilepath << std::endl;
+    // Only one load runs at a time; the newest file is loaded once this one is done
+    if (!m_loadQueue.start(hotReload)) {
+        return;
+    }
+
+    std::cout << (hotReload ? "Reloading scene: " : "Loading scene: ") << sceneFilepath << std::endl;
+
+    // Parse and flatten the scene off the GUI thread
+    m_loadProgress = 0.f;
+    SceneParseOptions options = SceneParseOptions::fromSettings();
+    m_loadingScene = std::async(std::launch::async, [this, sceneFilepath, options]() {
+        auto renderData = std::make_unique<RenderData>();
+        if (!SceneParser::parse(sceneFilepath, *renderData, options, &m_loadProgress)) {
+            renderData.reset();
+        }
+        return renderData;
+    });
+
+}
 
-    // Parse the scene
-    bool success = SceneParser::parse(sceneFilepath, m_renderData);
+bool Realtime::isLoadingScene() const {
+    return m_loadingScene.valid();
+}
+
+const FrameStats &Realtime::frameStats() const {
+    return m_stats;
+}
+
+float Realtime::sceneLoadProgress() const {
+    return m_loadProgress.load(std::memory_order_relaxed);
+}
+
+bool Realtime::sceneLoadFinished() {
+    return m_loadingScene.valid()
+           && m_loadingScene.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
 
-    if (!success) {
+// Called from paintGL, so the GL context is current
+void Realtime::swapInLoadedScene() {
+
+    std::unique_ptr<RenderData> renderData = m_loadingScene.get();
+    bool hotReload = m_loadQueue.isHotReload();
+
+    if (std::optional<bool> queued = m_loadQueue.finish()) {
+        startSceneLoad(*queued);
+        return;
+    }
+
+    // Editors often replace the file on save, which drops it from the watcher
+    updateSceneWatcher();
+
+    if (!renderData) {
         std::cerr << "Failed to parse scene file." << std::endl;
         return;
     }
 
+    if (hotReload) {
+        applyScenePatch(*renderData);
+        return;
+    }
+
+    m_renderData = std::move(*renderData);
+    m_chunkStreamer.reset(m_renderData.chunks);
+    updateSceneWatcher();
+    m_shapesMoved = true;
+
     m_global = m_renderData.globalData;
 
+    uploadMaterials();
+    m_shapeTable.assign(m_renderData.shapes);
+    uploadMeshes();
+
+    applySceneCamera();
+
+    initializeFBO();
+    initializeOcclusionFBO();
+
+    initializeShapeGeometry();
+    initializeFullscreenQuad();
+
+}
+
+// Applies only what changed in the file; the camera is left where the user moved it
+// unless the file's camera itself was edited
+void Realtime::applyScenePatch(RenderData &updated) {
+
+    // Patch the scene's own contents, then put the streamed chunks back after them
+    m_chunkStreamer.strip(m_renderData);
+    ScenePatch patch = SceneParser::patch(m_renderData, updated);
+    if (patch.chunksChanged) {
+        m_chunkStreamer.reset(m_renderData.chunks);
+        updateSceneWatcher();
+    }
+    m_chunkStreamer.compose(m_renderData);
+
+    m_global = m_renderData.globalData;
+
+    uploadMaterials();
+    uploadMeshes();
+
+    // Unless shapes moved around, the patch knows which ones changed
+    if (patch.restructured || patch.chunksChanged) {
+        m_shapeTable.assign(m_renderData.shapes);
+        m_shapesMoved = true;
+    } else {
+        m_shapeTable.update(m_renderData.shapes, patch.dirtyShapes);
+    }
+
+    if (patch.cameraChanged) {
+        applySceneCamera();
+    }
+
+    std::cout << "Hot reload: " << patch.dirtyShapes.size() << " shapes updated";
+    if (patch.restructured) {
+        std::cout << " (" << patch.addedShapes << " added, " << patch.removedShapes << " removed)";
+    }
+    if (patch.lightsChanged) std::cout << ", lights changed";
+    if (patch.cameraChanged) std::cout << ", camera changed";
+    if (patch.globalChanged) std::cout << ", global data changed";
+    if (patch.chunksChanged) std::cout << ", chunks changed";
+    std::cout << std::endl;
+
+}
+
+// Streams chunks in and out around the camera; called from paintGL
+void Realtime::updateChunks() {
+
+    glm::vec3 camPosition = m_camera.getInverseViewMatrix()[3];
+    if (m_chunkStreamer.update(camPosition)) {
+        m_chunkStreamer.strip(m_renderData);
+        m_chunkStreamer.compose(m_renderData);
+        uploadMaterials();
+        m_shapeTable.assign(m_renderData.shapes);
+        m_shapesMoved = true;
+        uploadMeshes();
+    }
+
+    m_stats.chunksResident = m_chunkStreamer.residentChunks();
+    m_stats.chunksTotal = m_renderData.chunks.size();
+    m_stats.chunksLoading = m_chunkStreamer.loadingChunks();
+    m_stats.chunkBytes = m_chunkStreamer.residentBytes();
+    m_stats.shapes = m_renderData.shapes.size();
+
+}
+
+// Carries each shape's level of detail over to wherever it moved in m_renderData.shapes,
+// so hysteresis keeps applying to the same shapes across restructures and chunk loads.
+// Shapes that are new start at the finest level.
+void Realtime::remapShapeLods() {
+
+    std::unordered_map<uint64_t, uint8_t> previous;
+    previous.reserve(m_shapeLodKeys.size());
+    for (size_t i = 0; i < m_shapeLodKeys.size(); i++) {
+        previous.emplace(m_shapeLodKeys[i], m_shapeLods[i]);
+    }
+
+    const std::vector<uint64_t>& keys = m_renderData.shapeKeys;
+    m_shapeLods.assign(keys.size(), 0);
+    for (size_t i = 0; i < keys.size(); i++) {
+        auto it = previous.find(keys[i]);
+        if (it != previous.end()) {
+            m_shapeLods[i] = it->second;
+        }
+    }
+
+    m_shapeLodKeys = keys;
+    m_shapesMoved = false;
+
+}
+
+void Realtime::applySceneCamera() {
+
     auto cam = m_renderData.cameraData;
 
     m_camera.setPosition(cam.pos);
@@ -1320,16 +1710,20 @@ void Realtime::sceneChanged() {
     m_view = m_camera.getViewMatrix();
     m_projection = m_camera.getProjectionMatrix();
 
-    currParam1 = settings.shapeParameter1;
-    currParam2 = settings.shapeParameter2;
+}
 
-    initializeFBO();
-    initializeOcclusionFBO();
+void Realtime::updateSceneWatcher() {
 
-    initializeShapeGeometry();
-    initializeFullscreenQuad();
+    for (const QString &file : m_sceneWatcher.files()) {
+        m_sceneWatcher.removePath(file);
+    }
 
-    update(); // asks for a PaintGL() call to occur
+    if (settings.watchSceneFile && !settings.sceneFilePath.empty()) {
+        m_sceneWatcher.addPath(QString::fromStdString(settings.sceneFilePath));
+        for (const RenderChunk &chunk : m_renderData.chunks) {
+            m_sceneWatcher.addPath(QString::fromStdString(chunk.filename));
+        }
+    }
 
 }
 
@@ -1342,10 +1736,26 @@ void Realtime::settingsChanged() {
     m_view = m_camera.getViewMatrix();
     m_projection = m_camera.getProjectionMatrix();
 
-    if (geometryInit && (currParam1 != settings.shapeParameter1 || currParam2 != settings.shapeParameter1)) {
+    // Tessellations used recently are still resident, so this is cheap when a slider
+    // moves back and forth
+    VertexFormat format = settings.packedVertices ? VertexFormat::Packed : VertexFormat::Float;
+    if (geometryInit && (currParam1 != settings.shapeParameter1 || currParam2 != settings.shapeParameter2
+                         || currVertexFormat != format)) {
+        makeCurrent();
         initializeShapeGeometry();
+        doneCurrent();
     }
 
+    // Meshes are rebuilt, or read from their caches, with the new chain of levels
+    MeshLodOptions lodOptions = {settings.meshLodLevels, settings.meshLodRatio};
+    if (geometryInit && lodOptions != m_geometryCache.meshLodOptions()) {
+        makeCurrent();
+        uploadMeshes();
+        doneCurrent();
+    }
+
+    updateSceneWatcher();
+
     update();
 
 }
@@ -1397,6 +1807,12 @@ void Realtime::timerEvent(QTimerEvent *event) {
     float deltaTime = elapsedms * 0.001f;
     m_elapsedTimer.restart();
 
+    // Repaint as soon as a background load is done so paintGL can swap it in
+    if (sceneLoadFinished() || m_chunkStreamer.loadFinished() || m_geometryCache.optimizeFinished()
+        || m_geometryCache.meshLoadFinished()) {
+        update();
+    }
+
     float speed;
     glm::vec3 movement(0.0f);
 
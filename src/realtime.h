@@ -2,6 +2,12 @@
 
 // Defined before including GLEW to suppress deprecation messages on macOS
 #include "camera/camera.h"
+#include "shapes/drawlist.h"
+#include "shapes/shapetable.h"
+#include "shapes/geometrycache.h"
+#include "utils/chunkstreamer.h"
+#include "utils/framestats.h"
+#include "utils/sceneloadqueue.h"
 #include "utils/sceneparser.h"
 #include "utils/shaderloader.h"
 
@@ -11,27 +17,19 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
 #include <unordered_map>
 #include <QElapsedTimer>
+#include <QFileSystemWatcher>
 #include <QOpenGLWidget>
 #include <QTime>
 #include <QTimer>
 
 #include "shaders/fbo.h"//;
 
-struct ShapeGeometry {
-
-    GLuint vbo;
-    GLuint vao;
-    int verticies;
-
-    // Instancing
-    GLuint instanceVBO;
-    GLuint materialVBO;
-
-};
-
-
 class Realtime : public QOpenGLWidget {
 
 public:  
@@ -41,6 +39,13 @@ public:
     void settingsChanged();
     void saveViewportImage(std::string filePath);
 
+    // Scenes load on a background thread; the current scene keeps rendering until the
+    // new one is swapped in by paintGL.
+    bool isLoadingScene() const;
+    float sceneLoadProgress() const;                    // 0 to 1
+
+    const FrameStats &frameStats() const;               // counters of the last frame
+
 public slots: 
     void tick(QTimerEvent* event);                      // Called once per tick of m_timer
 
@@ -94,6 +99,13 @@ private:
     GLuint m_fullscreen_vao;
     GLuint m_fullscreen_vbo;
 
+    // Material table (texture buffer read by the phong shader)
+    GLuint m_material_buffer = 0;
+    GLuint m_material_texture = 0;
+
+    // Every shape's model matrix and material index, read by the phong shader too
+    ShapeTable m_shapeTable;
+
     // =============================
     // Initialization Functions
     // =============================
@@ -104,6 +116,8 @@ private:
     void initializeFullscreenQuad();
     void initializeShapeGeometry();
     void initializeDepthBuffer();
+    void uploadMaterials();
+    void uploadMeshes();
 
     // =============================
     // Rendering Functions
@@ -128,6 +142,14 @@ private:
     void drawShape(const RenderShapeData& shape, GLuint shader);
     void passToDepthBuffer();
     void deleteFBOTextures();
+    void startSceneLoad(bool hotReload);
+    bool sceneLoadFinished();
+    void swapInLoadedScene();
+    void applyScenePatch(RenderData &updated);
+    void applySceneCamera();
+    void updateSceneWatcher();
+    void updateChunks();
+    void remapShapeLods();
 
     // =============================
     // Scene Data
@@ -136,6 +158,20 @@ private:
     RenderData m_renderData;
     SceneGlobalData m_global;
 
+    // === Background Scene Loading ===
+    std::future<std::unique_ptr<RenderData>> m_loadingScene;  // null result if parsing failed
+    std::atomic<float> m_loadProgress = 0.f;
+    SceneLoadQueue m_loadQueue;                         // which load runs next, and whether it patches
+
+    // === Chunk Streaming ===
+    ChunkStreamer m_chunkStreamer;                      // composes chunks near the camera into m_renderData
+
+    // === Hot Reload ===
+    QFileSystemWatcher m_sceneWatcher;
+    QTimer m_sceneReloadTimer;                          // waits for the editor to finish writing
+    bool m_sceneFileChanged = false;
+    std::vector<std::string> m_changedChunks;           // chunk files to re-parse when the timer fires
+
     // === Camera ===
     Camera m_camera;
     glm::mat4 m_view;
@@ -144,12 +180,36 @@ private:
     // === Shape Geometry ===
     bool geometryInit = false;
     int currParam1 = 1;
-    bool currParam2 = 1;
-
-    ShapeGeometry m_sphereGeometry;
-    ShapeGeometry m_cubeGeometry;
-    ShapeGeometry m_cylinderGeometry;
-    ShapeGeometry m_coneGeometry;
+    int currParam2 = 1;
+    VertexFormat currVertexFormat = VertexFormat::Float;
+
+    GeometryCache m_geometryCache;
+
+    // The current tessellations, one per level of detail. These are copies of the
+    // cache's entries, which own their ranges of the shared buffers.
+    ShapeGeometry m_sphereGeometry[GeometryCache::kLodLevels];
+    ShapeGeometry m_cubeGeometry[GeometryCache::kLodLevels];
+    ShapeGeometry m_cylinderGeometry[GeometryCache::kLodLevels];
+    ShapeGeometry m_coneGeometry[GeometryCache::kLodLevels];
+
+    // === Meshes ===
+    // One geometry per mesh file the scene uses, shared by all of its instances. These
+    // are copies of the cache's entries too.
+    std::vector<ShapeGeometry> m_meshGeometry;
+    std::vector<int> m_primitiveMeshes;                 // per primitive, its mesh in m_meshGeometry or -1
+    int m_meshLodLevels = 1;                            // the most levels any of them has
+
+    // === Draw Submission ===
+    // Reused every frame, one per arena: the primitives' and the meshes'
+    DrawList m_primitiveDraws;
+    DrawList m_meshDraws;
+    bool m_multiDrawIndirect = false;                   // whether the context supports it
+    FrameStats m_stats;                                 // filled in while drawing, shown by the UI
+
+    // === Level of Detail ===
+    std::vector<uint8_t> m_shapeLods;                   // each shape's level last frame, for hysteresis
+    std::vector<uint64_t> m_shapeLodKeys;               // the shapeKeys m_shapeLods is indexed like
+    bool m_shapesMoved = false;                         // shapes were added, removed or reordered since
 
     // =============================
     // Effect Parameters
@@ -7,6 +7,12 @@ struct Settings {
     std::string sceneFilePath;
     int shapeParameter1 = 1;
     int shapeParameter2 = 1;
+    bool shapeLod = true;
+    int meshLodLevels = 4;
+    float meshLodRatio = 0.5f;
+    bool meshletCulling = true;
+    bool multiDrawIndirect = true;
+    bool packedVertices = true;
     float nearPlane = 1;
     float farPlane = 100;
     bool perPixelFilter = false;
@@ -15,6 +21,12 @@ struct Settings {
     bool extraCredit2 = false;
     bool extraCredit3 = false;
     bool extraCredit4 = false;
+    bool useSceneCache = true;
+    bool streamingSceneReader = false;
+    bool parallelFlattening = true;
+    bool watchSceneFile = false;
+    bool streamChunks = true;
+    int chunkMemoryBudget = 1024; // MB
 };
 
 
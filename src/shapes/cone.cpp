@@ -1,171 +1,114 @@
 #pragma once
 #include "cone.h"
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 
-static void insert(std::vector<float> &data, glm::vec3 v) {
-    data.push_back(v.x);
-    data.push_back(v.y);
-    data.push_back(v.z);
+// The side's normal only depends on the angle around the axis: the slope rises 1 for
+// every 0.5 it moves in, so the normal is (cos, 0.5, sin), normalized.
+static glm::vec3 sideNormal(float cosTheta, float sinTheta) {
+    return glm::vec3(cosTheta, 0.5f, sinTheta) / glm::sqrt(1.25f);
 }
 
-static glm::vec3 calculateNormal(glm::vec3 &pt) {
+// The base and the side have vertices of their own, since their normals differ along
+// the rim. Within each, the last wedge wraps around to the vertices of the first.
+//
+// The base's center is a single vertex. The tip is one vertex per wedge, since its
+// normal there is the average of the normals along the wedge's two edges.
+//
+// Vertices: the base's center, param1 rings of the base from the center out, param1
+// rings of the side from the bottom up, then the tip.
+static void makeVertices(float* out, const AngleTable& theta, int param1, int param2) {
 
-    float x = pt.x;
-    float y = (0.5f - pt.y) / 4.0f;
-    float z =  pt.z;
-
-    glm::vec3 normal(x, y, z);
-    return glm::normalize(normal);
-
-}
-
-static glm::vec3 computeSlopeNormal(glm::vec3 &pt, glm::vec3 &edgeA, glm::vec3 &edgeB) {
+    const float radius = 0.5f;
+    const float totalHeight = 1.f;
+    const float halfHeight = totalHeight / 2.f;
 
-    float radius = glm::length(glm::vec2(pt.x, pt.z));
+    glm::vec3 down(0.f, -1.f, 0.f);
+    out = putVertex(out, glm::vec3(0.f, -halfHeight, 0.f), down);
 
-    if (radius < 1e-5f) {
-        glm::vec3 n1 = calculateNormal(edgeA);
-        glm::vec3 n2 = calculateNormal(edgeB);
-        return glm::normalize(n1 + n2);
+    for (int i = 1; i <= param1; i++) {
+        float ringRadius = (float)i / param1 * radius;
+        for (int j = 0; j < param2; j++) {
+            out = putVertex(out, glm::vec3(ringRadius * theta.cos[j], -halfHeight, ringRadius * theta.sin[j]), down);
+        }
     }
 
-    return calculateNormal(pt);
-
-}
-
-static void makeSideTile(std::vector<float>& data,
-                  glm::vec3 topStart, glm::vec3 topEnd,
-                  glm::vec3 bottomStart, glm::vec3 bottomEnd) {
-
-    glm::vec3 normalTL = computeSlopeNormal(topStart, bottomStart, bottomEnd);
-    glm::vec3 normalTR = computeSlopeNormal(topEnd, bottomStart, bottomEnd);
-    glm::vec3 normalBL = calculateNormal(bottomStart);
-    glm::vec3 normalBR = calculateNormal(bottomEnd);
-
-    // First triangle
-    insert(data, bottomStart);
-    insert(data, normalBL);
-
-    insert(data, topStart);
-    insert(data, normalTL);
-
-    insert(data, topEnd);
-    insert(data, normalTR);
-
-    // Second triangle
-    insert(data, bottomStart);
-    insert(data, normalBL);
-
-    insert(data, topEnd);
-    insert(data, normalTR);
-
-    insert(data, bottomEnd);
-    insert(data, normalBR);
-
-}
-
-static void makeBaseTile(std::vector<float>& data,
-                  glm::vec3 innerStart, glm::vec3 innerEnd,
-                  glm::vec3 outerStart, glm::vec3 outerEnd) {
-
-    glm::vec3 normal(0.f, -1.f, 0.f);
-
-    // Triangle 1
-    insert(data, outerStart);
-    insert(data, normal);
-
-    insert(data, innerEnd);
-    insert(data, normal);
-
-    insert(data, innerStart);
-    insert(data, normal);
-
-    // Triangle 2
-    insert(data, outerStart);
-    insert(data, normal);
+    for (int row = 0; row < param1; row++) {
+        float y = -halfHeight + row * (totalHeight / param1);
+        float ringRadius = radius * (1.f - (float)row / param1);
+        for (int j = 0; j < param2; j++) {
+            glm::vec3 point(ringRadius * theta.cos[j], y, ringRadius * theta.sin[j]);
+            out = putVertex(out, point, sideNormal(theta.cos[j], theta.sin[j]));
+        }
+    }
 
-    insert(data, outerEnd);
-    insert(data, normal);
+    for (int j = 0; j < param2; j++) {
+        glm::vec3 normal = sideNormal(theta.cos[j], theta.sin[j]) + sideNormal(theta.cos[j + 1], theta.sin[j + 1]);
+        out = putVertex(out, glm::vec3(0.f, halfHeight, 0.f), glm::normalize(normal));
+    }
 
-    insert(data, innerEnd);
-    insert(data, normal);
 }
 
-static void buildBaseSegment(std::vector<float>& data,
-                      int param1,
-                      float startTheta, float endTheta) {
-
-    const float radius = 0.5f;
-    const float y = -0.5f;
-
-    for (int i = 0; i < param1; i++) {
+// Where a ring of the base or side collapses to a point, only one triangle of each tile
+// is left
+static void makeIndices(GLuint* out, int param1, int param2) {
 
-        float innerRadius = (float)i / param1 * radius;
-        float outerRadius = (float)(i + 1) / param1 * radius;
+    const GLuint baseCenter = 0;
+    GLuint base = 1;
+    GLuint side = base + param1 * param2;
+    GLuint tip = side + param1 * param2;
 
-        glm::vec3 innerStart(innerRadius * glm::cos(startTheta), y, innerRadius * glm::sin(startTheta));
-        glm::vec3 innerEnd(innerRadius * glm::cos(endTheta),     y, innerRadius * glm::sin(endTheta));
-        glm::vec3 outerStart(outerRadius * glm::cos(startTheta), y, outerRadius * glm::sin(startTheta));
-        glm::vec3 outerEnd(outerRadius * glm::cos(endTheta),     y, outerRadius * glm::sin(endTheta));
+    for (int j = 0; j < param2; j++) {
 
-        makeBaseTile(data, innerStart, innerEnd, outerStart, outerEnd);
-    }
-}
+        int next = j + 1 == param2 ? 0 : j + 1;
 
-static void buildSideSegment(std::vector<float>& data,
-                      int param1,
-                      float startTheta, float endTheta) {
-    const float totalHeight = 1.f;
-    const float halfHeight = totalHeight / 2.f;
-    const float baseRadius = 0.5f;
+        // Base: (outerStart, innerEnd, innerStart) and (outerStart, outerEnd, innerEnd)
+        out = putTriangle(out, base + j, base + next, baseCenter);
 
-    for (int row = 0; row < param1; row++) {
-        float yTop = -halfHeight + (row + 1) * (totalHeight / param1);
-        float yBottom = -halfHeight + row * (totalHeight / param1);
+        for (int i = 1; i < param1; i++) {
 
-        float topRadius = baseRadius * (1.f - (float)(row + 1) / param1);
-        float bottomRadius = baseRadius * (1.f - (float)row / param1);
+            GLuint innerStart = base + (i - 1) * param2 + j;
+            GLuint innerEnd = base + (i - 1) * param2 + next;
+            GLuint outerStart = innerStart + param2;
+            GLuint outerEnd = innerEnd + param2;
 
-        glm::vec3 topStart(topRadius * glm::cos(startTheta), yTop, topRadius * glm::sin(startTheta));
-        glm::vec3 topEnd(topRadius * glm::cos(endTheta),     yTop, topRadius * glm::sin(endTheta));
-        glm::vec3 bottomStart(bottomRadius * glm::cos(startTheta), yBottom, bottomRadius * glm::sin(startTheta));
-        glm::vec3 bottomEnd(bottomRadius * glm::cos(endTheta),     yBottom, bottomRadius * glm::sin(endTheta));
+            out = putTriangle(out, outerStart, innerEnd, innerStart);
+            out = putTriangle(out, outerStart, outerEnd, innerEnd);
 
-        makeSideTile(data, topStart, topEnd, bottomStart, bottomEnd);
-    }
-}
+        }
 
-static void makeWedge(std::vector<float>& data,
-               int param1,
-               float startTheta, float endTheta) {
+        // Side: (bottomStart, topStart, topEnd) and (bottomStart, topEnd, bottomEnd)
+        for (int row = 0; row < param1 - 1; row++) {
 
-    buildBaseSegment(data, param1, startTheta, endTheta);
-    buildSideSegment(data, param1, startTheta, endTheta);
+            GLuint bottomStart = side + row * param2 + j;
+            GLuint bottomEnd = side + row * param2 + next;
+            GLuint topStart = bottomStart + param2;
+            GLuint topEnd = bottomEnd + param2;
 
-}
+            out = putTriangle(out, bottomStart, topStart, topEnd);
+            out = putTriangle(out, bottomStart, topEnd, bottomEnd);
 
-static void makeCone(std::vector<float>& data, int param1, int param2) {
+        }
 
-    data.clear();
-    float thetaStep = glm::radians(360.f / static_cast<float>(param2));
+        GLuint topRow = side + (param1 - 1) * param2;
+        out = putTriangle(out, topRow + j, tip + j, topRow + next);
 
-    for (int i = 0; i < param2; i++) {
-        float startTheta = i * thetaStep;
-        float endTheta = (i + 1) * thetaStep;
-        makeWedge(data, param1, startTheta, endTheta);
     }
 
 }
 
-std::vector<float> Cone::generateConeData(int param1, int param2) {
+ShapeMesh Cone::generateConeData(int param1, int param2) {
 
-    std::vector<float> data;
+    ShapeMesh mesh;
     param1 = glm::max(1, param1);
     param2 = glm::max(2, param2);
 
-    data.reserve(6 * param1 * param2 * 2 * 6 * 6);
-    makeCone(data, param1, param2);
+    AngleTable theta(param2, glm::two_pi<float>());
+
+    mesh.resize(2 * param1 * param2 + param2 + 1, 3 * param2 * (4 * param1 - 2));
+    makeVertices(mesh.vertices.data(), theta, param1, param2);
+    makeIndices(mesh.indices.data(), param1, param2);
 
-    return data;
+    return mesh;
 
 }
@@ -4,6 +4,6 @@
 class Cone : public Shape {
 
 public:
-    static std::vector<float> generateConeData(int param1, int param2);
+    static ShapeMesh generateConeData(int param1, int param2);
 
 };
@@ -2,66 +2,52 @@
 #include <glm/glm.hpp>
 
 
-static void insert(std::vector<float>& data, glm::vec3 v) {
-
-    data.push_back(v.x);
-    data.push_back(v.y);
-    data.push_back(v.z);
-
-}
-
-static void makeTile(std::vector<float>& data,
+// Each face is a (param + 1) x (param + 1) grid of vertices. Faces do not share vertices,
+// since their normals differ along the edges.
+//
+// Writes the face's vertices and indices at vertices and indices, and returns the index
+// of the face's first vertex after them.
+static GLuint makeFace(float*& vertices,
+              GLuint*& indices,
+              GLuint first,
+              int param,
               glm::vec3 topLeft,
               glm::vec3 topRight,
               glm::vec3 bottomLeft,
               glm::vec3 bottomRight) {
 
     glm::vec3 normal = glm::normalize(glm::cross(glm::vec3(topLeft - bottomLeft), glm::vec3(topLeft - bottomRight)));
+    glm::vec3 right = (topRight - topLeft) / (float)param;
+    glm::vec3 down = (bottomLeft - topLeft) / (float)param;
 
-    insert(data, topLeft);
-    insert(data, normal);
-    insert(data, bottomLeft);
-    insert(data, normal);
-    insert(data, bottomRight);
-    insert(data, normal);
-
-    insert(data, topRight);
-    insert(data, normal);
-    insert(data, topLeft);
-    insert(data, normal);
-    insert(data, bottomRight);
-    insert(data, normal);
-
-}
+    for (int row = 0; row <= param; row++) {
+        glm::vec3 start = topLeft + (float)row * down;
+        for (int col = 0; col <= param; col++) {
+            vertices = putVertex(vertices, start + (float)col * right, normal);
+        }
+    }
 
-static void makeFace(std::vector<float>& data,
-              int param,
-              glm::vec3 topLeft,
-              glm::vec3 topRight,
-              glm::vec3 bottomLeft,
-              glm::vec3 bottomRight) {
+    GLuint stride = param + 1;
 
     for (int row = 0; row < param; row++) {
         for (int col = 0; col < param; col++) {
 
-            float a = (float)row / param;
-            float b = (float)(row + 1)/ param;
-            float c = (float)col / param;
-            float d = (float)(col + 1) / param;
-
-            glm::vec3 newTopLeft = topLeft + c * (topRight - topLeft) + a * (bottomLeft - topLeft);
-            glm::vec3 newTopRight = topLeft + d * (topRight - topLeft) + a * (bottomLeft - topLeft);
-            glm::vec3 newBottomLeft = topLeft + c * (topRight - topLeft) + b * (bottomLeft - topLeft);
-            glm::vec3 newBottomRight = topLeft + d * (topRight - topLeft) + b * (bottomLeft - topLeft);
+            GLuint tileTopLeft = first + row * stride + col;
+            GLuint tileTopRight = tileTopLeft + 1;
+            GLuint tileBottomLeft = tileTopLeft + stride;
+            GLuint tileBottomRight = tileBottomLeft + 1;
 
-            makeTile(data, newTopLeft, newTopRight, newBottomLeft, newBottomRight);
+            indices = putTriangle(indices, tileTopLeft, tileBottomLeft, tileBottomRight);
+            indices = putTriangle(indices, tileTopRight, tileTopLeft, tileBottomRight);
 
         }
     }
 
+    return first + stride * stride;
+
 }
 
-static void makeCube(std::vector<float>& data, int param) {
+static void makeCube(ShapeMesh& mesh, int param) {
 
     glm::vec3 corner[8] = {
 
@@ -76,25 +62,29 @@ static void makeCube(std::vector<float>& data, int param) {
 
     };
 
-    makeFace(data, param, corner[0], corner[1], corner[2], corner[3]); // front-face
-    makeFace(data, param, corner[6], corner[7], corner[4], corner[5]); // back-face
+    float* vertices = mesh.vertices.data();
+    GLuint* indices = mesh.indices.data();
+    GLuint first = 0;
+
+    first = makeFace(vertices, indices, first, param, corner[0], corner[1], corner[2], corner[3]); // front-face
+    first = makeFace(vertices, indices, first, param, corner[6], corner[7], corner[4], corner[5]); // back-face
 
-    makeFace(data, param, corner[4], corner[5], corner[0], corner[1]); // upward-face
-    makeFace(data, param, corner[2], corner[3], corner[6], corner[7]); // downward-face
+    first = makeFace(vertices, indices, first, param, corner[4], corner[5], corner[0], corner[1]); // upward-face
+    first = makeFace(vertices, indices, first, param, corner[2], corner[3], corner[6], corner[7]); // downward-face
 
-    makeFace(data, param, corner[4], corner[0], corner[6], corner[2]); // leftmost-face
-    makeFace(data, param, corner[1], corner[5], corner[3], corner[7]); // rightmost-face
+    first = makeFace(vertices, indices, first, param, corner[4], corner[0], corner[6], corner[2]); // leftmost-face
+    first = makeFace(vertices, indices, first, param, corner[1], corner[5], corner[3], corner[7]); // rightmost-face
 
 }
 
 
-std::vector<float> Cube::generateCubeData(int param) {
+ShapeMesh Cube::generateCubeData(int param) {
 
-    std::vector<float> data;
+    ShapeMesh mesh;
     param = glm::max(1, param);
 
-    data.reserve(6 * param * param * 2 * 6 * 6);
-    makeCube(data, param);
+    mesh.resize(6 * (param + 1) * (param + 1), 6 * 6 * param * param);
+    makeCube(mesh, param);
 
-    return data;
+    return mesh;
 }
@@ -4,6 +4,6 @@
 class Cube : public Shape {
 
 public:
-    static std::vector<float> generateCubeData(int param);
+    static ShapeMesh generateCubeData(int param);
 
 };
@@ -1,266 +1,138 @@
 #include "cylinder.h"
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 
-#include "cylinder.h"
-#include <glm/glm.hpp>
-
-
-static void insert(std::vector<float>& data, glm::vec3 v) {
-    data.push_back(v.x);
-    data.push_back(v.y);
-    data.push_back(v.z);
-}
-
-
-static glm::vec3 calculateBodyNormal(const glm::vec3& point) {
-
-    return glm::normalize(glm::vec3(point.x, 0.0f, point.z));
-}
-
-
-static void makeBodyTile(std::vector<float>& data,
-                        glm::vec3 topLeft, glm::vec3 topRight,
-                        glm::vec3 bottomLeft, glm::vec3 bottomRight) {
-
-    glm::vec3 normalTL = calculateBodyNormal(topLeft);
-    glm::vec3 normalTR = calculateBodyNormal(topRight);
-    glm::vec3 normalBL = calculateBodyNormal(bottomLeft);
-    glm::vec3 normalBR = calculateBodyNormal(bottomRight);
-
-    insert(data, bottomLeft);
-    insert(data, normalBL);
-
-    insert(data, topLeft);
-    insert(data, normalTL);
-
-    insert(data, topRight);
-    insert(data, normalTR);
-
-    insert(data, bottomLeft);
-    insert(data, normalBL);
-
-    insert(data, topRight);
-    insert(data, normalTR);
-
-    insert(data, bottomRight);
-    insert(data, normalBR);
-}
-
-
-static void makeTopCapTile(std::vector<float>& data,
-                          glm::vec3 innerStart, glm::vec3 innerEnd,
-                          glm::vec3 outerStart, glm::vec3 outerEnd) {
-
-    glm::vec3 normal(0.0f, 1.0f, 0.0f);
-
-    // Triangle 1: innerStart -> innerEnd -> outerEnd
-    insert(data, innerStart);
-    insert(data, normal);
-
-    insert(data, innerEnd);
-    insert(data, normal);
-
-    insert(data, outerEnd);
-    insert(data, normal);
-
-    // Triangle 2: innerStart -> outerEnd -> outerStart
-    insert(data, innerStart);
-    insert(data, normal);
-
-    insert(data, outerEnd);
-    insert(data, normal);
 
-    insert(data, outerStart);
-    insert(data, normal);
-}
-
-static void makeBottomCapTile(std::vector<float>& data,
-                             glm::vec3 innerStart, glm::vec3 innerEnd,
-                             glm::vec3 outerStart, glm::vec3 outerEnd) {
+// Writes a cap's vertices: its center, then param1 rings of param2 vertices each.
+static float* makeCapVertices(float* out, const AngleTable& theta,
+                              int param1, int param2,
+                              float y, glm::vec3 normal) {
 
-    glm::vec3 normal(0.0f, -1.0f, 0.0f);
+    const float radius = 0.5f;
 
-    // Triangle 1: innerStart -> outerEnd -> innerEnd
-    insert(data, innerStart);
-    insert(data, normal);
+    out = putVertex(out, glm::vec3(0.0f, y, 0.0f), normal);
 
-    insert(data, outerEnd);
-    insert(data, normal);
+    for (int i = 1; i <= param1; i++) {
 
-    insert(data, innerEnd);
-    insert(data, normal);
+        float ringRadius = (float)i / param1 * radius;
 
-    // Triangle 2: innerStart -> outerStart -> outerEnd
-    insert(data, innerStart);
-    insert(data, normal);
+        for (int j = 0; j < param2; j++) {
+            out = putVertex(out, glm::vec3(ringRadius * theta.cos[j], y, ringRadius * theta.sin[j]), normal);
+        }
 
-    insert(data, outerStart);
-    insert(data, normal);
+    }
 
-    insert(data, outerEnd);
-    insert(data, normal);
+    return out;
 }
 
-
-static void makeBodyWedge(std::vector<float>& data,
-                         int param1,
-                         float currentTheta, float nextTheta) {
+// Writes the body's vertices: param1 + 1 rings of param2 vertices each, bottom to top.
+static float* makeBodyVertices(float* out, const AngleTable& theta, int param1, int param2) {
 
     const float radius = 0.5f;
     const float height = 1.0f;
     const float halfHeight = 0.5f;
 
+    for (int i = 0; i <= param1; i++) {
 
-    for (int i = 0; i < param1; i++) {
-
-        float yBottom = -halfHeight + (float)i / param1 * height;
-        float yTop = -halfHeight + (float)(i + 1) / param1 * height;
-
-        glm::vec3 topLeft(
-            radius * glm::cos(currentTheta),
-            yTop,
-            radius * glm::sin(currentTheta)
-        );
+        float y = -halfHeight + (float)i / param1 * height;
 
-        glm::vec3 topRight(
-            radius * glm::cos(nextTheta),
-            yTop,
-            radius * glm::sin(nextTheta)
-        );
-
-        glm::vec3 bottomLeft(
-            radius * glm::cos(currentTheta),
-            yBottom,
-            radius * glm::sin(currentTheta)
-        );
-
-        glm::vec3 bottomRight(
-            radius * glm::cos(nextTheta),
-            yBottom,
-            radius * glm::sin(nextTheta)
-        );
-
-        makeBodyTile(data, topLeft, topRight, bottomLeft, bottomRight);
+        for (int j = 0; j < param2; j++) {
+            glm::vec3 normal(theta.cos[j], 0.0f, theta.sin[j]);
+            out = putVertex(out, glm::vec3(radius * normal.x, y, radius * normal.z), normal);
+        }
 
     }
-}
 
+    return out;
+}
 
-static void makeTopCapWedge(std::vector<float>& data,
-                           int param1,
-                           float currentTheta, float nextTheta) {
-
-    const float radius = 0.5f;
-    const float y = 0.5f;
-
-    for (int i = 0; i < param1; i++) {
-
-        float innerRadius = (float)i / param1 * radius;
-        float outerRadius = (float)(i + 1) / param1 * radius;
+// Writes a cap's triangles for wedge j. At its center the inner edge of each tile
+// collapses to a point, so only one triangle is left there.
+static GLuint* makeCapWedge(GLuint* out, GLuint center,
+                            int param1, int param2,
+                            int j, int next, bool top) {
 
-        glm::vec3 innerStart(
-            innerRadius * glm::cos(currentTheta),
-            y,
-            innerRadius * glm::sin(currentTheta)
-        );
+    auto ring = [center, param2](int i) -> GLuint {
+        return center + 1 + (i - 1) * param2;
+    };
 
-        glm::vec3 innerEnd(
-            innerRadius * glm::cos(nextTheta),
-            y,
-            innerRadius * glm::sin(nextTheta)
-        );
+    GLuint outerStart = ring(1) + j;
+    GLuint outerEnd = ring(1) + next;
+    out = top ? putTriangle(out, center, outerEnd, outerStart)
+              : putTriangle(out, center, outerStart, outerEnd);
 
-        glm::vec3 outerStart(
-            outerRadius * glm::cos(currentTheta),
-            y,
-            outerRadius * glm::sin(currentTheta)
-        );
+    for (int i = 1; i < param1; i++) {
 
-        glm::vec3 outerEnd(
-            outerRadius * glm::cos(nextTheta),
-            y,
-            outerRadius * glm::sin(nextTheta)
-        );
+        GLuint innerStart = ring(i) + j;
+        GLuint innerEnd = ring(i) + next;
+        outerStart = ring(i + 1) + j;
+        outerEnd = ring(i + 1) + next;
 
-        makeTopCapTile(data, innerStart, innerEnd, outerStart, outerEnd);
+        if (top) {
+            out = putTriangle(out, innerStart, innerEnd, outerEnd);
+            out = putTriangle(out, innerStart, outerEnd, outerStart);
+        } else {
+            out = putTriangle(out, innerStart, outerEnd, innerEnd);
+            out = putTriangle(out, innerStart, outerStart, outerEnd);
+        }
 
     }
-}
-
-static void makeBottomCapWedge(std::vector<float>& data,
-                               int param1,
-                               float currentTheta, float nextTheta) {
 
-    const float radius = 0.5f;
-    const float y = -0.5f;
-
-    for (int i = 0; i < param1; i++) {
+    return out;
+}
 
-        float innerRadius = (float)i / param1 * radius;
-        float outerRadius = (float)(i + 1) / param1 * radius;
+// The caps and the body have vertices of their own, since their normals differ along
+// the rims. Within each, the last wedge wraps around to the vertices of the first.
+static void makeCylinder(ShapeMesh& mesh,
+                         int param1, int param2) {
 
-        glm::vec3 innerStart(
-            innerRadius * glm::cos(currentTheta),
-            y,
-            innerRadius * glm::sin(currentTheta)
-            );
+    AngleTable theta(param2, glm::two_pi<float>());
 
-        glm::vec3 innerEnd(
-            innerRadius * glm::cos(nextTheta),
-            y,
-            innerRadius * glm::sin(nextTheta)
-            );
+    GLuint capVertices = 1 + param1 * param2;
+    GLuint bottomCenter = 0;
+    GLuint body = capVertices;
+    GLuint topCenter = body + (param1 + 1) * param2;
 
-        glm::vec3 outerStart(
-            outerRadius * glm::cos(currentTheta),
-            y,
-            outerRadius * glm::sin(currentTheta)
-            );
+    float* vertices = mesh.vertices.data();
+    vertices = makeCapVertices(vertices, theta, param1, param2, -0.5f, glm::vec3(0.0f, -1.0f, 0.0f));
+    vertices = makeBodyVertices(vertices, theta, param1, param2);
+    makeCapVertices(vertices, theta, param1, param2, 0.5f, glm::vec3(0.0f, 1.0f, 0.0f));
 
-        glm::vec3 outerEnd(
-            outerRadius * glm::cos(nextTheta),
-            y,
-            outerRadius * glm::sin(nextTheta)
-            );
+    GLuint* indices = mesh.indices.data();
 
-        makeBottomCapTile(data, innerStart, innerEnd, outerStart, outerEnd);
+    for (int j = 0; j < param2; j++) {
 
-    }
-}
+        int next = j + 1 == param2 ? 0 : j + 1;
 
-static void makeWedge(std::vector<float>& data,
-                      int param1,
-                      float currentTheta, float nextTheta) {
+        indices = makeCapWedge(indices, bottomCenter, param1, param2, j, next, false);
 
-    makeBottomCapWedge(data, param1, currentTheta, nextTheta);
-    makeBodyWedge(data, param1, currentTheta, nextTheta);
-    makeTopCapWedge(data, param1, currentTheta, nextTheta);
+        for (int i = 0; i < param1; i++) {
 
-}
+            GLuint bottomLeft = body + i * param2 + j;
+            GLuint bottomRight = body + i * param2 + next;
+            GLuint topLeft = bottomLeft + param2;
+            GLuint topRight = bottomRight + param2;
 
-static void makeCylinder(std::vector<float>& data,
-                         int param1, int param2) {
+            indices = putTriangle(indices, bottomLeft, topLeft, topRight);
+            indices = putTriangle(indices, bottomLeft, topRight, bottomRight);
 
-    float thetaStep = glm::radians(360.0f / param2);
+        }
 
-    for (int i = 0; i < param2; i++) {
-        float currentTheta = i * thetaStep;
-        float nextTheta = (i + 1) * thetaStep;
+        indices = makeCapWedge(indices, topCenter, param1, param2, j, next, true);
 
-        makeWedge(data, param1, currentTheta, nextTheta);
     }
 
 }
 
-std::vector<float> Cylinder::generateCylinderData(int param1, int param2) {
+ShapeMesh Cylinder::generateCylinderData(int param1, int param2) {
 
-    std::vector<float> data;
+    ShapeMesh mesh;
     param1 = glm::max(1, param1);
     param2 = glm::max(3, param2);
 
-    data.reserve(3 * param1 * param2 * 2 * 3 * 6);
-    makeCylinder(data, param1, param2);
+    mesh.resize(2 * (1 + param1 * param2) + (param1 + 1) * param2,
+                3 * param2 * (6 * param1 - 2));
+    makeCylinder(mesh, param1, param2);
 
-    return data;
+    return mesh;
 }
-
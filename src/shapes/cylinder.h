@@ -1,9 +1,9 @@
 #pragma once
-#include <vector>
+#include "shapes/shape.h"
 
 class Cylinder {
 
 public:
-    static std::vector<float> generateCylinderData(int param1, int param2);
+    static ShapeMesh generateCylinderData(int param1, int param2);
 
 };
@@ -0,0 +1,170 @@
+#include "drawlist.h"
+
+#include <algorithm>
+
+bool DrawList::multiDrawIndirectSupported() {
+    return GLEW_VERSION_4_3 || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+}
+
+// Brings buffer, which holds uploaded, in line with data, and records data as uploaded.
+// Only the span of words that differ is sent, unless data no longer fits.
+// @return  the bytes uploaded
+template <typename T>
+static size_t uploadChanges(GLenum target, GLuint buffer, size_t &capacity,
+                            const std::vector<T> &data, std::vector<T> &uploaded) {
+
+    static_assert(sizeof(T) % sizeof(GLuint) == 0);
+
+    size_t size = data.size() * sizeof(T);
+    glBindBuffer(target, buffer);
+
+    if (size > capacity) {
+        capacity = std::max(size, 2 * capacity);
+        glBufferData(target, capacity, nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(target, 0, size, data.data());
+        uploaded = data;
+        return size;
+    }
+
+    // Words past the end of what was uploaded all count as changed
+    const GLuint *words = reinterpret_cast<const GLuint *>(data.data());
+    const GLuint *previous = reinterpret_cast<const GLuint *>(uploaded.data());
+    size_t count = size / sizeof(GLuint);
+    size_t kept = std::min(data.size(), uploaded.size()) * sizeof(T) / sizeof(GLuint);
+
+    size_t first = 0;
+    while (first < kept && words[first] == previous[first]) {
+        first++;
+    }
+    size_t end = count;
+    if (count <= kept) {
+        while (end > first && words[end - 1] == previous[end - 1]) {
+            end--;
+        }
+    }
+
+    if (end > first) {
+        glBufferSubData(target, first * sizeof(GLuint), (end - first) * sizeof(GLuint), words + first);
+    }
+    uploaded = data;
+    return (end - first) * sizeof(GLuint);
+
+}
+
+GLuint DrawList::addInstance(GLuint shape) {
+    m_shapes.push_back(shape);
+    return GLuint(m_shapes.size() - 1);
+}
+
+void DrawList::addDraw(GLuint count, GLuint firstIndex, GLint baseVertex, GLuint firstInstance, GLuint instanceCount) {
+    m_commands.push_back({count, instanceCount, firstIndex, baseVertex, firstInstance});
+}
+
+void DrawList::clear() {
+    m_shapes.clear();
+    m_commands.clear();
+}
+
+void DrawList::release() {
+
+    if (m_instanceBuffer == 0) {
+        return;
+    }
+
+    GLuint buffers[] = {m_instanceBuffer, m_indirectBuffer};
+    glDeleteBuffers(2, buffers);
+
+    m_instanceBuffer = m_indirectBuffer = 0;
+    m_instanceCapacity = m_indirectCapacity = 0;
+    m_uploadedShapes.clear();
+    m_uploadedCommands.clear();
+
+}
+
+// Points the bound vertex array's shape index attribute at firstInstance
+void DrawList::pointInstanceAttribute(GLuint firstInstance) {
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GLuint),
+                           (void*)(size_t(firstInstance) * sizeof(GLuint)));
+}
+
+int DrawList::submit(GLuint vao, bool indirect) {
+
+    m_uploadedBytes = 0;
+    if (m_commands.empty()) {
+        return 0;
+    }
+
+    if (m_instanceBuffer == 0) {
+        glGenBuffers(1, &m_instanceBuffer);
+        glGenBuffers(1, &m_indirectBuffer);
+    }
+
+    glBindVertexArray(vao);
+
+    m_uploadedBytes += uploadChanges(GL_ARRAY_BUFFER, m_instanceBuffer, m_instanceCapacity, m_shapes, m_uploadedShapes);
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    int calls = 0;
+
+    if (indirect) {
+
+        // Each command's base instance picks its instances out of the buffer
+        pointInstanceAttribute(0);
+
+        m_uploadedBytes += uploadChanges(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer, m_indirectCapacity,
+                                         m_commands, m_uploadedCommands);
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, GLsizei(m_commands.size()), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        calls = 1;
+
+    } else {
+
+        for (size_t c = 0; c < m_commands.size();) {
+
+            const DrawElementsIndirectCommand &command = m_commands[c];
+            pointInstanceAttribute(command.baseInstance);
+
+            // A non-instanced draw reads the per-instance attribute at the first instance
+            // it points to, so ranges of one instance go together
+            size_t end = c + 1;
+            if (command.instanceCount == 1) {
+                while (end < m_commands.size() && m_commands[end].instanceCount == 1
+                       && m_commands[end].baseInstance == command.baseInstance) {
+                    end++;
+                }
+            }
+
+            if (end - c > 1) {
+                m_counts.clear();
+                m_offsets.clear();
+                m_baseVertices.clear();
+                for (size_t i = c; i < end; i++) {
+                    m_counts.push_back(m_commands[i].count);
+                    m_offsets.push_back((const void*)(size_t(m_commands[i].firstIndex) * sizeof(GLuint)));
+                    m_baseVertices.push_back(m_commands[i].baseVertex);
+                }
+                glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_counts.data(), GL_UNSIGNED_INT, m_offsets.data(),
+                                              GLsizei(m_counts.size()), m_baseVertices.data());
+            } else {
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+                                                  (void*)(size_t(command.firstIndex) * sizeof(GLuint)),
+                                                  command.instanceCount, command.baseVertex);
+            }
+
+            calls++;
+            c = end;
+
+        }
+
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return calls;
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "shapes/shape.h"
+
+// The layout glMultiDrawElementsIndirect reads its commands in
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// A frame's instanced draws from one GeometryArena, gathered so they can be submitted
+// together. Each draw takes a run of the list's instances. An instance is just the index
+// of its shape in the ShapeTable, which holds the model matrices and materials.
+//
+// The list keeps its own instance and indirect buffers, and a copy of what it last put in
+// them. Each submit() uploads only the span that differs from that copy, so a frame whose
+// batches come out the same as the last one uploads nothing.
+//
+// Where the context has multi-draw indirect and base instance (GL 4.3, or the ARB
+// extensions), the whole list is one indirect buffer and one call. GL 4.1, as on macOS,
+// has neither, so there each draw points the instance attribute at its first instance
+// instead; runs of single-instance draws of the same instance are still merged into one
+// glMultiDrawElementsBaseVertex call.
+class DrawList {
+public:
+    // Whether the current context can submit a list with one call
+    static bool multiDrawIndirectSupported();
+
+    // @return  the new instance's index, for addDraw
+    GLuint addInstance(GLuint shape);
+
+    // Draws count indices from firstIndex for the instanceCount instances from firstInstance.
+    void addDraw(GLuint count, GLuint firstIndex, GLint baseVertex, GLuint firstInstance, GLuint instanceCount);
+
+    // Draws the list through the arena's vertex array, with one indirect call if indirect
+    // is set. Needs the GL context current.
+    // @return  the number of draw calls issued
+    int submit(GLuint vao, bool indirect);
+
+    // Empties the list, keeping its storage for the next frame
+    void clear();
+
+    // Deletes the buffers
+    void release();
+
+    bool empty() const { return m_commands.empty(); }
+    GLuint instanceCount() const { return GLuint(m_shapes.size()); }
+    size_t drawCount() const { return m_commands.size(); }
+
+    // Bytes the last submit() uploaded
+    size_t uploadedBytes() const { return m_uploadedBytes; }
+
+private:
+    void pointInstanceAttribute(GLuint firstInstance);
+
+    std::vector<GLuint> m_shapes;
+    std::vector<DrawElementsIndirectCommand> m_commands;
+
+    // What the buffers hold
+    std::vector<GLuint> m_uploadedShapes;
+    std::vector<DrawElementsIndirectCommand> m_uploadedCommands;
+
+    GLuint m_instanceBuffer = 0;
+    GLuint m_indirectBuffer = 0;
+    size_t m_instanceCapacity = 0;      // bytes
+    size_t m_indirectCapacity = 0;
+    size_t m_uploadedBytes = 0;
+
+    // Scratch for merging single-instance draws on the fallback path
+    std::vector<GLsizei> m_counts;
+    std::vector<const void *> m_offsets;
+    std::vector<GLint> m_baseVertices;
+};
@@ -0,0 +1,290 @@
+#include "geometryarena.h"
+
+#include <cstddef>
+
+// Smallest capacity, in elements, each buffer starts with
+static const uint32_t kMinCapacity = 64 * 1024;
+
+uint32_t RangeAllocator::allocate(uint32_t count) {
+
+    for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+        if (it->second < count) {
+            continue;
+        }
+        uint32_t offset = it->first;
+        uint32_t left = it->second - count;
+        m_free.erase(it);
+        if (left > 0) {
+            m_free[offset + count] = left;
+        }
+        m_used += count;
+        return offset;
+    }
+
+    return kFailed;
+
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t count) {
+
+    if (count == 0) {
+        return;
+    }
+    m_used -= count;
+
+    auto next = m_free.lower_bound(offset);
+    if (next != m_free.end() && offset + count == next->first) {
+        count += next->second;
+        next = m_free.erase(next);
+    }
+
+    if (next != m_free.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += count;
+            return;
+        }
+    }
+
+    m_free[offset] = count;
+
+}
+
+void RangeAllocator::grow(uint32_t capacity) {
+    // free() takes the new space off the allocated count
+    m_used += capacity - m_capacity;
+    free(m_capacity, capacity - m_capacity);
+    m_capacity = capacity;
+}
+
+void RangeAllocator::clear() {
+    m_free.clear();
+    m_capacity = 0;
+    m_used = 0;
+}
+
+// Whether less than a quarter of ranges is allocated, or none of it
+static bool isSparse(const RangeAllocator &ranges) {
+    if (ranges.capacity() == 0) {
+        return false;
+    }
+    return ranges.used() == 0 || (ranges.capacity() > kMinCapacity && 4 * size_t(ranges.used()) < ranges.capacity());
+}
+
+size_t GeometryArena::vertexSize() const {
+    return m_format == VertexFormat::Packed ? sizeof(PackedVertex) : 6 * sizeof(GLfloat);
+}
+
+size_t GeometryArena::capacityBytes() const {
+    return m_vertices.capacity() * vertexSize() + m_indices.capacity() * sizeof(GLuint);
+}
+
+void GeometryArena::create() {
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ibo);
+
+    // The element buffer binding is part of the vertex array's state
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+    setVertexAttributes();
+    glBindVertexArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+}
+
+// Points the bound vertex array's per-vertex attributes at m_vbo
+void GeometryArena::setVertexAttributes() {
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+    if (m_format == VertexFormat::Packed) {
+
+        // Positions, normalized to [-1, 1]; the shaders halve them
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE,
+                              sizeof(PackedVertex),
+                              (void*)offsetof(PackedVertex, position));
+
+        // Octahedral normals; the shaders decode them
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE,
+                              sizeof(PackedVertex),
+                              (void*)offsetof(PackedVertex, normal));
+
+    } else {
+
+        // Positions
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE,
+                              6 * sizeof(GLfloat),
+                              (void*)0);
+
+        // Normals
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
+                              6 * sizeof(GLfloat),
+                              (void*)(3 * sizeof(GLfloat)));
+
+    }
+
+}
+
+// Replaces buffer with one at least twice as large that holds needed more elements, and
+// copies the old contents over
+void GeometryArena::growBuffer(GLuint &buffer, GLenum target, RangeAllocator &ranges,
+                               size_t elementSize, uint32_t needed) {
+
+    uint32_t capacity = glm::max(glm::max(kMinCapacity, 2 * ranges.capacity()), ranges.capacity() + needed);
+
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, size_t(capacity) * elementSize, nullptr, GL_STATIC_DRAW);
+
+    if (ranges.capacity() > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size_t(ranges.capacity()) * elementSize);
+    }
+    replaceBuffer(buffer, target, grown);
+
+    ranges.grow(capacity);
+
+}
+
+// Deletes buffer and points the vertex array at replacement instead
+void GeometryArena::replaceBuffer(GLuint &buffer, GLenum target, GLuint replacement) {
+
+    glDeleteBuffers(1, &buffer);
+    buffer = replacement;
+
+    glBindVertexArray(m_vao);
+    if (target == GL_ELEMENT_ARRAY_BUFFER) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+    } else {
+        setVertexAttributes();
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+}
+
+GeometryArena::Allocation GeometryArena::allocate(const void *vertices, size_t vertexCount,
+                                                  const GLuint *indices, size_t indexCount) {
+
+    if (m_vao == 0) {
+        create();
+    }
+
+    uint32_t firstVertex = m_vertices.allocate(vertexCount);
+    if (firstVertex == RangeAllocator::kFailed) {
+        growBuffer(m_vbo, GL_ARRAY_BUFFER, m_vertices, vertexSize(), vertexCount);
+        firstVertex = m_vertices.allocate(vertexCount);
+    }
+
+    uint32_t firstIndex = m_indices.allocate(indexCount);
+    if (firstIndex == RangeAllocator::kFailed) {
+        growBuffer(m_ibo, GL_ELEMENT_ARRAY_BUFFER, m_indices, sizeof(GLuint), indexCount);
+        firstIndex = m_indices.allocate(indexCount);
+    }
+
+    Allocation allocation = {GLint(firstVertex), firstIndex};
+    update(allocation, vertices, vertexCount, indices, indexCount);
+    return allocation;
+
+}
+
+void GeometryArena::update(const Allocation &allocation, const void *vertices, size_t vertexCount,
+                           const GLuint *indices, size_t indexCount) {
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, size_t(allocation.baseVertex) * vertexSize(), vertexCount * vertexSize(), vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Through the copy target, so the element buffer binding of whichever vertex array is
+    // bound is left alone
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_ibo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, size_t(allocation.firstIndex) * sizeof(GLuint),
+                    indexCount * sizeof(GLuint), indices);
+
+}
+
+void GeometryArena::free(const Allocation &allocation, size_t vertexCount, size_t indexCount) {
+    m_vertices.free(allocation.baseVertex, vertexCount);
+    m_indices.free(allocation.firstIndex, indexCount);
+}
+
+void GeometryArena::release() {
+
+    if (m_vao == 0) {
+        return;
+    }
+
+    glDeleteVertexArrays(1, &m_vao);
+    GLuint buffers[] = {m_vbo, m_ibo};
+    glDeleteBuffers(2, buffers);
+
+    m_vao = m_vbo = m_ibo = 0;
+    m_vertices.clear();
+    m_indices.clear();
+
+}
+
+bool GeometryArena::sparse() const {
+    return isSparse(m_vertices) || isSparse(m_indices);
+}
+
+void GeometryArena::compact(std::vector<Block> &blocks) {
+
+    if (m_vertices.used() == 0 && m_indices.used() == 0) {
+        GLuint buffers[] = {m_vbo, m_ibo};
+        glDeleteBuffers(2, buffers);
+        m_vbo = m_ibo = 0;
+        m_vertices.clear();
+        m_indices.clear();
+        return;
+    }
+
+    uint32_t vertexCapacity = isSparse(m_vertices) ? glm::max(kMinCapacity, 2 * m_vertices.used()) : m_vertices.capacity();
+    uint32_t indexCapacity = isSparse(m_indices) ? glm::max(kMinCapacity, 2 * m_indices.used()) : m_indices.capacity();
+
+    GLuint vbo, ibo;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, size_t(vertexCapacity) * vertexSize(), nullptr, GL_STATIC_DRAW);
+    glGenBuffers(1, &ibo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+    glBufferData(GL_COPY_WRITE_BUFFER, size_t(indexCapacity) * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+
+    // Each block's indices are relative to its base vertex, so they are copied as they are
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    for (Block &block : blocks) {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_vbo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, size_t(block.allocation.baseVertex) * vertexSize(),
+                            size_t(vertexCount) * vertexSize(), block.vertexCount * vertexSize());
+
+        glBindBuffer(GL_COPY_READ_BUFFER, m_ibo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, size_t(block.allocation.firstIndex) * sizeof(GLuint),
+                            size_t(indexCount) * sizeof(GLuint), block.indexCount * sizeof(GLuint));
+
+        block.allocation = {GLint(vertexCount), indexCount};
+        vertexCount += block.vertexCount;
+        indexCount += block.indexCount;
+    }
+
+    replaceBuffer(m_vbo, GL_ARRAY_BUFFER, vbo);
+    replaceBuffer(m_ibo, GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+    m_vertices.clear();
+    m_vertices.grow(vertexCapacity);
+    m_vertices.allocate(vertexCount);
+    m_indices.clear();
+    m_indices.grow(indexCapacity);
+    m_indices.allocate(indexCount);
+
+}
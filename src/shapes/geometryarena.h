@@ -0,0 +1,99 @@
+#pragma once
+
+#include "shapes/shape.h"
+
+#include <map>
+#include <vector>
+
+// First-fit allocator over the elements [0, capacity()). Freed ranges merge with the free
+// ranges next to them.
+class RangeAllocator {
+public:
+    static const uint32_t kFailed = ~0u;
+
+    // @return  the first element of the range, or kFailed if no free range is large enough
+    uint32_t allocate(uint32_t count);
+    void free(uint32_t offset, uint32_t count);
+
+    // Extends the space at the end to capacity elements.
+    void grow(uint32_t capacity);
+    void clear();
+
+    uint32_t capacity() const { return m_capacity; }
+    uint32_t used() const { return m_used; }
+
+private:
+    std::map<uint32_t, uint32_t> m_free;    // first element to count
+    uint32_t m_capacity = 0;
+    uint32_t m_used = 0;
+};
+
+// Holds the vertices and indices of many shapes in one vertex buffer and one index buffer,
+// drawn through a single vertex array. Each shape's indices are relative to its own
+// vertices, so they are drawn with its first vertex as the base vertex.
+//
+// The buffers double when they run out of room, and the vertex array is pointed at the
+// new ones, so the vertex array stays the same for as long as the arena lives. Freeing
+// never shrinks them; compact() does, once they are mostly empty.
+//
+// The per-instance attribute comes from whichever DrawList draws through the vertex array.
+// All calls need the GL context current.
+class GeometryArena {
+public:
+    explicit GeometryArena(VertexFormat format) : m_format(format) {}
+
+    struct Allocation {
+        GLint baseVertex;
+        GLuint firstIndex;
+    };
+
+    // An allocation and its size, for compact()
+    struct Block {
+        Allocation allocation;
+        size_t vertexCount;
+        size_t indexCount;
+    };
+
+    // Uploads vertexCount vertices, already in the arena's format, and the indices into
+    // them, creating the buffers on first use.
+    Allocation allocate(const void *vertices, size_t vertexCount, const GLuint *indices, size_t indexCount);
+    void free(const Allocation &allocation, size_t vertexCount, size_t indexCount);
+
+    // Overwrites the start of an allocation with vertexCount vertices and indexCount
+    // indices, no more than it was made for.
+    void update(const Allocation &allocation, const void *vertices, size_t vertexCount,
+                const GLuint *indices, size_t indexCount);
+
+    // Deletes the buffers and the vertex array; the arena starts over on the next allocate().
+    void release();
+
+    // Whether less than a quarter of either buffer is allocated, or none of them is
+    bool sparse() const;
+
+    // Moves blocks, which must be every allocation, to the start of new buffers, and
+    // updates their allocations. A sparse buffer's replacement is twice the size of its
+    // blocks; if there are none, the buffers are deleted and only the vertex array is kept.
+    void compact(std::vector<Block> &blocks);
+
+    VertexFormat format() const { return m_format; }
+    size_t vertexSize() const;
+
+    GLuint vao() const { return m_vao; }
+
+    size_t capacityBytes() const;
+
+private:
+    void create();
+    void setVertexAttributes();
+    void growBuffer(GLuint &buffer, GLenum target, RangeAllocator &ranges, size_t elementSize, uint32_t needed);
+    void replaceBuffer(GLuint &buffer, GLenum target, GLuint replacement);
+
+    VertexFormat m_format;
+
+    GLuint m_vao = 0;
+    GLuint m_vbo = 0;
+    GLuint m_ibo = 0;
+
+    RangeAllocator m_vertices;
+    RangeAllocator m_indices;
+};
@@ -0,0 +1,520 @@
+#include "geometrycache.h"
+
+#include "shapes/cube.h"
+#include "shapes/sphere.h"
+#include "shapes/cone.h"
+#include "shapes/cylinder.h"
+#include "shapes/meshcache.h"
+#include "shapes/objloader.h"
+#include "shapes/simplify.h"
+#include "shapes/vertexcache.h"
+
+#include <chrono>
+#include <iostream>
+
+using Clock = std::chrono::steady_clock;
+
+template <typename T>
+static bool isReady(const std::future<T> &future) {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+static const char *primitiveName(PrimitiveType type) {
+
+    switch (type) {
+    case PrimitiveType::PRIMITIVE_SPHERE:
+        return "sphere";
+    case PrimitiveType::PRIMITIVE_CUBE:
+        return "cube";
+    case PrimitiveType::PRIMITIVE_CYLINDER:
+        return "cylinder";
+    case PrimitiveType::PRIMITIVE_CONE:
+        return "cone";
+    default:
+        return "mesh";
+    }
+
+}
+
+static std::ostream &operator<<(std::ostream &out, const std::pair<VertexCacheStats, VertexCacheStats> &stats) {
+    return out << "ACMR " << stats.first.acmr << " -> " << stats.second.acmr
+               << ", ATVR " << stats.first.atvr << " -> " << stats.second.atvr;
+}
+
+static ShapeMesh generateShapeMesh(PrimitiveType type, int param1, int param2) {
+
+    switch (type) {
+    case PrimitiveType::PRIMITIVE_SPHERE:
+        return Sphere::generateSphereData(param1, param2);
+    case PrimitiveType::PRIMITIVE_CUBE:
+        return Cube::generateCubeData(param1);
+    case PrimitiveType::PRIMITIVE_CYLINDER:
+        return Cylinder::generateCylinderData(param1, param2);
+    case PrimitiveType::PRIMITIVE_CONE:
+        return Cone::generateConeData(param1, param2);
+    default:
+        return ShapeMesh();
+    }
+
+}
+
+// Loads and optimizes the OBJ file at path, then builds its levels of detail and splits
+// each into meshlets. stats is how well the full level reuses the vertex cache.
+// @return  false if the file could not be loaded
+static bool importMesh(const std::string &path, const MeshLodOptions &lodOptions, ShapeMesh &mesh,
+                       std::vector<MeshLod> &lods, std::vector<Meshlet> &meshlets, VertexCacheStats &stats) {
+
+    if (!loadObjMesh(path, mesh)) {
+        return false;
+    }
+    stats = optimizeMesh(mesh).second;
+
+    lods = buildMeshLods(mesh, lodOptions);
+    for (MeshLod &lod : lods) {
+        std::vector<Meshlet> levelMeshlets = buildMeshlets(mesh, lod.indexOffset, lod.indexOffset + lod.indexCount);
+        lod.meshletOffset = meshlets.size();
+        lod.meshletCount = levelMeshlets.size();
+        meshlets.insert(meshlets.end(), levelMeshlets.begin(), levelMeshlets.end());
+    }
+    return true;
+
+}
+
+// Attaches a mesh's levels and meshlets to its uploaded geometry, which then draws the
+// full level by default. radius bounds the vertices, which every level shares.
+static void setMeshLods(ShapeGeometry &geometry, std::vector<MeshLod> lods, std::vector<Meshlet> meshlets,
+                        float radius) {
+
+    geometry.lods = std::move(lods);
+    geometry.meshlets = std::move(meshlets);
+    geometry.indices = geometry.lods[0].indexCount;
+    geometry.radius = radius;
+
+}
+
+GeometryCache::~GeometryCache() {
+    // Realtime::finish() clears the cache while the context is still current
+    clear();
+}
+
+// Suballocates a shape's vertices, already in format, and its indices from the arena for
+// format. The per-instance buffers are filled during rendering.
+size_t GeometryCache::upload(ShapeGeometry &geometry, const void *vertexData, size_t vertexCount,
+                             const GLuint *indices, size_t indexCount, VertexFormat format) {
+
+    GeometryArena &shapes = arena(format);
+    GeometryArena::Allocation allocation = shapes.allocate(vertexData, vertexCount, indices, indexCount);
+
+    geometry.vao = shapes.vao();
+    geometry.baseVertex = allocation.baseVertex;
+    geometry.firstIndex = allocation.firstIndex;
+    geometry.indices = indexCount;
+    geometry.vertices = vertexCount;
+
+    return vertexCount * shapes.vertexSize() + indexCount * sizeof(GLuint);
+
+}
+
+// Uploads a generated or loaded mesh, packing its vertices first if format asks for it
+size_t GeometryCache::upload(ShapeGeometry &geometry, const ShapeMesh &mesh, VertexFormat format) {
+
+    if (format == VertexFormat::Packed) {
+        std::vector<PackedVertex> packed = packVertices(mesh.vertices);
+        return upload(geometry, packed.data(), packed.size(), mesh.indices.data(), mesh.indices.size(), format);
+    }
+
+    return upload(geometry, mesh.vertices.data(), mesh.vertices.size() / 6,
+                  mesh.indices.data(), mesh.indices.size(), format);
+
+}
+
+// Indices allocated for a shape. A mesh's coarser levels follow its full one.
+static size_t allocatedIndices(const ShapeGeometry &geometry) {
+    if (geometry.lods.empty()) {
+        return geometry.indices;
+    }
+    return geometry.lods.back().indexOffset + geometry.lods.back().indexCount;
+}
+
+// Returns a shape's ranges to its arena
+void GeometryCache::remove(const ShapeGeometry &geometry, VertexFormat format) {
+    arena(format).free({geometry.baseVertex, geometry.firstIndex}, geometry.vertices, allocatedIndices(geometry));
+}
+
+// The smallest parameters each generator accepts
+static void clampParameters(PrimitiveType type, int &param1, int &param2) {
+
+    switch (type) {
+    case PrimitiveType::PRIMITIVE_SPHERE:
+        param1 = glm::max(2, param1);
+        param2 = glm::max(2, param2);
+        break;
+    case PrimitiveType::PRIMITIVE_CUBE:
+        // The cube only has one parameter
+        param1 = glm::max(1, param1);
+        param2 = 0;
+        break;
+    case PrimitiveType::PRIMITIVE_CYLINDER:
+        param1 = glm::max(1, param1);
+        param2 = glm::max(3, param2);
+        break;
+    case PrimitiveType::PRIMITIVE_CONE:
+        param1 = glm::max(1, param1);
+        param2 = glm::max(2, param2);
+        break;
+    default:
+        break;
+    }
+
+}
+
+const ShapeGeometry &GeometryCache::get(PrimitiveType type, int param1, int param2, int lod,
+                                        VertexFormat format) {
+
+    param1 >>= lod;
+    param2 >>= lod;
+    clampParameters(type, param1, param2);
+
+    Key key(type, param1, param2, format);
+    auto found = m_index.find(key);
+    if (found != m_index.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, found->second);
+        return found->second->geometry;
+    }
+
+    ShapeMesh mesh = generateShapeMesh(type, param1, param2);
+
+    Entry entry;
+    entry.key = key;
+
+    std::cout << "Shape: " << primitiveName(type) << " " << param1 << " x " << param2 << ", "
+              << mesh.vertices.size() / 6 << " vertices, " << mesh.indices.size() / 3 << " triangles, ";
+
+    if (mesh.indices.size() > kInlineOptimizeIndices) {
+
+        entry.bytes = upload(entry.geometry, mesh, format);
+        m_optimizing[key] = std::async(std::launch::async, [mesh = std::move(mesh), format]() mutable {
+            auto start = Clock::now();
+            Optimized optimized;
+            auto stats = optimizeMesh(mesh);
+            if (format == VertexFormat::Packed) {
+                optimized.packed = packVertices(mesh.vertices);
+            }
+            optimized.mesh = std::move(mesh);
+            optimized.before = stats.first;
+            optimized.after = stats.second;
+            optimized.milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            return optimized;
+        });
+        std::cout << "reordering in the background" << std::endl;
+
+    } else {
+
+        auto stats = optimizeMesh(mesh);
+        entry.bytes = upload(entry.geometry, mesh, format);
+        std::cout << stats << std::endl;
+
+    }
+
+    m_entries.push_front(entry);
+    m_index[key] = m_entries.begin();
+    m_bytes += entry.bytes;
+
+    evict();
+    return m_entries.front().geometry;
+
+}
+
+// Modification time of the file at path, or the epoch if it does not exist
+static std::filesystem::file_time_type modifiedTime(const std::string &path) {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type() : time;
+}
+
+// Runs on a worker thread, so it makes no GL calls
+std::unique_ptr<GeometryCache::LoadedMesh> GeometryCache::loadMesh(const std::string &path, bool useMeshCache,
+                                                                   const MeshLodOptions &lodOptions) {
+
+    auto start = Clock::now();
+    auto loaded = std::make_unique<LoadedMesh>();
+
+    // The cached mesh is already optimized. It is copied out of the mapping here, so the
+    // file is read on this thread rather than during the upload.
+    MappedMesh cached;
+    loaded->fromCache = useMeshCache && MeshCache::load(path, lodOptions, cached);
+    if (loaded->fromCache) {
+
+        ShapeMesh &mesh = loaded->mesh;
+        mesh.vertices.assign(cached.vertices, cached.vertices + 6 * cached.vertexCount);
+        mesh.indices.assign(cached.indices, cached.indices + cached.indexCount);
+        loaded->lods.assign(cached.lods, cached.lods + cached.lodCount);
+        loaded->meshlets.assign(cached.meshlets, cached.meshlets + cached.meshletCount);
+        loaded->radius = cached.radius;
+        loaded->stats = analyzeVertexCache(cached.indices, cached.lods[0].indexCount, cached.vertexCount);
+
+    } else {
+
+        if (!importMesh(path, lodOptions, loaded->mesh, loaded->lods, loaded->meshlets, loaded->stats)) {
+            return nullptr;
+        }
+
+        if (useMeshCache) {
+            MeshCache::store(path, lodOptions, loaded->mesh, loaded->lods, loaded->meshlets);
+        }
+        loaded->radius = boundingRadius(loaded->mesh);
+
+    }
+
+    loaded->milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return loaded;
+
+}
+
+const ShapeGeometry &GeometryCache::getMesh(const std::string &path, bool useMeshCache) {
+
+    static const ShapeGeometry notLoaded = ShapeGeometry();
+
+    auto found = m_meshes.find(path);
+    if (found != m_meshes.end()) {
+        return found->second.geometry;
+    }
+    if (m_loadingMeshes.count(path)) {
+        return notLoaded;
+    }
+
+    std::filesystem::file_time_type sourceTime = modifiedTime(path);
+    auto failed = m_failedMeshes.find(path);
+    if (failed != m_failedMeshes.end()) {
+        if (failed->second == sourceTime) {
+            return notLoaded;
+        }
+        m_failedMeshes.erase(failed);
+    }
+
+    // The rest start as these finish and the meshes are requested again
+    if (m_loadingMeshes.size() >= kMaxMeshLoads) {
+        return notLoaded;
+    }
+
+    MeshLodOptions lodOptions = m_meshLodOptions;
+    PendingMesh &pending = m_loadingMeshes[path];
+    pending.sourceTime = sourceTime;
+    pending.load = std::async(std::launch::async, [path, useMeshCache, lodOptions]() {
+        return loadMesh(path, useMeshCache, lodOptions);
+    });
+    return notLoaded;
+
+}
+
+bool GeometryCache::meshLoadFinished() const {
+
+    for (const auto &[path, pending] : m_loadingMeshes) {
+        if (isReady(pending.load)) {
+            return true;
+        }
+    }
+    return false;
+
+}
+
+bool GeometryCache::collectMeshes() {
+
+    std::erase_if(m_abandonedMeshes, isReady<std::unique_ptr<LoadedMesh>>);
+
+    bool finished = false;
+    for (auto it = m_loadingMeshes.begin(); it != m_loadingMeshes.end();) {
+        if (!isReady(it->second.load)) {
+            ++it;
+            continue;
+        }
+        finished = true;
+
+        const std::string &path = it->first;
+        std::unique_ptr<LoadedMesh> loaded = it->second.load.get();
+        if (!loaded) {
+            m_failedMeshes[path] = it->second.sourceTime;
+            it = m_loadingMeshes.erase(it);
+            continue;
+        }
+
+        Entry &entry = m_meshes[path];
+        entry.geometry = ShapeGeometry();
+        entry.bytes = upload(entry.geometry, loaded->mesh, VertexFormat::Float);
+        setMeshLods(entry.geometry, std::move(loaded->lods), std::move(loaded->meshlets), loaded->radius);
+        m_meshBytes += entry.bytes;
+
+        std::cout << "Mesh: " << path << ", " << loaded->mesh.vertices.size() / 6 << " vertices, "
+                  << entry.geometry.indices / 3 << " triangles, "
+                  << "ACMR " << loaded->stats.acmr << ", ATVR " << loaded->stats.atvr << ", "
+                  << entry.geometry.lods.size() << " levels, " << entry.geometry.meshlets.size() << " meshlets, "
+                  << (loaded->fromCache ? "loaded from cache" : "imported") << " in "
+                  << loaded->milliseconds << " ms" << std::endl;
+
+        it = m_loadingMeshes.erase(it);
+    }
+
+    return finished;
+
+}
+
+bool GeometryCache::optimizeFinished() const {
+
+    for (const auto &[key, optimizing] : m_optimizing) {
+        if (isReady(optimizing)) {
+            return true;
+        }
+    }
+    return false;
+
+}
+
+void GeometryCache::collectOptimized() {
+
+    std::erase_if(m_abandoned, isReady<Optimized>);
+
+    for (auto it = m_optimizing.begin(); it != m_optimizing.end();) {
+        if (!isReady(it->second)) {
+            ++it;
+            continue;
+        }
+
+        // Evicting a tessellation abandons its reorder, so it is still resident
+        const Key &key = it->first;
+        Optimized optimized = it->second.get();
+        const ShapeGeometry &geometry = m_index.at(key)->geometry;
+        const ShapeMesh &mesh = optimized.mesh;
+
+        // Dropping unused vertices can only shrink the mesh, so it still fits
+        GeometryArena::Allocation allocation = {geometry.baseVertex, geometry.firstIndex};
+        if (std::get<3>(key) == VertexFormat::Packed) {
+            m_packedArena.update(allocation, optimized.packed.data(), optimized.packed.size(),
+                                 mesh.indices.data(), mesh.indices.size());
+        } else {
+            m_floatArena.update(allocation, mesh.vertices.data(), mesh.vertices.size() / 6,
+                                mesh.indices.data(), mesh.indices.size());
+        }
+
+        std::cout << "Shape: " << primitiveName(std::get<0>(key)) << " " << std::get<1>(key) << " x "
+                  << std::get<2>(key) << ", " << std::make_pair(optimized.before, optimized.after)
+                  << ", reordered in " << optimized.milliseconds << " ms" << std::endl;
+
+        it = m_optimizing.erase(it);
+    }
+
+}
+
+void GeometryCache::setMeshLodOptions(const MeshLodOptions &options) {
+
+    if (options == m_meshLodOptions) {
+        return;
+    }
+    releaseMeshes({});
+    m_meshLodOptions = options;
+
+}
+
+void GeometryCache::releaseMeshes(const std::unordered_set<std::string> &used) {
+
+    for (auto it = m_meshes.begin(); it != m_meshes.end();) {
+        if (used.count(it->first)) {
+            ++it;
+            continue;
+        }
+        remove(it->second.geometry, VertexFormat::Float);
+        m_meshBytes -= it->second.bytes;
+        it = m_meshes.erase(it);
+    }
+
+    for (auto it = m_loadingMeshes.begin(); it != m_loadingMeshes.end();) {
+        if (used.count(it->first)) {
+            ++it;
+            continue;
+        }
+        m_abandonedMeshes.push_back(std::move(it->second.load));
+        it = m_loadingMeshes.erase(it);
+    }
+
+    std::erase_if(m_failedMeshes, [&used](const auto &failed) { return !used.count(failed.first); });
+
+}
+
+void GeometryCache::clear() {
+
+    // Waits for the reorders and loads still running
+    m_optimizing.clear();
+    m_abandoned.clear();
+
+    m_entries.clear();
+    m_index.clear();
+    m_bytes = 0;
+
+    releaseMeshes({});
+    m_abandonedMeshes.clear();
+
+    m_floatArena.release();
+    m_packedArena.release();
+
+}
+
+bool GeometryCache::compact() {
+
+    bool compacted = false;
+    for (GeometryArena *shapes : {&m_floatArena, &m_packedArena}) {
+        if (!shapes->sparse()) {
+            continue;
+        }
+
+        // Meshes are always floats
+        std::vector<ShapeGeometry *> geometries;
+        for (Entry &entry : m_entries) {
+            if (std::get<3>(entry.key) == shapes->format()) {
+                geometries.push_back(&entry.geometry);
+            }
+        }
+        if (shapes->format() == VertexFormat::Float) {
+            for (auto &[path, entry] : m_meshes) {
+                geometries.push_back(&entry.geometry);
+            }
+        }
+
+        std::vector<GeometryArena::Block> blocks;
+        for (const ShapeGeometry *geometry : geometries) {
+            blocks.push_back({{geometry->baseVertex, geometry->firstIndex}, size_t(geometry->vertices),
+                              allocatedIndices(*geometry)});
+        }
+
+        size_t capacity = shapes->capacityBytes();
+        shapes->compact(blocks);
+        for (size_t i = 0; i < geometries.size(); i++) {
+            geometries[i]->baseVertex = blocks[i].allocation.baseVertex;
+            geometries[i]->firstIndex = blocks[i].allocation.firstIndex;
+        }
+
+        std::cout << "Compacted " << (shapes->format() == VertexFormat::Packed ? "packed" : "float")
+                  << " shape buffers from " << capacity / (1024 * 1024) << " MB to "
+                  << shapes->capacityBytes() / (1024 * 1024) << " MB" << std::endl;
+        compacted = true;
+    }
+    return compacted;
+
+}
+
+void GeometryCache::evict() {
+
+    while (m_bytes > m_maxBytes && m_entries.size() > kMinResident) {
+        const Entry &entry = m_entries.back();
+        remove(entry.geometry, std::get<3>(entry.key));
+        m_bytes -= entry.bytes;
+
+        auto optimizing = m_optimizing.find(entry.key);
+        if (optimizing != m_optimizing.end()) {
+            m_abandoned.push_back(std::move(optimizing->second));
+            m_optimizing.erase(optimizing);
+        }
+
+        m_index.erase(entry.key);
+        m_entries.pop_back();
+    }
+
+}
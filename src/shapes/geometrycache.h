@@ -0,0 +1,198 @@
+#pragma once
+
+#include "shapes/geometryarena.h"
+#include "shapes/meshlet.h"
+#include "shapes/shape.h"
+#include "shapes/simplify.h"
+#include "shapes/vertexcache.h"
+#include "utils/scenedata.h"
+
+#include <filesystem>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+// Where a shape lies in the GeometryArena of its vertex format. Draw it with the arena's
+// vertex array, from firstIndex, with baseVertex added to its indices.
+struct ShapeGeometry {
+
+    GLuint vao;         // the arena's; 0 if the geometry is not loaded
+    GLint baseVertex;
+    GLuint firstIndex;
+    int indices;        // of the full level of detail
+    int vertices;
+
+    // Only meshes have these. Their levels of detail follow one another from firstIndex,
+    // with offsets relative to it, and each is split into meshlets, which are culled per
+    // instance.
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    float radius = 0.f;     // of the sphere around the origin bounding the mesh
+
+};
+
+// Keeps recently used tessellations of the unit primitives resident on the GPU, so
+// switching scenes or moving the tessellation sliders back and forth does not
+// regenerate and re-upload them.
+//
+// Least recently used tessellations are deleted once the resident ones exceed the
+// budget, and compact() gives their space back. All calls need the GL context current.
+//
+// Every shape is suballocated from one GeometryArena per vertex format, so shapes of one
+// format all draw through the same vertex array.
+//
+// It also holds the meshes loaded from files, one per file however many primitives use it.
+//
+// Large tessellations are first uploaded in the order they were generated, and reordered
+// for the vertex cache on a worker thread, which takes seconds at the highest ones.
+// collectOptimized() writes the new order over the old one once it is done. Meshes are
+// loaded on worker threads too, and uploaded by collectMeshes().
+class GeometryCache {
+public:
+    // Each level of detail halves the tessellation parameters of the one before, down to
+    // the shape's minimum. Level 0 is the full tessellation.
+    static const int kLodLevels = 4;
+
+    // Tessellations with more indices than this are reordered on a worker thread
+    static const size_t kInlineOptimizeIndices = 3 * 64 * 1024;
+
+    // Meshes loading at once; each import is itself spread over every core
+    static const size_t kMaxMeshLoads = 4;
+
+    explicit GeometryCache(size_t maxBytes = kMaxBytes) : m_maxBytes(maxBytes) {}
+    ~GeometryCache();
+
+    // Geometry for the primitive tessellated with param1 and param2 at level of detail
+    // lod, with its vertices in format, generated and uploaded if it is not resident. It
+    // stays valid until kMinResident other tessellations have been requested since.
+    // Levels that come out the same as the one before share its geometry.
+    const ShapeGeometry &get(PrimitiveType type, int param1, int param2, int lod = 0,
+                             VertexFormat format = VertexFormat::Float);
+
+    // Geometry for the OBJ file at path. The first request starts loading it on a worker
+    // thread, and its vao is 0 until collectMeshes() uploads it. It is also 0 if the file
+    // could not be loaded; the load is retried once the file is modified.
+    // Its vertices are always floats, since meshes are not confined to the unit cube the
+    // packed format covers. With useMeshCache, it is read from the file's MeshCache, which
+    // is written on import. Its levels of detail and their meshlets are built on import
+    // and cached with it.
+    const ShapeGeometry &getMesh(const std::string &path, bool useMeshCache = true);
+
+    // Whether a mesh has finished loading since the last collectMeshes()
+    bool meshLoadFinished() const;
+
+    // Uploads the meshes that finished loading.
+    // @return  true if any load finished, so meshes should be requested again: that picks
+    //          up the new ones, and starts the loads waiting for a free slot
+    bool collectMeshes();
+
+    // Build meshes' levels of detail with options from now on. Meshes built with other
+    // options are released.
+    void setMeshLodOptions(const MeshLodOptions &options);
+    const MeshLodOptions &meshLodOptions() const { return m_meshLodOptions; }
+
+    // Whether a tessellation has been reordered since the last collectOptimized()
+    bool optimizeFinished() const;
+
+    // Writes the order of each tessellation reordered since over its old one. Its vertices
+    // and indices stay where they are, so geometry already handed out stays valid.
+    void collectOptimized();
+
+    // Delete the meshes whose paths are not in used, and stop waiting for their loads.
+    void releaseMeshes(const std::unordered_set<std::string> &used);
+
+    // Delete every resident tessellation and mesh.
+    void clear();
+
+    // Moves the resident geometry of each sparse arena together into smaller buffers, and
+    // deletes the buffers of arenas left empty. Geometry handed out before is stale if it
+    // returns true, and must be requested again.
+    bool compact();
+
+    size_t residentBytes() const { return m_bytes + m_meshBytes; }
+
+    // Size of the arenas' buffers, including the space freed by evictions since compact()
+    size_t arenaBytes() const { return m_floatArena.capacityBytes() + m_packedArena.capacityBytes(); }
+
+private:
+    // One chain of levels of each primitive is drawn at a time, so those are never evicted
+    static const size_t kMinResident = 4 * kLodLevels;
+    static const size_t kMaxBytes = 256 * 1024 * 1024;
+
+    using Key = std::tuple<PrimitiveType, int, int, VertexFormat>;
+
+    struct Entry {
+        Key key;
+        ShapeGeometry geometry;
+        size_t bytes;
+    };
+
+    GeometryArena &arena(VertexFormat format) {
+        return format == VertexFormat::Packed ? m_packedArena : m_floatArena;
+    }
+
+    // @return  the bytes uploaded
+    size_t upload(ShapeGeometry &geometry, const void *vertexData, size_t vertexCount,
+                  const GLuint *indices, size_t indexCount, VertexFormat format);
+    size_t upload(ShapeGeometry &geometry, const ShapeMesh &mesh, VertexFormat format);
+    void remove(const ShapeGeometry &geometry, VertexFormat format);
+    void evict();
+
+    // A tessellation reordered on a worker thread
+    struct Optimized {
+        ShapeMesh mesh;
+        std::vector<PackedVertex> packed;   // mesh's vertices, if the tessellation is packed
+        VertexCacheStats before;
+        VertexCacheStats after;
+        double milliseconds;
+    };
+
+    GeometryArena m_floatArena{VertexFormat::Float};
+    GeometryArena m_packedArena{VertexFormat::Packed};
+
+    std::list<Entry> m_entries;                                 // most recently used first
+    std::map<Key, std::list<Entry>::iterator> m_index;
+    size_t m_bytes = 0;
+    size_t m_maxBytes;
+
+    // A mesh loaded on a worker thread, ready to upload
+    struct LoadedMesh {
+        ShapeMesh mesh;
+        std::vector<MeshLod> lods;
+        std::vector<Meshlet> meshlets;
+        float radius;
+        VertexCacheStats stats;     // of the full level
+        bool fromCache;
+        double milliseconds;
+    };
+
+    using MeshLoad = std::future<std::unique_ptr<LoadedMesh>>;     // null result if loading failed
+
+    struct PendingMesh {
+        MeshLoad load;
+        std::filesystem::file_time_type sourceTime;     // when the load started
+    };
+
+    static std::unique_ptr<LoadedMesh> loadMesh(const std::string &path, bool useMeshCache,
+                                                const MeshLodOptions &lodOptions);
+
+    std::map<Key, std::future<Optimized>> m_optimizing;
+    // Those of tessellations evicted before they were done, kept until they are so
+    // destroying their futures does not block
+    std::vector<std::future<Optimized>> m_abandoned;
+
+    // Meshes stay until released, since scenes keep drawing them
+    std::unordered_map<std::string, Entry> m_meshes;
+    size_t m_meshBytes = 0;
+    MeshLodOptions m_meshLodOptions;
+
+    std::unordered_map<std::string, PendingMesh> m_loadingMeshes;
+    std::vector<MeshLoad> m_abandonedMeshes;    // released or built with other options
+    // Meshes that failed to load, to the modification time of their files then
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_failedMeshes;
+};
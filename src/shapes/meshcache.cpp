@@ -0,0 +1,255 @@
+#include "meshcache.h"
+#include "utils/hash.h"
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <type_traits>
+
+#include <QSaveFile>
+
+namespace {
+
+const char kMagic[8] = {'R', 'T', 'M', 'E', 'S', 'H', '\0', '\0'};
+const uint32_t kVersion = 6;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+
+    uint64_t sourcePathHash;
+    int64_t sourceTime;
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+
+    int32_t lodLevels;
+    float lodRatio;
+
+    float radius;
+    uint32_t padding;
+
+    uint64_t vertexCount;
+    uint64_t vertexOffset;
+    uint64_t indexCount;
+    uint64_t indexOffset;
+    uint64_t meshletCount;
+    uint64_t meshletOffset;
+    uint64_t lodCount;
+    uint64_t lodOffset;
+};
+
+static_assert(std::is_trivially_copyable_v<CacheHeader>);
+static_assert(std::is_trivially_copyable_v<Meshlet>);
+static_assert(std::is_trivially_copyable_v<MeshLod>);
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + 15) & ~uint64_t(15);
+}
+
+// Whether a section of count elements lies inside the file; divides rather than
+// multiplies, as the count may be garbage
+bool sectionFits(uint64_t offset, uint64_t count, uint64_t elemSize, uint64_t fileSize) {
+    return offset <= fileSize && count <= (fileSize - offset) / elemSize;
+}
+
+// What identifies the source without reading it
+struct SourceStamp {
+    uint64_t pathHash;
+    int64_t time;
+    uint64_t size;
+};
+
+bool stampSourceFile(const std::string &path, SourceStamp &stamp) {
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::absolute(path, error).lexically_normal();
+    auto time = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+
+    std::string normalized = absolute.string();
+    stamp.pathHash = hashBytes(normalized.data(), normalized.size());
+    stamp.time = time.time_since_epoch().count();
+    stamp.size = size;
+    return true;
+}
+
+// Records stamp as the source of the cache at cachePath, whose contents were found to
+// still match it. Only the path and time can differ, since the size is compared first.
+void restampCache(const std::string &cachePath, const SourceStamp &stamp) {
+    static_assert(offsetof(CacheHeader, sourceTime) == offsetof(CacheHeader, sourcePathHash) + sizeof(uint64_t));
+
+    QFile file(QString::fromStdString(cachePath));
+    if (!file.open(QFile::ReadWrite) || !file.seek(offsetof(CacheHeader, sourcePathHash))) {
+        return;
+    }
+    uint64_t fields[2] = {stamp.pathHash, uint64_t(stamp.time)};
+    file.write(reinterpret_cast<const char *>(fields), sizeof(fields));
+}
+
+bool hashSourceFile(const std::string &path, uint64_t &hash) {
+    MappedFile source(path);
+    if (!source.isOpen()) {
+        return false;
+    }
+
+    hash = hashBytes(source.data(), source.size());
+    return true;
+}
+
+}
+
+std::string MeshCache::cachePath(const std::string &meshPath) {
+    return std::filesystem::path(meshPath).replace_extension(".rtmesh").string();
+}
+
+bool MeshCache::load(const std::string &meshPath, const MeshLodOptions &lodOptions, MappedMesh &mesh) {
+    auto cache = std::make_unique<MappedFile>(cachePath(meshPath));
+    if (!cache->isOpen() || cache->size() < sizeof(CacheHeader)) {
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, cache->data(), sizeof(CacheHeader));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.headerSize != sizeof(CacheHeader)) {
+        return false;
+    }
+    if (header.lodLevels != lodOptions.levels || header.lodRatio != lodOptions.ratio) {
+        return false;
+    }
+
+    if (!sectionFits(header.vertexOffset, header.vertexCount, 6 * sizeof(float), cache->size())
+        || !sectionFits(header.indexOffset, header.indexCount, sizeof(GLuint), cache->size())
+        || !sectionFits(header.meshletOffset, header.meshletCount, sizeof(Meshlet), cache->size())
+        || !sectionFits(header.lodOffset, header.lodCount, sizeof(MeshLod), cache->size())
+        || header.vertexOffset % alignof(float) != 0 || header.indexOffset % alignof(GLuint) != 0
+        || header.meshletOffset % alignof(Meshlet) != 0 || header.lodOffset % alignof(MeshLod) != 0) {
+        std::cout << "mesh cache " << cachePath(meshPath) << " is truncated" << std::endl;
+        return false;
+    }
+
+    // Only read the source if it looks different from when the cache was written
+    SourceStamp stamp;
+    if (!stampSourceFile(meshPath, stamp) || stamp.size != header.sourceSize) {
+        return false;
+    }
+    bool moved = stamp.pathHash != header.sourcePathHash || stamp.time != header.sourceTime;
+    if (moved) {
+        uint64_t sourceHash;
+        if (!hashSourceFile(meshPath, sourceHash) || sourceHash != header.sourceHash) {
+            return false;
+        }
+    }
+
+    const GLuint *indices = reinterpret_cast<const GLuint *>(cache->data() + header.indexOffset);
+    for (uint64_t i = 0; i < header.indexCount; i++) {
+        if (indices[i] >= header.vertexCount) {
+            std::cout << "mesh cache " << cachePath(meshPath) << " is corrupt" << std::endl;
+            return false;
+        }
+    }
+
+    const Meshlet *meshlets = reinterpret_cast<const Meshlet *>(cache->data() + header.meshletOffset);
+    for (uint64_t i = 0; i < header.meshletCount; i++) {
+        if (meshlets[i].indexCount % 3 != 0 || meshlets[i].indexOffset > header.indexCount
+            || meshlets[i].indexCount > header.indexCount - meshlets[i].indexOffset) {
+            std::cout << "mesh cache " << cachePath(meshPath) << " is corrupt" << std::endl;
+            return false;
+        }
+    }
+
+    const MeshLod *lods = reinterpret_cast<const MeshLod *>(cache->data() + header.lodOffset);
+    bool lodsValid = header.lodCount > 0;
+    for (uint64_t i = 0; i < header.lodCount && lodsValid; i++) {
+        lodsValid = lods[i].indexOffset <= header.indexCount
+                    && lods[i].indexCount <= header.indexCount - lods[i].indexOffset
+                    && lods[i].meshletOffset <= header.meshletCount
+                    && lods[i].meshletCount <= header.meshletCount - lods[i].meshletOffset;
+    }
+    if (!lodsValid) {
+        std::cout << "mesh cache " << cachePath(meshPath) << " is corrupt" << std::endl;
+        return false;
+    }
+
+    mesh.vertices = reinterpret_cast<const float *>(cache->data() + header.vertexOffset);
+    mesh.vertexCount = header.vertexCount;
+    mesh.indices = indices;
+    mesh.indexCount = header.indexCount;
+    mesh.meshlets = meshlets;
+    mesh.meshletCount = header.meshletCount;
+    mesh.lods = lods;
+    mesh.lodCount = header.lodCount;
+    mesh.radius = header.radius;
+    mesh.file = std::move(cache);
+
+    if (moved) {
+        restampCache(cachePath(meshPath), stamp);
+    }
+    return true;
+}
+
+bool MeshCache::store(const std::string &meshPath, const MeshLodOptions &lodOptions, const ShapeMesh &mesh,
+                      const std::vector<MeshLod> &lods, const std::vector<Meshlet> &meshlets) {
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(CacheHeader));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(CacheHeader);
+
+    SourceStamp stamp;
+    if (!stampSourceFile(meshPath, stamp) || !hashSourceFile(meshPath, header.sourceHash)) {
+        return false;
+    }
+    header.sourcePathHash = stamp.pathHash;
+    header.sourceTime = stamp.time;
+    header.sourceSize = stamp.size;
+
+    header.lodLevels = lodOptions.levels;
+    header.lodRatio = lodOptions.ratio;
+    header.radius = boundingRadius(mesh);
+
+    header.vertexCount = mesh.vertices.size() / 6;
+    header.vertexOffset = alignUp(sizeof(CacheHeader));
+    header.indexCount = mesh.indices.size();
+    header.indexOffset = alignUp(header.vertexOffset + mesh.vertices.size() * sizeof(float));
+    header.meshletCount = meshlets.size();
+    header.meshletOffset = alignUp(header.indexOffset + mesh.indices.size() * sizeof(GLuint));
+    header.lodCount = lods.size();
+    header.lodOffset = alignUp(header.meshletOffset + meshlets.size() * sizeof(Meshlet));
+
+    std::string path = cachePath(meshPath);
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QFile::WriteOnly)) {
+        std::cout << "could not write mesh cache " << path << std::endl;
+        return false;
+    }
+
+    uint64_t written = 0;
+    auto writeAt = [&](uint64_t offset, const void *data, uint64_t size) {
+        static const char padding[16] = {};
+        file.write(padding, offset - written);
+        file.write(static_cast<const char *>(data), size);
+        written = offset + size;
+    };
+
+    writeAt(0, &header, sizeof(CacheHeader));
+    writeAt(header.vertexOffset, mesh.vertices.data(), mesh.vertices.size() * sizeof(float));
+    writeAt(header.indexOffset, mesh.indices.data(), header.indexCount * sizeof(GLuint));
+    writeAt(header.meshletOffset, meshlets.data(), header.meshletCount * sizeof(Meshlet));
+    writeAt(header.lodOffset, lods.data(), header.lodCount * sizeof(MeshLod));
+
+    if (!file.commit()) {
+        std::cout << "could not write mesh cache " << path << ": "
+                  << file.errorString().toStdString() << std::endl;
+        return false;
+    }
+
+    return true;
+}
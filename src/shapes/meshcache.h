@@ -0,0 +1,50 @@
+#pragma once
+
+#include "shapes/meshlet.h"
+#include "shapes/shape.h"
+#include "shapes/simplify.h"
+#include "utils/mappedfile.h"
+
+#include <memory>
+#include <string>
+
+// A mesh read from its cache file. vertices and indices point into the mapping, so they
+// can be uploaded straight from it; they stay valid while the MappedMesh lives.
+struct MappedMesh {
+    std::unique_ptr<MappedFile> file;
+
+    const float *vertices = nullptr;    // position then normal, 6 floats each
+    size_t vertexCount = 0;
+    const GLuint *indices = nullptr;
+    size_t indexCount = 0;
+    const Meshlet *meshlets = nullptr;
+    size_t meshletCount = 0;
+    const MeshLod *lods = nullptr;
+    size_t lodCount = 0;
+
+    float radius = 0.f;                 // see boundingRadius()
+};
+
+// Compiled binary form of an imported mesh (".rtmesh"), stored next to the source file:
+// its welded, optimized vertices, the indices of all of its levels of detail, their
+// meshlets and the radius bounding the vertices.
+//
+// The cache is keyed by the source's path, modification time and size, and the options its
+// levels of detail were built with. If any of those
+// changed, a content hash of the source decides, so a moved or touched file keeps its
+// cache; its path and time are then rewritten, so the next load need not hash it again.
+class MeshCache {
+public:
+    // Path of the cache file belonging to a mesh file.
+    static std::string cachePath(const std::string &meshPath);
+
+    // Map the cached mesh for meshPath, with levels built with lodOptions, into mesh.
+    // @return  false if there is no cache, or it is stale, corrupt, from another version,
+    //          or its levels were built with other options.
+    static bool load(const std::string &meshPath, const MeshLodOptions &lodOptions, MappedMesh &mesh);
+
+    // Write mesh, its levels of detail and their meshlets as the cache for meshPath.
+    // @return  false if the cache could not be written.
+    static bool store(const std::string &meshPath, const MeshLodOptions &lodOptions, const ShapeMesh &mesh,
+                      const std::vector<MeshLod> &lods, const std::vector<Meshlet> &meshlets);
+};
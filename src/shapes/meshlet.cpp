@@ -0,0 +1,187 @@
+#include "meshlet.h"
+
+#include <algorithm>
+
+// Bounds and normal cone of the triangles in indices[begin, end)
+static Meshlet makeMeshlet(const ShapeMesh &mesh, uint32_t begin, uint32_t end) {
+
+    Meshlet meshlet;
+    meshlet.indexOffset = begin;
+    meshlet.indexCount = end - begin;
+
+    auto position = [&mesh](GLuint index) {
+        return glm::vec3(mesh.vertices[6 * index], mesh.vertices[6 * index + 1], mesh.vertices[6 * index + 2]);
+    };
+
+    glm::vec3 boundsMin(INFINITY), boundsMax(-INFINITY);
+    for (uint32_t i = begin; i < end; i++) {
+        boundsMin = glm::min(boundsMin, position(mesh.indices[i]));
+        boundsMax = glm::max(boundsMax, position(mesh.indices[i]));
+    }
+
+    meshlet.center = (boundsMin + boundsMax) / 2.f;
+    meshlet.radius = 0.f;
+    for (uint32_t i = begin; i < end; i++) {
+        meshlet.radius = glm::max(meshlet.radius, glm::length(position(mesh.indices[i]) - meshlet.center));
+    }
+
+    // Faces are wound counter-clockwise, so these point out of the front faces
+    std::vector<glm::vec3> normals;
+    normals.reserve(meshlet.indexCount / 3);
+    for (uint32_t i = begin; i < end; i += 3) {
+        glm::vec3 a = position(mesh.indices[i]);
+        glm::vec3 normal = glm::cross(position(mesh.indices[i + 1]) - a, position(mesh.indices[i + 2]) - a);
+        float length = glm::length(normal);
+        if (length > 0.f) {
+            normals.push_back(normal / length);
+        }
+    }
+
+    glm::vec3 axis(0.f);
+    for (const glm::vec3 &normal : normals) {
+        axis += normal;
+    }
+
+    meshlet.coneAxis = glm::vec3(0.f, 0.f, 1.f);
+    meshlet.coneCutoff = 2.f;
+
+    float axisLength = glm::length(axis);
+    if (axisLength < 1e-6f) {
+        return meshlet;
+    }
+    axis /= axisLength;
+
+    float minDot = 1.f;
+    for (const glm::vec3 &normal : normals) {
+        minDot = glm::min(minDot, glm::dot(axis, normal));
+    }
+
+    // A cone of 90 degrees or wider always has a normal facing the camera
+    meshlet.coneAxis = axis;
+    if (minDot > 0.f) {
+        meshlet.coneCutoff = glm::sqrt(1.f - minDot * minDot);
+    }
+    return meshlet;
+
+}
+
+std::vector<Meshlet> buildMeshlets(const ShapeMesh &mesh, uint32_t begin, uint32_t end) {
+
+    std::vector<Meshlet> meshlets;
+
+    // The meshlet each vertex was last counted in
+    std::vector<uint32_t> countedIn(mesh.vertices.size() / 6, UINT32_MAX);
+
+    uint32_t first = begin;
+    int vertices = 0;
+
+    auto newVertices = [&](uint32_t i) {
+        uint32_t current = meshlets.size();
+        int count = 0;
+        for (int corner = 0; corner < 3; corner++) {
+            GLuint index = mesh.indices[i + corner];
+            bool repeated = (corner > 0 && index == mesh.indices[i]) || (corner > 1 && index == mesh.indices[i + 1]);
+            count += countedIn[index] != current && !repeated;
+        }
+        return count;
+    };
+
+    for (uint32_t i = begin; i < end; i += 3) {
+
+        int added = newVertices(i);
+        if (vertices + added > kMeshletVertices || (i - first) / 3 >= kMeshletTriangles) {
+            meshlets.push_back(makeMeshlet(mesh, first, i));
+            first = i;
+            vertices = 0;
+            added = newVertices(i);
+        }
+
+        for (int corner = 0; corner < 3; corner++) {
+            countedIn[mesh.indices[i + corner]] = meshlets.size();
+        }
+        vertices += added;
+
+    }
+
+    if (first < end) {
+        meshlets.push_back(makeMeshlet(mesh, first, end));
+    }
+
+    return meshlets;
+
+}
+
+Frustum extractFrustum(const glm::mat4 &viewProjection) {
+
+    auto row = [&viewProjection](int i) {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    Frustum frustum;
+    for (int axis = 0; axis < 3; axis++) {
+        frustum.planes[2 * axis] = row(3) + row(axis);
+        frustum.planes[2 * axis + 1] = row(3) - row(axis);
+    }
+    for (glm::vec4 &plane : frustum.planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+
+}
+
+size_t cullMeshlets(const Meshlet *meshlets, size_t count, GLuint firstIndex, const glm::mat4 &ctm,
+                    const Frustum &frustum, const glm::vec3 &camPosition,
+                    std::vector<GLuint> &counts, std::vector<GLuint> &firstIndices) {
+
+    glm::mat3 linear(ctm);
+    float scaleX = glm::length(linear[0]);
+    float scaleY = glm::length(linear[1]);
+    float scaleZ = glm::length(linear[2]);
+    float scale = glm::max(scaleX, glm::max(scaleY, scaleZ));
+
+    // The cones only carry over to world space under rotation, uniform scale and
+    // translation; a mirroring transform also flips which side is the front
+    float minScale = glm::min(scaleX, glm::min(scaleY, scaleZ));
+    bool coneCulling = glm::determinant(linear) > 0.f && scale - minScale <= 1e-3f * scale;
+
+    size_t first = counts.size();
+    size_t visible = 0;
+
+    for (size_t m = 0; m < count; m++) {
+
+        const Meshlet &meshlet = meshlets[m];
+
+        glm::vec3 center = glm::vec3(ctm * glm::vec4(meshlet.center, 1.f));
+        float radius = meshlet.radius * scale;
+
+        bool outside = false;
+        for (const glm::vec4 &plane : frustum.planes) {
+            outside = outside || glm::dot(glm::vec3(plane), center) + plane.w < -radius;
+        }
+        if (outside) {
+            continue;
+        }
+
+        if (coneCulling && meshlet.coneCutoff <= 1.f) {
+            glm::vec3 axis = glm::normalize(linear * meshlet.coneAxis);
+            glm::vec3 toCenter = center - camPosition;
+            if (glm::dot(toCenter, axis) >= meshlet.coneCutoff * glm::length(toCenter) + radius) {
+                continue;
+            }
+        }
+
+        visible++;
+
+        GLuint start = firstIndex + meshlet.indexOffset;
+        if (counts.size() > first && firstIndices.back() + counts.back() == start) {
+            counts.back() += meshlet.indexCount;
+            continue;
+        }
+        counts.push_back(meshlet.indexCount);
+        firstIndices.push_back(start);
+
+    }
+
+    return visible;
+
+}
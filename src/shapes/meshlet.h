@@ -0,0 +1,46 @@
+#pragma once
+
+#include "shapes/shape.h"
+
+// Splits meshes into small clusters of triangles (meshlets) that can be culled on their
+// own, so a large mesh only pays for the part of it that can be seen.
+//
+// Meshlets are consecutive runs of the mesh's triangles, which optimizeMesh() has already
+// ordered into compact fans, so building them does not reorder the index buffer.
+
+// Limits on each meshlet, the usual sizes for mesh shaders
+const int kMeshletVertices = 64;
+const int kMeshletTriangles = 124;
+
+struct Meshlet {
+    uint32_t indexOffset;       // first of its indices in the mesh
+    uint32_t indexCount;
+
+    // Bounding sphere
+    glm::vec3 center;
+    float radius;
+
+    // Every triangle's normal is within the cone around coneAxis with sine coneCutoff,
+    // widened by the bounding sphere; coneCutoff is above 1 if the normals spread too
+    // far for the meshlet to ever be back-facing as a whole
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+// The planes of a view frustum, pointing inward and normalized, in world space
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+// Meshlets covering the triangles in mesh.indices[begin, end), in order.
+std::vector<Meshlet> buildMeshlets(const ShapeMesh &mesh, uint32_t begin, uint32_t end);
+
+Frustum extractFrustum(const glm::mat4 &viewProjection);
+
+// Culls the count meshlets of an instance with transform ctm seen from camPosition, and appends
+// the index ranges of those left to counts and firstIndices. The mesh's indices start at
+// firstIndex in the index buffer. Neighbouring visible meshlets are merged into one range.
+// @return  the number of visible meshlets
+size_t cullMeshlets(const Meshlet *meshlets, size_t count, GLuint firstIndex, const glm::mat4 &ctm,
+                    const Frustum &frustum, const glm::vec3 &camPosition,
+                    std::vector<GLuint> &counts, std::vector<GLuint> &firstIndices);
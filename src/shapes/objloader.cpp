@@ -0,0 +1,325 @@
+#include "objloader.h"
+
+#include "utils/hash.h"
+#include "utils/mappedfile.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+// Below this, splitting the file costs more than parsing it on one thread
+const size_t kMinChunkBytes = 256 * 1024;
+
+// One corner of a triangle. Positive OBJ indices are global and stored zero-based;
+// relative ones are stored against the chunk's own counts until the chunks are joined.
+struct ObjCorner {
+    int position;
+    int normal;             // -1 if the face has no normals
+    uint8_t relative;       // kRelativePosition | kRelativeNormal
+};
+
+const uint8_t kRelativePosition = 1;
+const uint8_t kRelativeNormal = 2;
+
+struct ObjChunk {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<ObjCorner> corners;     // three per triangle
+    size_t line = 0;                    // first line with an error, or 0
+};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char *skipSpaces(const char *pos, const char *end) {
+    while (pos < end && isSpace(*pos)) {
+        pos++;
+    }
+    return pos;
+}
+
+bool readFloat(const char *&pos, const char *end, float &out) {
+    pos = skipSpaces(pos, end);
+    // from_chars does not take the leading plus some exporters write
+    if (pos < end && *pos == '+') {
+        pos++;
+    }
+    auto result = std::from_chars(pos, end, out);
+    pos = result.ptr;
+    return result.ec == std::errc();
+}
+
+bool readVec3(const char *&pos, const char *end, glm::vec3 &out) {
+    return readFloat(pos, end, out.x) && readFloat(pos, end, out.y) && readFloat(pos, end, out.z);
+}
+
+// Reads one index of a face corner; count is how many of its kind the chunk has so far.
+// Sets relative if it counts back from there.
+bool readIndex(const char *&pos, const char *end, size_t count, int &out, bool &relative) {
+    int index;
+    auto result = std::from_chars(pos, end, index);
+    if (result.ec != std::errc() || index == 0) {
+        return false;
+    }
+    pos = result.ptr;
+    relative = index < 0;
+    out = relative ? int(count) + index : index - 1;
+    return true;
+}
+
+// Reads a corner written as v, v/vt, v//vn or v/vt/vn. Texture coordinates are skipped.
+bool readCorner(const char *&pos, const char *end, const ObjChunk &chunk, ObjCorner &corner) {
+    bool relative;
+    if (!readIndex(pos, end, chunk.positions.size(), corner.position, relative)) {
+        return false;
+    }
+    corner.relative = relative ? kRelativePosition : 0;
+    corner.normal = -1;
+
+    if (pos < end && *pos == '/') {
+        pos++;
+        while (pos < end && *pos != '/' && !isSpace(*pos) && *pos != '\n') {
+            pos++;
+        }
+        if (pos < end && *pos == '/') {
+            pos++;
+            if (!readIndex(pos, end, chunk.normals.size(), corner.normal, relative)) {
+                return false;
+            }
+            corner.relative |= relative ? kRelativeNormal : 0;
+        }
+    }
+
+    return pos == end || isSpace(*pos) || *pos == '\n';
+}
+
+// Reads a face's corners, triangulating it as a fan around the first
+bool readFace(const char *&pos, const char *end, ObjChunk &chunk) {
+    ObjCorner first, previous, corner;
+    int count = 0;
+
+    while (true) {
+        pos = skipSpaces(pos, end);
+        if (pos == end || *pos == '\n' || *pos == '#') {
+            break;
+        }
+        if (!readCorner(pos, end, chunk, corner)) {
+            return false;
+        }
+        if (count >= 2) {
+            chunk.corners.push_back(first);
+            chunk.corners.push_back(previous);
+            chunk.corners.push_back(corner);
+        }
+        if (count == 0) {
+            first = corner;
+        }
+        previous = corner;
+        count++;
+    }
+
+    return count >= 3;
+}
+
+// Parses the lines in [begin, end), which starts and ends on line boundaries
+void parseChunk(const char *begin, const char *end, ObjChunk &chunk) {
+    size_t line = 0;
+
+    for (const char *pos = begin; pos < end; pos++) {
+        line++;
+        pos = skipSpaces(pos, end);
+
+        bool ok = true;
+        if (end - pos >= 2 && pos[0] == 'v' && isSpace(pos[1])) {
+            pos += 2;
+            chunk.positions.emplace_back();
+            ok = readVec3(pos, end, chunk.positions.back());
+        }
+        else if (end - pos >= 3 && pos[0] == 'v' && pos[1] == 'n' && isSpace(pos[2])) {
+            pos += 3;
+            chunk.normals.emplace_back();
+            ok = readVec3(pos, end, chunk.normals.back());
+        }
+        else if (end - pos >= 2 && pos[0] == 'f' && isSpace(pos[1])) {
+            pos += 2;
+            ok = readFace(pos, end, chunk);
+        }
+
+        if (!ok && chunk.line == 0) {
+            chunk.line = line;
+        }
+
+        // Anything else (comments, texture coordinates, groups, materials) is skipped
+        const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        pos = newline ? newline : end;
+    }
+}
+
+// Splits [data, data + size) into up to count pieces that each end on a line break
+std::vector<const char *> splitAtLines(const char *data, size_t size, size_t count) {
+    std::vector<const char *> bounds = {data};
+    const char *end = data + size;
+
+    for (size_t i = 1; i < count; i++) {
+        const char *pos = std::max(bounds.back(), data + size * i / count);
+        const char *newline = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+        if (!newline) {
+            break;
+        }
+        if (newline + 1 > bounds.back()) {
+            bounds.push_back(newline + 1);
+        }
+    }
+
+    if (bounds.back() != end) {
+        bounds.push_back(end);
+    }
+    return bounds;
+}
+
+// Open-addressed table of the mesh's vertices, so identical corners share one
+class VertexWelder {
+public:
+    VertexWelder(ShapeMesh &mesh, size_t corners) : m_mesh(mesh) {
+        size_t capacity = 16;
+        while (capacity < corners * 2) {
+            capacity *= 2;
+        }
+        m_slots.assign(capacity, UINT32_MAX);
+        m_mesh.vertices.reserve(corners * 6);
+    }
+
+    GLuint add(const glm::vec3 &position, const glm::vec3 &normal) {
+        float vertex[6] = {position.x, position.y, position.z, normal.x, normal.y, normal.z};
+        size_t mask = m_slots.size() - 1;
+
+        for (size_t slot = hashBytes(vertex, sizeof(vertex)) & mask;; slot = (slot + 1) & mask) {
+            GLuint index = m_slots[slot];
+            if (index == UINT32_MAX) {
+                index = m_mesh.vertices.size() / 6;
+                m_mesh.vertices.insert(m_mesh.vertices.end(), vertex, vertex + 6);
+                m_slots[slot] = index;
+                return index;
+            }
+            if (std::memcmp(&m_mesh.vertices[6 * index], vertex, sizeof(vertex)) == 0) {
+                return index;
+            }
+        }
+    }
+
+private:
+    ShapeMesh &m_mesh;
+    std::vector<GLuint> m_slots;
+};
+
+}
+
+bool loadObjMesh(const std::string &path, ShapeMesh &mesh) {
+
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cout << "could not open mesh file " << path << std::endl;
+        return false;
+    }
+
+    size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::clamp<size_t>(file.size() / kMinChunkBytes, 1, threadCount);
+    std::vector<const char *> bounds = splitAtLines(file.chars(), file.size(), threadCount);
+
+    std::vector<ObjChunk> chunks(bounds.size() - 1);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < chunks.size(); i++) {
+        threads.emplace_back(parseChunk, bounds[i], bounds[i + 1], std::ref(chunks[i]));
+    }
+    parseChunk(bounds[0], bounds[1], chunks[0]);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // Join the chunks, resolving relative indices against the counts before each
+    std::vector<glm::vec3> positions, normals;
+    std::vector<ObjCorner> corners;
+
+    for (size_t i = 0; i < chunks.size(); i++) {
+
+        ObjChunk &chunk = chunks[i];
+        if (chunk.line != 0) {
+            size_t line = std::count(bounds[0], bounds[i], '\n') + chunk.line;
+            std::cout << "could not parse line " << line << " of mesh file " << path << std::endl;
+            return false;
+        }
+
+        int positionBase = positions.size();
+        int normalBase = normals.size();
+        for (ObjCorner &corner : chunk.corners) {
+            corner.position += corner.relative & kRelativePosition ? positionBase : 0;
+            corner.normal += corner.relative & kRelativeNormal ? normalBase : 0;
+        }
+
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        corners.insert(corners.end(), chunk.corners.begin(), chunk.corners.end());
+        chunk = ObjChunk();
+
+    }
+
+    if (corners.empty()) {
+        std::cout << "mesh file " << path << " has no faces" << std::endl;
+        return false;
+    }
+
+    for (const ObjCorner &corner : corners) {
+        if (corner.position < 0 || corner.position >= int(positions.size())
+            || corner.normal < -1 || corner.normal >= int(normals.size())) {
+            std::cout << "mesh file " << path << " has a face index out of range" << std::endl;
+            return false;
+        }
+    }
+
+    // Smooth normals for the faces without any, weighted by the faces' areas
+    std::vector<glm::vec3> smoothNormals;
+    for (size_t i = 0; i < corners.size(); i += 3) {
+
+        if (corners[i].normal >= 0 && corners[i + 1].normal >= 0 && corners[i + 2].normal >= 0) {
+            continue;
+        }
+        if (smoothNormals.empty()) {
+            smoothNormals.assign(positions.size(), glm::vec3(0.f));
+        }
+
+        glm::vec3 a = positions[corners[i].position];
+        glm::vec3 b = positions[corners[i + 1].position];
+        glm::vec3 c = positions[corners[i + 2].position];
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        for (int corner = 0; corner < 3; corner++) {
+            smoothNormals[corners[i + corner].position] += normal;
+        }
+
+    }
+    // Files do not always normalize theirs
+    for (std::vector<glm::vec3> *list : {&normals, &smoothNormals}) {
+        for (glm::vec3 &normal : *list) {
+            float length = glm::length(normal);
+            normal = length > 0.f ? normal / length : glm::vec3(0.f, 1.f, 0.f);
+        }
+    }
+
+    mesh = ShapeMesh();
+    mesh.indices.reserve(corners.size());
+    VertexWelder welder(mesh, corners.size());
+
+    for (const ObjCorner &corner : corners) {
+        glm::vec3 normal = corner.normal >= 0 ? normals[corner.normal] : smoothNormals[corner.position];
+        mesh.indices.push_back(welder.add(positions[corner.position], normal));
+    }
+
+    mesh.vertices.shrink_to_fit();
+    return true;
+
+}
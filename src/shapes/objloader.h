@@ -0,0 +1,19 @@
+#pragma once
+
+#include "shapes/shape.h"
+
+#include <string>
+
+// Loads triangle meshes from Wavefront OBJ files.
+//
+// The file is memory-mapped and split at line breaks into one chunk per thread, and the
+// chunks are parsed in parallel. Indices in a chunk are resolved against the counts of the
+// chunks before it once all of them are parsed, so relative (negative) indices work too.
+//
+// Only positions, normals and faces are read. Polygons are triangulated as fans, faces
+// without normals get smooth ones averaged from the faces around each position, and
+// corners with the same position and normal are welded into one vertex.
+
+// Loads the OBJ file at path into mesh, in the file's own coordinates.
+// @return  false if the file could not be read, has an index out of range or has no faces
+bool loadObjMesh(const std::string &path, ShapeMesh &mesh);
@@ -0,0 +1,53 @@
+#include "shape.h"
+
+#include <algorithm>
+
+static int16_t toSnorm16(float value) {
+    return (int16_t)std::lround(std::clamp(value, -1.f, 1.f) * 32767.f);
+}
+
+// Projects the unit normal onto the octahedron |x| + |y| + |z| = 1, then folds the lower
+// half over the upper so it unfolds to a square
+static glm::vec2 octahedralEncode(glm::vec3 normal) {
+
+    normal /= std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    glm::vec2 encoded(normal.x, normal.y);
+
+    if (normal.z < 0.f) {
+        encoded.x = (1.f - std::abs(normal.y)) * (normal.x >= 0.f ? 1.f : -1.f);
+        encoded.y = (1.f - std::abs(normal.x)) * (normal.y >= 0.f ? 1.f : -1.f);
+    }
+
+    return encoded;
+}
+
+std::vector<PackedVertex> packVertices(const std::vector<float> &vertices) {
+
+    std::vector<PackedVertex> packed(vertices.size() / 6);
+
+    for (size_t i = 0; i < packed.size(); i++) {
+
+        const float *vertex = &vertices[6 * i];
+        glm::vec2 normal = octahedralEncode(glm::vec3(vertex[3], vertex[4], vertex[5]));
+
+        packed[i].position[0] = toSnorm16(2.f * vertex[0]);
+        packed[i].position[1] = toSnorm16(2.f * vertex[1]);
+        packed[i].position[2] = toSnorm16(2.f * vertex[2]);
+        packed[i].position[3] = 0;
+        packed[i].normal[0] = toSnorm16(normal.x);
+        packed[i].normal[1] = toSnorm16(normal.y);
+
+    }
+
+    return packed;
+}
+
+float boundingRadius(const ShapeMesh &mesh) {
+
+    float radius = 0.f;
+    for (size_t i = 0; i < mesh.vertices.size(); i += 6) {
+        radius = std::max(radius, glm::length(glm::vec3(mesh.vertices[i], mesh.vertices[i + 1], mesh.vertices[i + 2])));
+    }
+    return radius;
+
+}
@@ -1,6 +1,81 @@
 #pragma once
+#include <cmath>
+#include <cstdint>
 #include <vector>
 #include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// A shape's welded vertices (position then normal, 6 floats each) and the triangles
+// indexing them. Vertices shared by neighbouring tiles are stored once.
+//
+// Generators size both buffers up front with resize() and write them in place.
+struct ShapeMesh {
+
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+
+    void resize(size_t vertexCount, size_t indexCount) {
+        vertices.resize(6 * vertexCount);
+        indices.resize(indexCount);
+    }
+
+};
+
+// Layouts a ShapeMesh's vertices can be uploaded in
+enum class VertexFormat {
+    Float,      // 24 bytes: position and normal as three floats each, as generated
+    Packed      // 12 bytes: see PackedVertex
+};
+
+// The position is four snorm16s holding xyz * 2, so the unit primitives' [-0.5, 0.5] span
+// the full range; w is padding to keep the normal aligned. The normal is
+// octahedral-encoded into two snorm16s. Both decode in default.vert and occlusion.vert.
+struct PackedVertex {
+    int16_t position[4];
+    int16_t normal[2];
+};
+
+// Packs generated vertices (position then normal, 6 floats each)
+std::vector<PackedVertex> packVertices(const std::vector<float> &vertices);
+
+// Radius of the sphere around the origin that holds every vertex of mesh
+float boundingRadius(const ShapeMesh &mesh);
+
+// Writes a vertex at out; returns where the next one goes
+inline float *putVertex(float *out, const glm::vec3 &position, const glm::vec3 &normal) {
+    out[0] = position.x;
+    out[1] = position.y;
+    out[2] = position.z;
+    out[3] = normal.x;
+    out[4] = normal.y;
+    out[5] = normal.z;
+    return out + 6;
+}
+
+// Writes a triangle at out; returns where the next one goes
+inline GLuint *putTriangle(GLuint *out, GLuint a, GLuint b, GLuint c) {
+    out[0] = a;
+    out[1] = b;
+    out[2] = c;
+    return out + 3;
+}
+
+// cos and sin of count + 1 angles, evenly spaced from 0 to range inclusive. Rings of
+// vertices look their angles up here instead of evaluating them per vertex.
+struct AngleTable {
+
+    std::vector<float> cos;
+    std::vector<float> sin;
+
+    AngleTable(int count, float range) : cos(count + 1), sin(count + 1) {
+        for (int i = 0; i <= count; i++) {
+            float angle = i * range / count;
+            cos[i] = std::cos(angle);
+            sin[i] = std::sin(angle);
+        }
+    }
+
+};
 
 class Shape {
 
@@ -0,0 +1,136 @@
+#include "shapetable.h"
+
+#include <algorithm>
+
+// Dirty runs this close together are sent as one range, clean entries and all, since a
+// call costs more than the few bytes between them
+static const uint32_t kMergeGap = 8;
+
+void ShapeTable::set(uint32_t index, const RenderShapeData &shape) {
+    m_models[index] = shape.ctm;
+    m_materials[index] = shape.material;
+    if (!m_isDirty[index]) {
+        m_isDirty[index] = true;
+        m_dirty.push_back(index);
+    }
+}
+
+void ShapeTable::assign(const std::vector<RenderShapeData> &shapes) {
+
+    size_t kept = std::min(shapes.size(), m_models.size());
+
+    if (shapes.size() < m_models.size()) {
+        m_dirty.erase(std::remove_if(m_dirty.begin(), m_dirty.end(),
+                                     [&](uint32_t index) { return index >= shapes.size(); }),
+                      m_dirty.end());
+    }
+    m_models.resize(shapes.size());
+    m_materials.resize(shapes.size());
+    m_isDirty.resize(shapes.size(), false);
+
+    for (size_t i = 0; i < kept; i++) {
+        if (m_models[i] != shapes[i].ctm || m_materials[i] != shapes[i].material) {
+            set(i, shapes[i]);
+        }
+    }
+    for (size_t i = kept; i < shapes.size(); i++) {
+        set(i, shapes[i]);
+    }
+
+}
+
+void ShapeTable::update(const std::vector<RenderShapeData> &shapes, const std::vector<uint32_t> &changed) {
+    if (shapes.size() != m_models.size()) {
+        assign(shapes);
+        return;
+    }
+    for (uint32_t index : changed) {
+        set(index, shapes[index]);
+    }
+}
+
+size_t ShapeTable::upload() {
+
+    if (m_modelBuffer == 0) {
+        glGenBuffers(1, &m_modelBuffer);
+        glGenBuffers(1, &m_materialBuffer);
+        glGenTextures(1, &m_modelTexture);
+        glGenTextures(1, &m_materialTexture);
+    }
+
+    size_t bytes = 0;
+
+    // Keeps the textures valid for empty scenes
+    size_t count = std::max<size_t>(m_models.size(), 1);
+
+    if (count > m_capacity) {
+
+        // Doubling, as streamed chunks grow the scene a little at a time
+        m_capacity = std::max(count, 2 * m_capacity);
+
+        glBindBuffer(GL_TEXTURE_BUFFER, m_modelBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, m_capacity * sizeof(glm::mat4), nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_models.size() * sizeof(glm::mat4), m_models.data());
+
+        glBindBuffer(GL_TEXTURE_BUFFER, m_materialBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, m_capacity * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_materials.size() * sizeof(GLuint), m_materials.data());
+
+        bytes = m_models.size() * (sizeof(glm::mat4) + sizeof(GLuint));
+
+        glBindTexture(GL_TEXTURE_BUFFER, m_modelTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_modelBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, m_materialTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_materialBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    } else if (!m_dirty.empty()) {
+
+        std::sort(m_dirty.begin(), m_dirty.end());
+
+        for (size_t i = 0; i < m_dirty.size();) {
+
+            uint32_t first = m_dirty[i];
+            uint32_t last = first;
+            for (i++; i < m_dirty.size() && m_dirty[i] - last <= kMergeGap; i++) {
+                last = m_dirty[i];
+            }
+            size_t run = last - first + 1;
+
+            glBindBuffer(GL_TEXTURE_BUFFER, m_modelBuffer);
+            glBufferSubData(GL_TEXTURE_BUFFER, first * sizeof(glm::mat4), run * sizeof(glm::mat4), &m_models[first]);
+            glBindBuffer(GL_TEXTURE_BUFFER, m_materialBuffer);
+            glBufferSubData(GL_TEXTURE_BUFFER, first * sizeof(GLuint), run * sizeof(GLuint), &m_materials[first]);
+
+            bytes += run * (sizeof(glm::mat4) + sizeof(GLuint));
+
+        }
+
+    }
+
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    for (uint32_t index : m_dirty) {
+        m_isDirty[index] = false;
+    }
+    m_dirty.clear();
+
+    return bytes;
+
+}
+
+void ShapeTable::release() {
+
+    if (m_modelBuffer == 0) {
+        return;
+    }
+
+    GLuint buffers[] = {m_modelBuffer, m_materialBuffer};
+    glDeleteBuffers(2, buffers);
+    GLuint textures[] = {m_modelTexture, m_materialTexture};
+    glDeleteTextures(2, textures);
+
+    m_modelBuffer = m_materialBuffer = m_modelTexture = m_materialTexture = 0;
+    m_capacity = 0;
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "utils/sceneparser.h"
+
+#include <GL/glew.h>
+
+// Every shape's model matrix and material index, kept on the GPU as two texture buffers
+// the phong shader looks up with each instance's shape index. Instances then only carry
+// that index, so the table stays put from frame to frame however the shapes are batched.
+//
+// The table keeps a copy of what it last uploaded. Changed entries are marked dirty and
+// only their ranges are sent on the next upload(); the buffers are reallocated, and
+// uploaded whole, only when the scene outgrows them.
+class ShapeTable {
+public:
+    // Brings the table in line with shapes, marking the entries that differ dirty
+    void assign(const std::vector<RenderShapeData> &shapes);
+
+    // Marks just the changed entries dirty, for when the caller knows which they are. Falls
+    // back to assign() if shapes is no longer the size of the table.
+    void update(const std::vector<RenderShapeData> &shapes, const std::vector<uint32_t> &changed);
+
+    // Sends the dirty ranges to the GPU. Needs the GL context current.
+    // @return  the bytes uploaded
+    size_t upload();
+
+    // Deletes the buffers and textures; the next upload() starts over
+    void release();
+
+    GLuint modelTexture() const { return m_modelTexture; }
+    GLuint materialTexture() const { return m_materialTexture; }
+
+private:
+    void set(uint32_t index, const RenderShapeData &shape);
+
+    std::vector<glm::mat4> m_models;
+    std::vector<GLuint> m_materials;
+
+    std::vector<uint32_t> m_dirty;      // entries changed since the last upload, unsorted
+    std::vector<bool> m_isDirty;
+
+    GLuint m_modelBuffer = 0;
+    GLuint m_materialBuffer = 0;
+    GLuint m_modelTexture = 0;
+    GLuint m_materialTexture = 0;
+    size_t m_capacity = 0;              // entries the buffers hold
+};
@@ -0,0 +1,504 @@
+#include "simplify.h"
+
+#include "shapes/vertexcache.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Border planes count this many times as much as the surface, so borders hold their shape
+const float kBorderWeight = 10.f;
+
+// A collapse may turn a triangle's normal by up to about 75 degrees
+const float kMinNormalDot = 0.25f;
+
+// Each level has to drop at least this share of the level before's triangles
+const float kMinReduction = 0.2f;
+
+const GLuint kNone = ~0u;
+
+// Weighted sum of squared distances to a set of planes ax + by + cz + d = 0, as the
+// distinct coefficients of its symmetric 4x4 matrix. weight is the total weight of the
+// planes, which evaluate() divides by, so errors come out as squared distances.
+struct Quadric {
+    float a2, b2, c2, d2;
+    float ab, ac, ad, bc, bd, cd;
+    float weight;
+};
+
+Quadric planeQuadric(const glm::vec3 &normal, float d, float weight) {
+    Quadric q;
+    q.a2 = weight * normal.x * normal.x;
+    q.b2 = weight * normal.y * normal.y;
+    q.c2 = weight * normal.z * normal.z;
+    q.d2 = weight * d * d;
+    q.ab = weight * normal.x * normal.y;
+    q.ac = weight * normal.x * normal.z;
+    q.ad = weight * normal.x * d;
+    q.bc = weight * normal.y * normal.z;
+    q.bd = weight * normal.y * d;
+    q.cd = weight * normal.z * d;
+    q.weight = weight;
+    return q;
+}
+
+Quadric operator+(const Quadric &q, const Quadric &r) {
+    return {q.a2 + r.a2, q.b2 + r.b2, q.c2 + r.c2, q.d2 + r.d2,
+            q.ab + r.ab, q.ac + r.ac, q.ad + r.ad, q.bc + r.bc, q.bd + r.bd, q.cd + r.cd,
+            q.weight + r.weight};
+}
+
+float evaluate(const Quadric &q, const glm::vec3 &p) {
+    if (q.weight <= 0.f) {
+        return 0.f;
+    }
+    float sum = q.a2 * p.x * p.x + q.b2 * p.y * p.y + q.c2 * p.z * p.z + q.d2
+              + 2.f * (q.ab * p.x * p.y + q.ac * p.x * p.z + q.bc * p.y * p.z)
+              + 2.f * (q.ad * p.x + q.bd * p.y + q.cd * p.z);
+    return glm::max(sum, 0.f) / q.weight;
+}
+
+// Distance from p to the nearest point of triangle abc (Ericson, "Real-Time Collision
+// Detection", 5.1.5). Degenerate triangles fall back to their corners.
+float triangleDistance(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+    glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+    if (d1 <= 0.f && d2 <= 0.f) {
+        return glm::length(ap);
+    }
+    glm::vec3 bp = p - b;
+    float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+    if (d3 >= 0.f && d4 <= d3) {
+        return glm::length(bp);
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+        return glm::length(ap - ab * (d1 / (d1 - d3)));
+    }
+    glm::vec3 cp = p - c;
+    float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+    if (d6 >= 0.f && d5 <= d6) {
+        return glm::length(cp);
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+        return glm::length(ap - ac * (d2 / (d2 - d6)));
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f) {
+        return glm::length(bp - (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))));
+    }
+    float sum = va + vb + vc;
+    if (sum <= 0.f) {
+        return glm::min(glm::length(ap), glm::min(glm::length(bp), glm::length(cp)));
+    }
+    return glm::length(ap - ab * (vb / sum) - ac * (vc / sum));
+}
+
+enum class VertexKind : uint8_t {
+    Manifold,   // inside the surface: collapses onto any neighbour
+    Border,     // on one open border: only slides along it
+    Locked      // on a seam or a non-manifold edge: never moves
+};
+
+struct Collapse {
+    GLuint from;
+    GLuint to;
+    float error;
+};
+
+class Simplifier {
+public:
+    Simplifier(const std::vector<float> &vertices, std::vector<GLuint> &indices)
+        : m_vertices(vertices), m_indices(indices), m_vertexCount(vertices.size() / 6),
+          m_collapsedTo(m_vertexCount) {
+        std::iota(m_collapsedTo.begin(), m_collapsedTo.end(), 0);
+        classifyVertices();
+        computeQuadrics();
+    }
+
+    // Collapses edges until at most targetIndexCount indices are left, or no edge can go.
+    void simplify(size_t targetIndexCount) {
+        while (m_indices.size() > targetIndexCount) {
+            if (collapseEdges((m_indices.size() - targetIndexCount) / 3) == 0) {
+                return;
+            }
+        }
+    }
+
+    // Largest distance of a vertex collapsed so far from the surface left around the one
+    // it ended up on. The quadrics only bound each collapse on its own, and underestimate
+    // how far a run of small collapses drifts.
+    float measureError();
+
+private:
+    glm::vec3 position(GLuint v) const {
+        return glm::vec3(m_vertices[6 * v], m_vertices[6 * v + 1], m_vertices[6 * v + 2]);
+    }
+
+    void classifyVertices();
+    void computeQuadrics();
+    void buildAdjacency();
+    bool canCollapse(GLuint from, GLuint to) const;
+    bool flipsTriangle(GLuint from, GLuint to) const;
+    size_t collapseEdges(size_t trianglesToRemove);
+
+    const std::vector<float> &m_vertices;
+    std::vector<GLuint> &m_indices;
+    size_t m_vertexCount;
+
+    std::vector<VertexKind> m_kinds;
+    std::vector<GLuint> m_borderNext;   // along each vertex's open border edge, or kNone
+    std::vector<GLuint> m_borderPrev;
+    std::vector<Quadric> m_quadrics;
+    std::vector<GLuint> m_collapsedTo;  // each vertex's target, or itself
+
+    // The triangles using each vertex: those of vertex v are
+    // m_triangles[m_offsets[v]] .. m_triangles[m_offsets[v + 1]]
+    std::vector<GLuint> m_offsets;
+    std::vector<GLuint> m_triangles;
+};
+
+void Simplifier::classifyVertices() {
+
+    // An edge is on an open border if no triangle runs along it the other way
+    std::vector<uint64_t> edges;
+    edges.reserve(m_indices.size());
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        for (int corner = 0; corner < 3; corner++) {
+            GLuint a = m_indices[i + corner];
+            GLuint b = m_indices[i + (corner + 1) % 3];
+            edges.push_back(uint64_t(a) << 32 | b);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<uint8_t> borderOut(m_vertexCount, 0), borderIn(m_vertexCount, 0);
+    m_borderNext.assign(m_vertexCount, kNone);
+    m_borderPrev.assign(m_vertexCount, kNone);
+
+    for (uint64_t edge : edges) {
+        GLuint a = edge >> 32;
+        GLuint b = edge & 0xffffffffu;
+        if (std::binary_search(edges.begin(), edges.end(), uint64_t(b) << 32 | a)) {
+            continue;
+        }
+        borderOut[a] = std::min(borderOut[a] + 1, 2);
+        borderIn[b] = std::min(borderIn[b] + 1, 2);
+        m_borderNext[a] = b;
+        m_borderPrev[b] = a;
+    }
+
+    m_kinds.assign(m_vertexCount, VertexKind::Manifold);
+    for (size_t v = 0; v < m_vertexCount; v++) {
+        if (borderOut[v] == 1 && borderIn[v] == 1) {
+            m_kinds[v] = VertexKind::Border;
+        } else if (borderOut[v] != 0 || borderIn[v] != 0) {
+            m_kinds[v] = VertexKind::Locked;
+        }
+    }
+
+    // Vertices sharing a position with another were kept apart by their normals
+    std::vector<GLuint> order(m_vertexCount);
+    std::iota(order.begin(), order.end(), 0);
+    auto lexicographic = [this](GLuint a, GLuint b) {
+        return std::lexicographical_compare(&m_vertices[6 * a], &m_vertices[6 * a + 3],
+                                            &m_vertices[6 * b], &m_vertices[6 * b + 3]);
+    };
+    std::sort(order.begin(), order.end(), lexicographic);
+
+    for (size_t i = 1; i < order.size(); i++) {
+        if (position(order[i]) == position(order[i - 1])) {
+            m_kinds[order[i]] = VertexKind::Locked;
+            m_kinds[order[i - 1]] = VertexKind::Locked;
+        }
+    }
+
+}
+
+void Simplifier::computeQuadrics() {
+
+    m_quadrics.assign(m_vertexCount, Quadric{});
+
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+
+        GLuint corners[3] = {m_indices[i], m_indices[i + 1], m_indices[i + 2]};
+        glm::vec3 p0 = position(corners[0]);
+        glm::vec3 normal = glm::cross(position(corners[1]) - p0, position(corners[2]) - p0);
+        float length = glm::length(normal);
+        if (length == 0.f) {
+            continue;
+        }
+        normal /= length;
+
+        // Weighted by area, so small triangles do not outvote large ones
+        Quadric surface = planeQuadric(normal, -glm::dot(normal, p0), length / 2.f);
+        for (GLuint v : corners) {
+            m_quadrics[v] = m_quadrics[v] + surface;
+        }
+
+        // Border edges also hold to the plane standing on them, perpendicular to the surface
+        for (int corner = 0; corner < 3; corner++) {
+            GLuint a = corners[corner];
+            GLuint b = corners[(corner + 1) % 3];
+            if (m_borderNext[a] != b) {
+                continue;
+            }
+            glm::vec3 edge = position(b) - position(a);
+            float edgeLength = glm::length(edge);
+            if (edgeLength == 0.f) {
+                continue;
+            }
+            glm::vec3 side = glm::normalize(glm::cross(edge, normal));
+            Quadric border = planeQuadric(side, -glm::dot(side, position(a)),
+                                          kBorderWeight * edgeLength * edgeLength);
+            m_quadrics[a] = m_quadrics[a] + border;
+            m_quadrics[b] = m_quadrics[b] + border;
+        }
+
+    }
+
+}
+
+void Simplifier::buildAdjacency() {
+
+    m_offsets.assign(m_vertexCount + 1, 0);
+    for (GLuint index : m_indices) {
+        m_offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < m_vertexCount; v++) {
+        m_offsets[v + 1] += m_offsets[v];
+    }
+
+    m_triangles.resize(m_indices.size());
+    std::vector<GLuint> cursor(m_offsets.begin(), m_offsets.end() - 1);
+    for (size_t i = 0; i < m_indices.size(); i++) {
+        m_triangles[cursor[m_indices[i]]++] = i / 3;
+    }
+
+}
+
+bool Simplifier::canCollapse(GLuint from, GLuint to) const {
+
+    switch (m_kinds[from]) {
+    case VertexKind::Manifold:
+        return true;
+    case VertexKind::Border:
+        // A border loop down to two edges has nothing left to slide along
+        return (m_borderNext[from] == to || m_borderPrev[from] == to)
+               && m_kinds[to] != VertexKind::Manifold
+               && m_borderNext[from] != m_borderPrev[from];
+    default:
+        return false;
+    }
+
+}
+
+bool Simplifier::flipsTriangle(GLuint from, GLuint to) const {
+
+    glm::vec3 target = position(to);
+
+    for (GLuint k = m_offsets[from]; k < m_offsets[from + 1]; k++) {
+
+        const GLuint *corners = &m_indices[3 * m_triangles[k]];
+        if (corners[0] == to || corners[1] == to || corners[2] == to) {
+            continue;   // it collapses away
+        }
+
+        glm::vec3 before[3], after[3];
+        for (int corner = 0; corner < 3; corner++) {
+            before[corner] = position(corners[corner]);
+            after[corner] = corners[corner] == from ? target : before[corner];
+        }
+
+        glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+        glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+        // Folding a triangle flat onto a line counts too
+        if (n0 != glm::vec3(0.f) && glm::dot(n0, n1) <= kMinNormalDot * glm::length(n0) * glm::length(n1)) {
+            return true;
+        }
+
+    }
+
+    return false;
+
+}
+
+// One pass of collapses, cheapest first. Each collapse locks the vertices around the one
+// it moves for the rest of the pass, so no triangle has two corners moving at once and
+// the flip test against the positions at the start of the pass holds.
+// @return  the number of collapses
+size_t Simplifier::collapseEdges(size_t trianglesToRemove) {
+
+    buildAdjacency();
+
+    // Each edge once, in whichever direction is cheaper. Interior edges are found from
+    // both of their triangles, so only the one that runs upward is taken; border edges
+    // have a single triangle.
+    std::vector<Collapse> candidates;
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        for (int corner = 0; corner < 3; corner++) {
+            GLuint a = m_indices[i + corner];
+            GLuint b = m_indices[i + (corner + 1) % 3];
+            if (a > b && m_borderNext[a] != b) {
+                continue;
+            }
+
+            Quadric q = m_quadrics[a] + m_quadrics[b];
+            Collapse best = {kNone, kNone, INFINITY};
+            if (canCollapse(a, b)) {
+                best = {a, b, evaluate(q, position(b))};
+            }
+            if (canCollapse(b, a)) {
+                float error = evaluate(q, position(a));
+                if (error < best.error) {
+                    best = {b, a, error};
+                }
+            }
+            if (best.from != kNone) {
+                candidates.push_back(best);
+            }
+        }
+    }
+
+    // Each collapse removes up to two triangles, so the cheapest trianglesToRemove edges
+    // are enough to reach the goal, allowing for half of them to be locked
+    auto byError = [](const Collapse &a, const Collapse &b) { return a.error < b.error; };
+    size_t considered = std::min(candidates.size(), glm::max(trianglesToRemove, size_t(16)));
+    std::partial_sort(candidates.begin(), candidates.begin() + considered, candidates.end(), byError);
+
+    std::vector<GLuint> remap(m_vertexCount);
+    std::iota(remap.begin(), remap.end(), 0);
+    std::vector<uint8_t> locked(m_vertexCount, 0);
+
+    size_t collapses = 0;
+    size_t removed = 0;
+
+    for (size_t c = 0; c < considered && removed < trianglesToRemove; c++) {
+
+        const Collapse &collapse = candidates[c];
+        GLuint from = collapse.from;
+        GLuint to = collapse.to;
+        if (locked[from] || locked[to] || flipsTriangle(from, to)) {
+            continue;
+        }
+
+        for (GLuint k = m_offsets[from]; k < m_offsets[from + 1]; k++) {
+            const GLuint *corners = &m_indices[3 * m_triangles[k]];
+            locked[corners[0]] = locked[corners[1]] = locked[corners[2]] = 1;
+        }
+
+        remap[from] = to;
+        m_collapsedTo[from] = to;
+        m_quadrics[to] = m_quadrics[to] + m_quadrics[from];
+
+        if (m_kinds[from] == VertexKind::Border) {
+            if (m_borderNext[from] == to) {
+                m_borderNext[m_borderPrev[from]] = to;
+                m_borderPrev[to] = m_borderPrev[from];
+            } else {
+                m_borderPrev[m_borderNext[from]] = to;
+                m_borderNext[to] = m_borderNext[from];
+            }
+            removed += 1;
+        } else {
+            removed += 2;
+        }
+        collapses++;
+
+    }
+
+    // Triangles left with a repeated corner have collapsed away
+    size_t kept = 0;
+    for (size_t i = 0; i < m_indices.size(); i += 3) {
+        GLuint a = remap[m_indices[i]];
+        GLuint b = remap[m_indices[i + 1]];
+        GLuint c = remap[m_indices[i + 2]];
+        if (a != b && b != c && c != a) {
+            m_indices[kept++] = a;
+            m_indices[kept++] = b;
+            m_indices[kept++] = c;
+        }
+    }
+    m_indices.resize(kept);
+
+    return collapses;
+
+}
+
+float Simplifier::measureError() {
+
+    buildAdjacency();
+
+    float error = 0.f;
+    for (GLuint v = 0; v < m_vertexCount; v++) {
+
+        GLuint target = v;
+        while (m_collapsedTo[target] != target) {
+            target = m_collapsedTo[target];
+        }
+        m_collapsedTo[v] = target;
+        if (target == v) {
+            continue;
+        }
+
+        // The nearest of the triangles around it. Their planes would be closer still, but
+        // reach far past the triangles and let whole bumps go missing at no cost.
+        glm::vec3 p = position(v);
+        float distance = INFINITY;
+        for (GLuint k = m_offsets[target]; k < m_offsets[target + 1]; k++) {
+            const GLuint *corners = &m_indices[3 * m_triangles[k]];
+            distance = glm::min(distance, triangleDistance(p, position(corners[0]), position(corners[1]),
+                                                           position(corners[2])));
+        }
+        if (distance < INFINITY) {
+            error = glm::max(error, distance);
+        }
+
+    }
+
+    return error;
+
+}
+
+}
+
+std::vector<MeshLod> buildMeshLods(ShapeMesh &mesh, const MeshLodOptions &options) {
+
+    std::vector<MeshLod> lods;
+    lods.push_back({0, uint32_t(mesh.indices.size()), 0, 0, 0.f});
+
+    if (options.levels <= 1 || mesh.indices.empty()) {
+        return lods;
+    }
+
+    // The levels are snapshots of one run, so the quadrics, and the errors, keep counting
+    // from the full mesh
+    std::vector<GLuint> indices = mesh.indices;
+    Simplifier simplifier(mesh.vertices, indices);
+    size_t vertexCount = mesh.vertices.size() / 6;
+
+    for (int level = 1; level < options.levels; level++) {
+
+        size_t previous = lods.back().indexCount;
+        simplifier.simplify(size_t(previous / 3 * options.ratio) * 3);
+
+        if (indices.size() > previous * (1.f - kMinReduction)) {
+            break;
+        }
+
+        std::vector<GLuint> levelIndices = indices;
+        optimizeVertexCache(levelIndices, vertexCount);
+
+        // A coarser level is never closer to the full mesh than the one before
+        float error = glm::max(lods.back().error, simplifier.measureError());
+        lods.push_back({uint32_t(mesh.indices.size()), uint32_t(levelIndices.size()), 0, 0, error});
+        mesh.indices.insert(mesh.indices.end(), levelIndices.begin(), levelIndices.end());
+
+    }
+
+    return lods;
+
+}
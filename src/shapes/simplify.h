@@ -0,0 +1,38 @@
+#pragma once
+
+#include "shapes/shape.h"
+
+// Builds levels of detail for loaded meshes by collapsing edges in order of their quadric
+// error (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997).
+//
+// Each collapse moves a vertex onto one of its neighbours, so every level indexes a subset
+// of the mesh's vertices and keeps their normals; all levels share one vertex buffer.
+// Vertices on open borders only slide along the border, and vertices on seams, where
+// welded vertices with different normals meet, stay put, so outlines and hard edges
+// survive. Collapses that would flip a triangle are skipped.
+
+// How many levels are built for each mesh, including the full one, and the share of
+// triangles each keeps from the level before. Both are part of a mesh's cache key.
+struct MeshLodOptions {
+    int levels = 4;
+    float ratio = 0.5f;
+
+    bool operator==(const MeshLodOptions &other) const = default;
+};
+
+struct MeshLod {
+    uint32_t indexOffset;       // first of its indices in the mesh
+    uint32_t indexCount;
+    uint32_t meshletOffset;     // first of its meshlets
+    uint32_t meshletCount;
+
+    // How far its surface may stray from the full mesh, in the mesh's units
+    float error;
+};
+
+// Simplifies mesh into a chain of up to options.levels levels, each with about
+// options.ratio of the triangles of the one before. The coarser levels' indices are cache-optimized and
+// appended to mesh.indices; the chain stops early once a level barely simplifies.
+// mesh should already be optimized, as level 0 is the mesh as it is.
+// @return  the levels, finest first, with their meshlet ranges left empty
+std::vector<MeshLod> buildMeshLods(ShapeMesh &mesh, const MeshLodOptions &options = {});
@@ -1,89 +1,79 @@
 #include "sphere.h"
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 
-static void insert(std::vector<float>& data, glm::vec3 v) {
+// The sphere is a grid of param1 rows by param2 wedges. Each pole is a single vertex,
+// and the last wedge wraps around to the vertices of the first.
+//
+// Vertices: the top pole, the bottom pole, then param1 - 1 rings of param2 vertices.
+static void makeVertices(float* out, int param1, int param2) {
 
-    data.push_back(v.x);
-    data.push_back(v.y);
-    data.push_back(v.z);
+    const float r = 0.5f;
+    AngleTable phi(param1, glm::pi<float>());
+    AngleTable theta(param2, glm::two_pi<float>());
 
-}
+    out = putVertex(out, glm::vec3(0.f, r, 0.f), glm::vec3(0.f, 1.f, 0.f));
+    out = putVertex(out, glm::vec3(0.f, -r, 0.f), glm::vec3(0.f, -1.f, 0.f));
 
-static void makeTile(std::vector<float>& data,
-              glm::vec3 topLeft,
-              glm::vec3 topRight,
-              glm::vec3 bottomLeft,
-              glm::vec3 bottomRight) {
+    for (int row = 1; row < param1; row++) {
 
-    glm::vec3 normalTL = glm::normalize(topLeft);
-    glm::vec3 normalTR = glm::normalize(topRight);
-    glm::vec3 normalBL = glm::normalize(bottomLeft);
-    glm::vec3 normalBR = glm::normalize(bottomRight);
+        float sinPhi = phi.sin[row];
+        float cosPhi = phi.cos[row];
 
-    insert(data, topLeft); insert(data, normalTL);
-    insert(data, bottomLeft); insert(data, normalBL);
-    insert(data, bottomRight); insert(data, normalBR);
+        for (int i = 0; i < param2; i++) {
+            glm::vec3 normal(sinPhi * theta.cos[i], cosPhi, -sinPhi * theta.sin[i]);
+            out = putVertex(out, r * normal, normal);
+        }
 
-    insert(data, bottomRight); insert(data, normalBR);
-    insert(data, topRight); insert(data, normalTR);
-    insert(data, topLeft); insert(data, normalTL);
+    }
 
 }
 
-static void makeWedge(std::vector<float>& data,
-               int param1,
-               float currentTheta,
-               float nextTheta) {
-
-    float r = 0.5f;
-    for (int i = 0; i < param1; i++) {
-
-        float phiTop = i * glm::radians(180.0f / param1);
-        float phiBottom = (i + 1) * glm::radians(180.0f / param1);
+// Each tile is split into (topLeft, bottomLeft, bottomRight) and (bottomRight, topRight,
+// topLeft). Along the poles one of those collapses and is left out.
+static void makeIndices(GLuint* out, int param1, int param2) {
 
-        glm::vec3 topLeft = glm::vec3(r * glm::sin(phiTop) * glm::cos(currentTheta),
-                                      r * glm::cos(phiTop),
-                                      -r * glm::sin(phiTop) * glm::sin(currentTheta));
+    const GLuint top = 0;
+    const GLuint bottom = 1;
 
-        glm::vec3 topRight = glm::vec3(r * glm::sin(phiTop) * glm::cos(nextTheta),
-                                       r * glm::cos(phiTop),
-                                       -r * glm::sin(phiTop) * glm::sin(nextTheta));
+    auto ring = [param2](int row) -> GLuint {
+        return 2 + (row - 1) * param2;
+    };
 
-        glm::vec3 bottomLeft = glm::vec3(r * glm::sin(phiBottom) * glm::cos(currentTheta),
-                                         r * glm::cos(phiBottom),
-                                         -r * glm::sin(phiBottom) * glm::sin(currentTheta));
+    for (int i = 0; i < param2; i++) {
 
-        glm::vec3 bottomRight = glm::vec3(r * glm::sin(phiBottom) * glm::cos(nextTheta),
-                                          r * glm::cos(phiBottom),
-                                          -r * glm::sin(phiBottom) * glm::sin(nextTheta));
+        int next = i + 1 == param2 ? 0 : i + 1;
 
-        makeTile(data, topLeft, topRight, bottomLeft, bottomRight);
+        out = putTriangle(out, top, ring(1) + i, ring(1) + next);
 
-    }
+        for (int row = 1; row < param1 - 1; row++) {
 
-}
+            GLuint topLeft = ring(row) + i;
+            GLuint topRight = ring(row) + next;
+            GLuint bottomLeft = ring(row + 1) + i;
+            GLuint bottomRight = ring(row + 1) + next;
 
-static void makeSphere(std::vector<float>& data, int param1, int param2) {
+            out = putTriangle(out, topLeft, bottomLeft, bottomRight);
+            out = putTriangle(out, bottomRight, topRight, topLeft);
 
-    for (int i = 0; i < param2; i++) {
+        }
 
-        float thetaLeft = i * glm::radians(360.0f) / param2;
-        float thetaRight = (i + 1) * glm::radians(360.0f) / param2;
-        makeWedge(data, param1, thetaLeft, thetaRight);
+        out = putTriangle(out, bottom, ring(param1 - 1) + next, ring(param1 - 1) + i);
 
     }
 
 }
 
-std::vector<float> Sphere::generateSphereData(int param1, int param2) {
+ShapeMesh Sphere::generateSphereData(int param1, int param2) {
 
-    std::vector<float> data;
+    ShapeMesh mesh;
     param1 = glm::max(2, param1);
     param2 = glm::max(2, param2);
 
-    data.reserve(6 * param1 * param2 * 2 * 6 * 6);
-    makeSphere(data, param1, param2);
+    mesh.resize((param1 - 1) * param2 + 2, 6 * (param1 - 1) * param2);
+    makeVertices(mesh.vertices.data(), param1, param2);
+    makeIndices(mesh.indices.data(), param1, param2);
 
-    return data;
+    return mesh;
 
 }
@@ -4,6 +4,6 @@
 class Sphere : public Shape {
 
 public:
-    static std::vector<float> generateSphereData(int param1, int param2);
+    static ShapeMesh generateSphereData(int param1, int param2);
 
 };
@@ -0,0 +1,194 @@
+#include "vertexcache.h"
+
+#include <algorithm>
+
+VertexCacheStats analyzeVertexCache(const std::vector<GLuint> &indices, size_t vertexCount) {
+    return analyzeVertexCache(indices.data(), indices.size(), vertexCount);
+}
+
+VertexCacheStats analyzeVertexCache(const GLuint *indices, size_t indexCount, size_t vertexCount) {
+
+    // Each vertex's position in the FIFO is known from when it was last added: it has
+    // been evicted once kVertexCacheSize more have been added since
+    std::vector<size_t> addedAt(vertexCount, 0);
+    size_t added = 0;
+
+    for (size_t i = 0; i < indexCount; i++) {
+        GLuint index = indices[i];
+        if (addedAt[index] == 0 || added - addedAt[index] >= kVertexCacheSize) {
+            added++;
+            addedAt[index] = added;
+        }
+    }
+
+    std::vector<bool> used(vertexCount, false);
+    size_t usedCount = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        GLuint index = indices[i];
+        usedCount += !used[index];
+        used[index] = true;
+    }
+
+    VertexCacheStats stats;
+    stats.acmr = indexCount == 0 ? 0.f : float(added) / (indexCount / 3);
+    stats.atvr = usedCount == 0 ? 0.f : float(added) / usedCount;
+    return stats;
+
+}
+
+void optimizeVertexCache(std::vector<GLuint> &indices, size_t vertexCount) {
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // The triangles using each vertex: those of vertex v are
+    // triangles[offsets[v]] .. triangles[offsets[v + 1]]
+    std::vector<GLuint> offsets(vertexCount + 1, 0);
+    for (GLuint index : indices) {
+        offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    std::vector<GLuint> triangles(indices.size());
+    std::vector<GLuint> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int corner = 0; corner < 3; corner++) {
+            triangles[cursor[indices[3 * t + corner]]++] = t;
+        }
+    }
+
+    // Triangles not yet emitted that use each vertex
+    std::vector<GLuint> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        live[v] = offsets[v + 1] - offsets[v];
+    }
+
+    // When each vertex last entered the cache; it is still there while fewer than
+    // kVertexCacheSize have entered since
+    std::vector<size_t> cachedAt(vertexCount, 0);
+    size_t time = kVertexCacheSize + 1;
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<GLuint> deadEnds;      // vertices used so far, most recent last
+    std::vector<GLuint> candidates;
+    std::vector<GLuint> output;
+    output.reserve(indices.size());
+
+    size_t nextVertex = 0;              // where the scan for unfinished vertices resumes
+    long fan = 0;
+
+    while (fan >= 0) {
+
+        candidates.clear();
+
+        for (GLuint i = offsets[fan]; i < offsets[fan + 1]; i++) {
+
+            GLuint t = triangles[i];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+
+            for (int corner = 0; corner < 3; corner++) {
+                GLuint v = indices[3 * t + corner];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - cachedAt[v] > kVertexCacheSize) {
+                    cachedAt[v] = time++;
+                }
+            }
+
+        }
+
+        // Fan around the candidate that will still be cached after its remaining
+        // triangles are emitted, preferring the one that entered the cache earliest
+        fan = -1;
+        size_t best = 0;
+        for (GLuint v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            size_t priority = 0;
+            if (time - cachedAt[v] + 2 * live[v] <= kVertexCacheSize) {
+                priority = time - cachedAt[v];
+            }
+            if (fan < 0 || priority > best) {
+                best = priority;
+                fan = v;
+            }
+        }
+
+        // Dead end: back up through recently used vertices, then scan for any left
+        while (fan < 0 && !deadEnds.empty()) {
+            GLuint v = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[v] > 0) {
+                fan = v;
+            }
+        }
+        while (fan < 0 && nextVertex < vertexCount) {
+            if (live[nextVertex] > 0) {
+                fan = nextVertex;
+            }
+            nextVertex++;
+        }
+
+    }
+
+    indices.swap(output);
+
+}
+
+void optimizeVertexFetch(ShapeMesh &mesh) {
+
+    size_t vertexCount = mesh.vertices.size() / 6;
+    const GLuint unused = ~0u;
+
+    std::vector<GLuint> remap(vertexCount, unused);
+    GLuint next = 0;
+    for (GLuint &index : mesh.indices) {
+        if (remap[index] == unused) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    std::vector<float> vertices(6 * size_t(next));
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (remap[v] != unused) {
+            std::copy_n(&mesh.vertices[6 * v], 6, &vertices[6 * size_t(remap[v])]);
+        }
+    }
+
+    mesh.vertices.swap(vertices);
+
+}
+
+std::pair<VertexCacheStats, VertexCacheStats> optimizeMesh(ShapeMesh &mesh) {
+
+    // The generators' row-by-row order already reuses the cache fairly well on small
+    // grids, where Tipsify can come out slightly worse; keep whichever is better
+    size_t vertexCount = mesh.vertices.size() / 6;
+    std::vector<GLuint> indices = mesh.indices;
+    optimizeVertexCache(indices, vertexCount);
+
+    VertexCacheStats before = analyzeVertexCache(mesh.indices, vertexCount);
+    VertexCacheStats after = analyzeVertexCache(indices, vertexCount);
+    if (after.acmr < before.acmr) {
+        mesh.indices.swap(indices);
+    } else {
+        after = before;
+    }
+
+    // Dropping unused vertices changes neither count the stats are made of
+    optimizeVertexFetch(mesh);
+
+    return {before, after};
+
+}
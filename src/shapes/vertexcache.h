@@ -0,0 +1,38 @@
+#pragma once
+
+#include "shapes/shape.h"
+
+#include <utility>
+
+// Reorders meshes for the GPU's post-transform vertex cache and for vertex fetch, and
+// measures how well a triangle order reuses the cache.
+//
+// Triangles are ordered with Tipsify (Sander, Nehab and Barczak, "Fast Triangle
+// Reordering for Vertex Locality and Reduced Overdraw", 2007): it fans out around one
+// vertex at a time, and moves on to whichever vertex used so far is most likely to still
+// be in the cache. It runs in linear time, so it keeps up with the generators at high
+// tessellations.
+
+// Size of the FIFO cache that triangles are ordered for and measured against
+const int kVertexCacheSize = 16;
+
+struct VertexCacheStats {
+    float acmr;     // vertices transformed per triangle: 3 at worst, about 0.5 at best on large meshes
+    float atvr;     // vertices transformed per vertex: 1 at best
+};
+
+// Simulates the cache over the triangles in indices.
+VertexCacheStats analyzeVertexCache(const std::vector<GLuint> &indices, size_t vertexCount);
+VertexCacheStats analyzeVertexCache(const GLuint *indices, size_t indexCount, size_t vertexCount);
+
+// Reorders the triangles in indices for the cache. Each keeps its winding.
+void optimizeVertexCache(std::vector<GLuint> &indices, size_t vertexCount);
+
+// Reorders the mesh's vertices into the order its triangles first use them, so vertex
+// fetch walks the buffer forward. Unused vertices are dropped.
+void optimizeVertexFetch(ShapeMesh &mesh);
+
+// Both of the above, in order, keeping the original triangle order if it reuses the cache
+// better. Every mesh is passed through this before upload.
+// @return  how well the mesh reuses the cache before and after
+std::pair<VertexCacheStats, VertexCacheStats> optimizeMesh(ShapeMesh &mesh);
@@ -0,0 +1,287 @@
+#include "chunkstreamer.h"
+#include "hash.h"
+#include "settings.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+
+// Chunks parsed at once. Each parse already flattens on several threads.
+const size_t kMaxLoads = 2;
+
+// Resident chunks are kept until they are this much further away than the load
+// distance, so they do not thrash when the camera moves along the boundary
+const float kUnloadDistanceScale = 1.25f;
+
+using ChunkLoad = std::future<std::unique_ptr<RenderData>>;
+
+bool isReady(const ChunkLoad &load) {
+    return load.valid() && load.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+float distanceToBounds(const glm::vec3 &position, const RenderChunk &chunk) {
+    return glm::length(position - glm::clamp(position, chunk.boundsMin, chunk.boundsMax));
+}
+
+// A resident chunk is held twice: as loaded, and composed into the scene
+size_t residentSize(const RenderData &data) {
+    size_t bytes = data.shapes.capacity() * sizeof(RenderShapeData)
+                   + data.shapeKeys.capacity() * sizeof(uint64_t)
+                   + data.primitives.capacity() * sizeof(ScenePrimitive)
+                   + data.materials.capacity() * sizeof(SceneMaterial)
+                   + data.lights.capacity() * sizeof(SceneLightData);
+    return 2 * bytes;
+}
+
+// Until a chunk has been loaded once, its size is guessed from the size of its file
+size_t estimatedSize(const std::string &filename) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(filename, error);
+    return error ? 0 : size;
+}
+
+}
+
+void ChunkStreamer::reset(const std::vector<RenderChunk> &chunks) {
+    for (Chunk &chunk : m_chunks) {
+        if (chunk.load.valid()) {
+            m_abandoned.push_back(std::move(chunk.load));
+        }
+    }
+
+    m_chunks.clear();
+    m_chunks.resize(chunks.size());
+    m_materials.clear();
+    m_materialUsers.clear();
+    m_materialIndices.clear();
+    m_freeMaterials.clear();
+    for (size_t i = 0; i < chunks.size(); i++) {
+        m_chunks[i].info = chunks[i];
+        m_chunks[i].bytes = estimatedSize(chunks[i].filename);
+    }
+
+    m_composed = false;
+}
+
+bool ChunkStreamer::update(const glm::vec3 &position) {
+    std::erase_if(m_abandoned, isReady);
+
+    bool changed = false;
+    for (Chunk &chunk : m_chunks) {
+        if (!isReady(chunk.load)) {
+            continue;
+        }
+        std::unique_ptr<RenderData> data = chunk.load.get();
+        if (!data) {
+            // A chunk that fails to reload keeps what it had until its file changes again
+            std::cerr << "Failed to load chunk " << chunk.info.filename << std::endl;
+            chunk.failed = !chunk.data;
+            continue;
+        }
+        releaseMaterials(chunk);
+        chunk.data = std::move(data);
+        internMaterials(chunk);
+        chunk.bytes = residentSize(*chunk.data);
+        changed = true;
+    }
+
+    // Chunks in range, nearest first. With streaming off, every chunk is loaded as if
+    // it were part of the scene.
+    float loadDistance = settings.farPlane;
+    std::vector<std::pair<float, size_t>> inRange;
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        const Chunk &chunk = m_chunks[i];
+        if (chunk.failed) {
+            continue;
+        }
+        float distance = distanceToBounds(position, chunk.info);
+        bool held = chunk.data || chunk.load.valid();
+        if (!settings.streamChunks || distance <= loadDistance * (held ? kUnloadDistanceScale : 1.f)) {
+            inRange.emplace_back(distance, i);
+        }
+    }
+    std::stable_sort(inRange.begin(), inRange.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    // Of those, as many as fit in the budget. The nearest chunk is always wanted, so an
+    // oversized chunk cannot leave the camera surrounded by nothing.
+    size_t budget = size_t(settings.chunkMemoryBudget) * 1024 * 1024;
+    std::vector<bool> wanted(m_chunks.size(), false);
+    size_t wantedBytes = 0;
+    for (const auto &[distance, index] : inRange) {
+        wantedBytes += m_chunks[index].bytes;
+        if (settings.streamChunks && wantedBytes > budget && wantedBytes != m_chunks[index].bytes) {
+            break;
+        }
+        wanted[index] = true;
+    }
+
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        if (m_chunks[i].data && !wanted[i]) {
+            releaseMaterials(m_chunks[i]);
+            m_chunks[i].data.reset();
+            changed = true;
+        }
+    }
+
+    // Loads still running for chunks that are no longer wanted finish and are evicted
+    // on a later update; a future cannot be cancelled
+    SceneParseOptions options = SceneParseOptions::fromSettings();
+    size_t loading = loadingChunks();
+    for (const auto &[distance, index] : inRange) {
+        Chunk &chunk = m_chunks[index];
+        if (loading >= kMaxLoads) {
+            break;
+        }
+        if (!wanted[index] || (chunk.data && !chunk.stale) || chunk.load.valid()) {
+            continue;
+        }
+
+        std::string filename = chunk.info.filename;
+        chunk.stale = false;
+        chunk.load = std::async(std::launch::async, [filename, options]() {
+            auto data = std::make_unique<RenderData>();
+            if (!SceneParser::parseChunk(filename, *data, options)) {
+                data.reset();
+            }
+            return data;
+        });
+        loading++;
+    }
+
+    return changed;
+}
+
+bool ChunkStreamer::loadFinished() const {
+    return std::any_of(m_chunks.begin(), m_chunks.end(), [](const Chunk &chunk) { return isReady(chunk.load); });
+}
+
+void ChunkStreamer::reload(const std::string &filename) {
+    for (Chunk &chunk : m_chunks) {
+        if (chunk.info.filename != filename) {
+            continue;
+        }
+        // A load already running may have read the old file, so it is loaded again after
+        chunk.failed = false;
+        chunk.stale = chunk.data || chunk.load.valid();
+    }
+}
+
+void ChunkStreamer::internMaterials(Chunk &chunk) {
+    const std::vector<SceneMaterial> &materials = chunk.data->materials;
+    chunk.materials.resize(materials.size());
+    for (size_t i = 0; i < materials.size(); i++) {
+        std::string key = SceneParser::materialKey(materials[i]);
+        auto it = m_materialIndices.find(key);
+        uint32_t index;
+        if (it != m_materialIndices.end()) {
+            index = it->second;
+        }
+        else if (!m_freeMaterials.empty()) {
+            index = m_freeMaterials.back();
+            m_freeMaterials.pop_back();
+            m_materials[index] = materials[i];
+            m_materialIndices.emplace(std::move(key), index);
+        }
+        else {
+            index = m_materials.size();
+            m_materials.push_back(materials[i]);
+            m_materialUsers.push_back(0);
+            m_materialIndices.emplace(std::move(key), index);
+        }
+        m_materialUsers[index]++;
+        chunk.materials[i] = index;
+    }
+}
+
+void ChunkStreamer::releaseMaterials(Chunk &chunk) {
+    for (uint32_t index : chunk.materials) {
+        if (--m_materialUsers[index] == 0) {
+            m_materialIndices.erase(SceneParser::materialKey(m_materials[index]));
+            m_freeMaterials.push_back(index);
+        }
+    }
+    chunk.materials.clear();
+}
+
+void ChunkStreamer::strip(RenderData &scene) {
+    if (!m_composed) {
+        return;
+    }
+
+    // The chunks' materials come after the scene's own, so its shapes' material indices
+    // stay valid
+    scene.shapes.resize(m_sceneShapes);
+    scene.shapeKeys.resize(m_sceneShapes);
+    scene.primitives.resize(m_scenePrimitives);
+    scene.materials.resize(m_sceneMaterials);
+    scene.lights.resize(m_sceneLights);
+    m_composed = false;
+}
+
+void ChunkStreamer::compose(RenderData &scene) {
+    m_composed = true;
+    m_sceneShapes = scene.shapes.size();
+    m_scenePrimitives = scene.primitives.size();
+    m_sceneMaterials = scene.materials.size();
+    m_sceneLights = scene.lights.size();
+
+    size_t shapeCount = scene.shapes.size();
+    for (const Chunk &chunk : m_chunks) {
+        shapeCount += chunk.data ? chunk.data->shapes.size() : 0;
+    }
+    scene.shapes.reserve(shapeCount);
+    scene.shapeKeys.reserve(shapeCount);
+    scene.materials.insert(scene.materials.end(), m_materials.begin(), m_materials.end());
+
+    for (size_t index = 0; index < m_chunks.size(); index++) {
+        const Chunk &chunk = m_chunks[index];
+        if (!chunk.data) {
+            continue;
+        }
+        const RenderData &data = *chunk.data;
+        const glm::mat4 &ctm = chunk.info.ctm;
+        bool isIdentity = ctm == glm::mat4(1.0f);
+
+        uint32_t primitiveOffset = scene.primitives.size();
+        scene.primitives.insert(scene.primitives.end(), data.primitives.begin(), data.primitives.end());
+
+        // Keys stay unique across chunks, since each chunk's are relative to its own root.
+        // The index tells apart groups that place the same chunk file more than once.
+        uint64_t chunkKey = hashCombine(fnv1a64(chunk.info.filename), index);
+        for (size_t i = 0; i < data.shapes.size(); i++) {
+            RenderShapeData shape = data.shapes[i];
+            shape.primitive += primitiveOffset;
+            shape.material = m_sceneMaterials + chunk.materials[shape.material];
+            if (!isIdentity) {
+                shape.ctm = ctm * shape.ctm;
+            }
+            scene.shapes.push_back(shape);
+            scene.shapeKeys.push_back(hashCombine(chunkKey, data.shapeKeys[i]));
+        }
+
+        for (SceneLightData light : data.lights) {
+            light.pos = ctm * light.pos;
+            light.dir = ctm * light.dir;
+            scene.lights.push_back(light);
+        }
+    }
+}
+
+size_t ChunkStreamer::residentChunks() const {
+    return std::count_if(m_chunks.begin(), m_chunks.end(), [](const Chunk &chunk) { return chunk.data != nullptr; });
+}
+
+size_t ChunkStreamer::loadingChunks() const {
+    return std::count_if(m_chunks.begin(), m_chunks.end(), [](const Chunk &chunk) { return chunk.load.valid(); });
+}
+
+size_t ChunkStreamer::residentBytes() const {
+    size_t bytes = 0;
+    for (const Chunk &chunk : m_chunks) {
+        bytes += chunk.data ? chunk.bytes : 0;
+    }
+    return bytes;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "sceneparser.h"
+
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Keeps the chunks of a scene (RenderData::chunks) that are near the camera resident.
+// Chunks are parsed and flattened on background threads, nearest first, and evicted
+// once they move out of range or the resident ones exceed the memory budget.
+//
+// Resident chunks are composed into the scene's own RenderData, after its shapes,
+// primitives, materials and lights, so everything that draws the scene draws them too and
+// indices into the scene's own data stay valid.
+//
+// The streamer keeps its own table of the resident chunks' materials. A chunk's materials
+// are interned into it once, when the chunk is loaded, and released when it is evicted;
+// freed entries are reused, so indices into the table stay valid while chunks come and go.
+class ChunkStreamer {
+public:
+    // Stop streaming the current chunks and start on chunks. Whatever was composed into
+    // the old scene is forgotten, so strip() it first if it is kept.
+    void reset(const std::vector<RenderChunk> &chunks);
+
+    // Collect finished loads, evict and start loads for a camera at position.
+    // @return  true if the set of resident chunks changed, so the scene must be recomposed.
+    bool update(const glm::vec3 &position);
+
+    // Whether a load has finished and is waiting for update().
+    bool loadFinished() const;
+
+    // Parse filename again, because it changed on disk. A resident chunk stays composed
+    // until its new contents replace it.
+    void reload(const std::string &filename);
+
+    // Remove the composed chunks from scene, leaving only its own contents.
+    void strip(RenderData &scene);
+
+    // Append the resident chunks to scene, which must not have any composed already.
+    void compose(RenderData &scene);
+
+    size_t residentChunks() const;
+    size_t loadingChunks() const;
+    size_t residentBytes() const;
+
+private:
+    struct Chunk {
+        RenderChunk info;
+        std::unique_ptr<RenderData> data;               // set while resident
+        std::future<std::unique_ptr<RenderData>> load;  // null result if parsing failed
+        std::vector<uint32_t> materials;                // per material of data, its entry in m_materials
+        size_t bytes = 0;                               // memory while resident; estimated until first loaded
+        bool failed = false;                            // not retried until the next reset() or reload()
+        bool stale = false;                             // the file changed since data was loaded
+    };
+
+    void internMaterials(Chunk &chunk);
+    void releaseMaterials(Chunk &chunk);
+
+    std::vector<Chunk> m_chunks;
+
+    // Materials of the resident chunks, with the number of chunks using each
+    std::vector<SceneMaterial> m_materials;
+    std::vector<uint32_t> m_materialUsers;
+    std::unordered_map<std::string, uint32_t> m_materialIndices;
+    std::vector<uint32_t> m_freeMaterials;
+
+    // Loads of chunks from before the last reset(), kept until they finish so that
+    // destroying their futures does not block
+    std::vector<std::future<std::unique_ptr<RenderData>>> m_abandoned;
+
+    // Sizes of the scene's own data, which compose() appends after
+    bool m_composed = false;
+    size_t m_sceneShapes = 0;
+    size_t m_scenePrimitives = 0;
+    size_t m_sceneMaterials = 0;
+    size_t m_sceneLights = 0;
+};
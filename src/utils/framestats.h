@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Counters of the last frame drawn. Realtime fills them in while it draws and the main
+// window shows them, refreshed once a second, so they never go to the console.
+struct FrameStats {
+    // Level of detail
+    std::vector<size_t> lodInstances;   // instances drawn at each level
+    size_t trianglesDrawn = 0;
+    size_t trianglesSaved = 0;          // against drawing everything at the finest level
+
+    // Draw submission
+    size_t drawCommands = 0;
+    int drawCalls = 0;
+    bool multiDrawIndirect = false;
+    size_t uploadedBytes = 0;           // instance data sent this frame
+
+    // Meshlet culling
+    size_t meshletsVisible = 0;
+    size_t meshletsTotal = 0;
+
+    // Chunk streaming, all zero without chunks
+    size_t chunksResident = 0;
+    size_t chunksTotal = 0;
+    size_t chunksLoading = 0;
+    size_t chunkBytes = 0;
+    size_t shapes = 0;
+
+    // One line per group of counters
+    std::string text() const {
+        std::ostringstream out;
+        out << "LOD: ";
+        for (size_t lod = 0; lod < lodInstances.size(); lod++) {
+            out << (lod ? " / " : "") << lodInstances[lod];
+        }
+        out << " instances per level\n"
+            << "Triangles: " << trianglesDrawn << " drawn, " << trianglesSaved << " saved\n"
+            << "Draws: " << drawCommands << " in " << drawCalls << " calls"
+            << (multiDrawIndirect ? " (indirect)" : "") << '\n'
+            << "Meshlets: " << meshletsVisible << " of " << meshletsTotal << " drawn\n"
+            << "Uploaded: " << uploadedBytes << " bytes";
+        if (chunksTotal > 0) {
+            out << "\nChunks: " << chunksResident << " of " << chunksTotal << " resident ("
+                << chunkBytes / (1024 * 1024) << " MB), " << chunksLoading << " loading\n"
+                << "Shapes: " << shapes;
+        }
+        return out.str();
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// 64-bit FNV-1a, usable at compile time for short keys.
+constexpr uint64_t fnv1a64(std::string_view data, uint64_t hash = 0xcbf29ce484222325ull) {
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Fast content hash for large blobs (scene files, meshes). Consumes eight bytes
+// per step instead of one, so it is not bit-compatible with fnv1a64; only use it
+// to compare against values produced by this same function.
+inline uint64_t hashBytes(const void *data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        hash ^= word;
+        hash *= 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    hash ^= size;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Mixes value into seed, for building keys out of several integers.
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+    uint64_t hash = seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
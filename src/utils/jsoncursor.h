@@ -0,0 +1,379 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Forward-only JSON tokenizer over an in-memory buffer (usually a memory-mapped file).
+// Nothing is materialized: callers walk objects and arrays member by member and pull
+// values out directly. The first syntax error stops the cursor; check failed() after
+// any call returns false.
+//
+// Typical use:
+//     if (!in.beginObject()) ...
+//     std::string_view key;
+//     while (in.nextMember(key)) {
+//         ... consume exactly one value ...
+//     }
+//     if (in.failed()) ...
+class JsonCursor {
+public:
+    enum class Type { Object, Array, String, Number, Literal, End, Invalid };
+
+    JsonCursor(const char *begin, const char *end) : m_begin(begin), m_pos(begin), m_end(end) {}
+
+    bool failed() const { return !m_error.empty(); }
+    const std::string &error() const { return m_error; }
+    size_t errorOffset() const { return m_errorOffset; }
+    size_t offset() const { return m_pos - m_begin; }
+    size_t size() const { return m_end - m_begin; }
+
+    // Type of the next value, without consuming it.
+    Type peek() {
+        skipWhitespace();
+        if (m_pos == m_end) return Type::End;
+        switch (*m_pos) {
+        case '{': return Type::Object;
+        case '[': return Type::Array;
+        case '"': return Type::String;
+        case 't': case 'f': case 'n': return Type::Literal;
+        default:
+            if (*m_pos == '-' || (*m_pos >= '0' && *m_pos <= '9')) return Type::Number;
+            return Type::Invalid;
+        }
+    }
+
+    // A position to come back to with rewind(), to read a value a second time.
+    struct Mark {
+        const char *pos;
+        int depth;
+        bool justOpened;
+    };
+
+    Mark mark() const { return {m_pos, m_depth, m_justOpened}; }
+
+    // Returns to mark. Has no effect once the cursor has failed.
+    void rewind(const Mark &mark) {
+        if (failed()) {
+            return;
+        }
+        m_pos = mark.pos;
+        m_depth = mark.depth;
+        m_justOpened = mark.justOpened;
+    }
+
+    bool beginObject() { return open('{'); }
+    bool beginArray() { return open('['); }
+
+    // Advances to the next member of the current object and reads its key.
+    // Returns false at the closing brace or on error. The key is only valid until the
+    // next call that reads a string.
+    bool nextMember(std::string_view &key) {
+        if (!nextItem('}', "unterminated object")) {
+            return false;
+        }
+        if (m_pos == m_end || *m_pos != '"') {
+            return fail("illegal value");
+        }
+        if (!readStringView(key)) {
+            return false;
+        }
+        skipWhitespace();
+        if (m_pos == m_end || *m_pos != ':') {
+            return fail("missing name separator");
+        }
+        m_pos++;
+        return true;
+    }
+
+    // Advances to the next element of the current array. Returns false at the closing
+    // bracket or on error.
+    bool nextElement() {
+        return nextItem(']', "unterminated array");
+    }
+
+    bool readString(std::string &out) {
+        std::string_view view;
+        if (!readStringView(view)) {
+            return false;
+        }
+        out.assign(view);
+        return true;
+    }
+
+    bool readNumber(double &out) {
+        skipWhitespace();
+        // from_chars takes more than JSON does ("inf", "nan", "01", "1."), so the number
+        // is matched against the JSON grammar first
+        const char *end = scanNumber();
+        if (end == nullptr) {
+            return fail("illegal number");
+        }
+        auto result = std::from_chars(m_pos, end, out);
+        if (result.ec != std::errc() || result.ptr != end) {
+            return fail("illegal number");
+        }
+        m_pos = result.ptr;
+        m_justOpened = false;
+        return true;
+    }
+
+    // Consumes the next value of any type.
+    bool skipValue() {
+        switch (peek()) {
+        case Type::Object: {
+            if (!beginObject()) return false;
+            std::string_view key;
+            while (nextMember(key)) {
+                if (!skipValue()) return false;
+            }
+            return !failed();
+        }
+        case Type::Array:
+            if (!beginArray()) return false;
+            while (nextElement()) {
+                if (!skipValue()) return false;
+            }
+            return !failed();
+        case Type::String: {
+            std::string_view view;
+            return readStringView(view);
+        }
+        case Type::Number: {
+            double value;
+            return readNumber(value);
+        }
+        case Type::Literal:
+            return readLiteral();
+        default:
+            return fail("illegal value");
+        }
+    }
+
+    // Fails unless only whitespace is left.
+    bool expectEnd() {
+        skipWhitespace();
+        if (m_pos != m_end) {
+            return fail("garbage at the end of the document");
+        }
+        return true;
+    }
+
+private:
+    static const int kMaxDepth = 1024;
+
+    void skipWhitespace() {
+        while (m_pos != m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+            m_pos++;
+        }
+    }
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    // End of the JSON number at m_pos, or nullptr if there is none:
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    const char *scanNumber() const {
+        const char *p = m_pos;
+        if (p != m_end && *p == '-') p++;
+        if (p == m_end || !isDigit(*p)) return nullptr;
+        if (*p++ != '0') {
+            while (p != m_end && isDigit(*p)) p++;
+        }
+        else if (p != m_end && isDigit(*p)) {
+            return nullptr;
+        }
+        if (p != m_end && *p == '.') {
+            if (++p == m_end || !isDigit(*p)) return nullptr;
+            while (p != m_end && isDigit(*p)) p++;
+        }
+        if (p != m_end && (*p == 'e' || *p == 'E')) {
+            if (++p != m_end && (*p == '+' || *p == '-')) p++;
+            if (p == m_end || !isDigit(*p)) return nullptr;
+            while (p != m_end && isDigit(*p)) p++;
+        }
+        return p;
+    }
+
+    static bool isControl(char c) { return static_cast<unsigned char>(c) < 0x20; }
+
+    bool fail(const char *message) {
+        if (m_error.empty()) {
+            m_error = message;
+            m_errorOffset = offset();
+        }
+        m_pos = m_end;
+        return false;
+    }
+
+    bool open(char bracket) {
+        skipWhitespace();
+        if (m_pos == m_end || *m_pos != bracket) {
+            return fail("illegal value");
+        }
+        if (++m_depth > kMaxDepth) {
+            return fail("too deeply nested document");
+        }
+        m_pos++;
+        m_justOpened = true;
+        return true;
+    }
+
+    // Handles the separator between items of an object or array.
+    bool nextItem(char close, const char *unterminated) {
+        if (failed()) {
+            return false;
+        }
+        skipWhitespace();
+        if (m_pos == m_end) {
+            return fail(unterminated);
+        }
+        if (*m_pos == close) {
+            m_pos++;
+            m_depth--;
+            m_justOpened = false;
+            return false;
+        }
+        if (m_justOpened) {
+            m_justOpened = false;
+            return true;
+        }
+        if (*m_pos != ',') {
+            return fail("missing value separator");
+        }
+        m_pos++;
+        skipWhitespace();
+        if (m_pos != m_end && *m_pos == close) {
+            return fail("illegal value");
+        }
+        return true;
+    }
+
+    bool readLiteral() {
+        for (std::string_view literal : {"true", "false", "null"}) {
+            if (std::string_view(m_pos, m_end - m_pos).starts_with(literal)) {
+                m_pos += literal.size();
+                m_justOpened = false;
+                return true;
+            }
+        }
+        return fail("illegal value");
+    }
+
+    // Points into the buffer when the string has no escapes, otherwise into m_scratch.
+    bool readStringView(std::string_view &out) {
+        skipWhitespace();
+        if (m_pos == m_end || *m_pos != '"') {
+            return fail("illegal value");
+        }
+        const char *start = ++m_pos;
+        while (m_pos != m_end && *m_pos != '"' && *m_pos != '\\' && !isControl(*m_pos)) {
+            m_pos++;
+        }
+        if (m_pos == m_end) {
+            return fail("unterminated string");
+        }
+        if (isControl(*m_pos)) {
+            return fail("illegal value");
+        }
+        m_justOpened = false;
+        if (*m_pos == '"') {
+            out = std::string_view(start, m_pos - start);
+            m_pos++;
+            return true;
+        }
+
+        m_scratch.assign(start, m_pos);
+        while (m_pos != m_end && *m_pos != '"') {
+            if (isControl(*m_pos)) {
+                return fail("illegal value");
+            }
+            if (*m_pos != '\\') {
+                m_scratch += *m_pos++;
+                continue;
+            }
+            if (++m_pos == m_end) {
+                break;
+            }
+            switch (*m_pos++) {
+            case '"': m_scratch += '"'; break;
+            case '\\': m_scratch += '\\'; break;
+            case '/': m_scratch += '/'; break;
+            case 'b': m_scratch += '\b'; break;
+            case 'f': m_scratch += '\f'; break;
+            case 'n': m_scratch += '\n'; break;
+            case 'r': m_scratch += '\r'; break;
+            case 't': m_scratch += '\t'; break;
+            case 'u': {
+                uint32_t codepoint;
+                if (!readHex4(codepoint)) {
+                    return fail("illegal escape sequence");
+                }
+                if (codepoint >= 0xD800 && codepoint < 0xDC00) {
+                    uint32_t low;
+                    if (m_end - m_pos < 2 || m_pos[0] != '\\' || m_pos[1] != 'u') {
+                        return fail("illegal escape sequence");
+                    }
+                    m_pos += 2;
+                    if (!readHex4(low) || low < 0xDC00 || low >= 0xE000) {
+                        return fail("illegal escape sequence");
+                    }
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUtf8(codepoint);
+                break;
+            }
+            default:
+                return fail("illegal escape sequence");
+            }
+        }
+        if (m_pos == m_end) {
+            return fail("unterminated string");
+        }
+        m_pos++;
+        out = m_scratch;
+        return true;
+    }
+
+    bool readHex4(uint32_t &out) {
+        if (m_end - m_pos < 4) {
+            return false;
+        }
+        auto result = std::from_chars(m_pos, m_pos + 4, out, 16);
+        if (result.ec != std::errc() || result.ptr != m_pos + 4) {
+            return false;
+        }
+        m_pos += 4;
+        return true;
+    }
+
+    void appendUtf8(uint32_t codepoint) {
+        if (codepoint < 0x80) {
+            m_scratch += static_cast<char>(codepoint);
+        } else if (codepoint < 0x800) {
+            m_scratch += static_cast<char>(0xC0 | (codepoint >> 6));
+            m_scratch += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            m_scratch += static_cast<char>(0xE0 | (codepoint >> 12));
+            m_scratch += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            m_scratch += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else {
+            m_scratch += static_cast<char>(0xF0 | (codepoint >> 18));
+            m_scratch += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            m_scratch += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            m_scratch += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    const char *m_begin;
+    const char *m_pos;
+    const char *m_end;
+
+    int m_depth = 0;
+    bool m_justOpened = false;
+
+    std::string m_scratch;
+    std::string m_error;
+    size_t m_errorOffset = 0;
+};
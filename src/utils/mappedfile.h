@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <QFile>
+
+// Read-only memory mapping of a whole file. The mapping is released with the object.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) : m_file(QString::fromStdString(path)) {
+        if (!m_file.open(QFile::ReadOnly)) {
+            return;
+        }
+        m_size = m_file.size();
+        if (m_size > 0) {
+            m_data = m_file.map(0, m_size);
+        }
+    }
+
+    ~MappedFile() {
+        if (m_data) {
+            m_file.unmap(m_data);
+        }
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // False if the file could not be opened or mapped (empty files are never mapped).
+    bool isOpen() const { return m_data != nullptr; }
+
+    const unsigned char *data() const { return m_data; }
+    const char *chars() const { return reinterpret_cast<const char *>(m_data); }
+    uint64_t size() const { return m_size; }
+
+private:
+    QFile m_file;
+    unsigned char *m_data = nullptr;
+    uint64_t m_size = 0;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+#if defined(__linux__)
+#include <cstdio>
+#endif
+
+// Peak resident set size of the process so far, in kilobytes. Returns 0 on platforms
+// where it is not available. This is a high-water mark for the whole process, so it
+// only measures one parse when the process does nothing else (see tools/scenebench).
+inline uint64_t peakRSSKilobytes() {
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    // macOS reports bytes, Linux reports kilobytes
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return 0;
+#endif
+}
+
+// Resident set size of the process right now, in kilobytes. Returns 0 on platforms
+// where it is not available.
+inline uint64_t currentRSSKilobytes() {
+#if defined(__linux__)
+    FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    unsigned long long size = 0, resident = 0;
+    int read = std::fscanf(statm, "%llu %llu", &size, &resident);
+    std::fclose(statm);
+    if (read != 2) {
+        return 0;
+    }
+    return resident * uint64_t(sysconf(_SC_PAGESIZE)) / 1024;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size / 1024;
+#else
+    return 0;
+#endif
+}
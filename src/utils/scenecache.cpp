@@ -0,0 +1,357 @@
+#include "scenecache.h"
+#include "hash.h"
+#include "mappedfile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include <QSaveFile>
+
+namespace {
+
+const char kMagic[8] = {'R', 'T', 'S', 'C', 'E', 'N', 'E', '\0'};
+const uint32_t kVersion = 5;
+
+// Offset and length of a string inside the cache's string table.
+struct CachedString {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct CachedFileMap {
+    uint32_t isUsed;
+    CachedString filename;
+    float repeatU;
+    float repeatV;
+};
+
+// ScenePrimitive with every std::string moved out into the string table.
+struct CachedPrimitive {
+    PrimitiveType type;
+
+    SceneColor cAmbient;
+    SceneColor cDiffuse;
+    SceneColor cSpecular;
+    SceneColor cReflective;
+    SceneColor cTransparent;
+    SceneColor cEmissive;
+    float shininess;
+    float ior;
+    float blend;
+
+    CachedFileMap textureMap;
+    CachedFileMap bumpMap;
+    CachedString meshfile;
+};
+
+// RenderChunk with its filename moved into the string table.
+struct CachedChunk {
+    CachedString filename;
+    glm::mat4 ctm;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+
+    SceneGlobalData globalData;
+    SceneCameraData cameraData;
+
+    uint64_t lightCount;
+    uint64_t lightOffset;
+    uint64_t primitiveCount;
+    uint64_t primitiveOffset;
+    uint64_t shapeCount;
+    uint64_t shapeOffset;
+    uint64_t shapeKeyOffset;
+    uint64_t chunkCount;
+    uint64_t chunkOffset;
+    uint64_t stringsSize;
+    uint64_t stringsOffset;
+};
+
+static_assert(std::is_trivially_copyable_v<SceneLightData>);
+static_assert(std::is_trivially_copyable_v<CachedPrimitive>);
+static_assert(std::is_trivially_copyable_v<RenderShapeData>);
+static_assert(std::is_trivially_copyable_v<CachedChunk>);
+static_assert(std::is_trivially_copyable_v<CacheHeader>);
+
+uint64_t alignUp(uint64_t offset) {
+    return (offset + 15) & ~uint64_t(15);
+}
+
+bool hashSourceFile(const std::string &path, uint64_t &hash, uint64_t &size) {
+    MappedFile source(path);
+    if (!source.isOpen()) {
+        return false;
+    }
+
+    hash = hashBytes(source.data(), source.size());
+    size = source.size();
+    return true;
+}
+
+class StringTable {
+public:
+    CachedString add(const std::string &str) {
+        auto it = m_offsets.find(str);
+        if (it != m_offsets.end()) {
+            return it->second;
+        }
+
+        CachedString entry = {static_cast<uint32_t>(m_data.size()), static_cast<uint32_t>(str.size())};
+        m_data += str;
+        m_offsets.emplace(str, entry);
+        return entry;
+    }
+
+    const std::string &data() const { return m_data; }
+
+private:
+    std::string m_data;
+    std::unordered_map<std::string, CachedString> m_offsets;
+};
+
+CachedFileMap cacheFileMap(const SceneFileMap &map, StringTable &strings) {
+    CachedFileMap cached;
+    cached.isUsed = map.isUsed;
+    cached.filename = strings.add(map.filename);
+    cached.repeatU = map.repeatU;
+    cached.repeatV = map.repeatV;
+    return cached;
+}
+
+// Whether count elements of elemSize bytes from offset fit into size bytes. Written so
+// that corrupt counts cannot overflow.
+bool sectionFits(uint64_t offset, uint64_t count, uint64_t elemSize, uint64_t size) {
+    return offset <= size && count <= (size - offset) / elemSize;
+}
+
+// Copies a string out of the string table. Fails if it lies outside the table.
+bool restoreString(const CachedString &cached, std::string_view strings, std::string &out) {
+    if (cached.offset > strings.size() || cached.length > strings.size() - cached.offset) {
+        return false;
+    }
+    out.assign(strings.data() + cached.offset, cached.length);
+    return true;
+}
+
+bool restoreFileMap(const CachedFileMap &cached, std::string_view strings, SceneFileMap &map) {
+    map.isUsed = cached.isUsed;
+    map.repeatU = cached.repeatU;
+    map.repeatV = cached.repeatV;
+    return restoreString(cached.filename, strings, map.filename);
+}
+
+}
+
+std::string SceneCache::cachePath(const std::string &scenePath) {
+    return std::filesystem::path(scenePath).replace_extension(".rtscene").string();
+}
+
+bool SceneCache::load(const std::string &scenePath, RenderData &renderData) {
+    MappedFile cache(cachePath(scenePath));
+    if (!cache.isOpen() || cache.size() < sizeof(CacheHeader)) {
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, cache.data(), sizeof(CacheHeader));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.headerSize != sizeof(CacheHeader)) {
+        return false;
+    }
+
+    if (!sectionFits(header.lightOffset, header.lightCount, sizeof(SceneLightData), cache.size())
+        || !sectionFits(header.primitiveOffset, header.primitiveCount, sizeof(CachedPrimitive), cache.size())
+        || !sectionFits(header.shapeOffset, header.shapeCount, sizeof(RenderShapeData), cache.size())
+        || !sectionFits(header.shapeKeyOffset, header.shapeCount, sizeof(uint64_t), cache.size())
+        || !sectionFits(header.chunkOffset, header.chunkCount, sizeof(CachedChunk), cache.size())
+        || !sectionFits(header.stringsOffset, header.stringsSize, 1, cache.size())) {
+        std::cout << "scene cache " << cachePath(scenePath) << " is truncated" << std::endl;
+        return false;
+    }
+
+    uint64_t sourceHash, sourceSize;
+    if (!hashSourceFile(scenePath, sourceHash, sourceSize)) {
+        return false;
+    }
+    if (sourceHash != header.sourceHash || sourceSize != header.sourceSize) {
+        return false;
+    }
+
+    renderData.globalData = header.globalData;
+    renderData.cameraData = header.cameraData;
+
+    // Lights are stored exactly as they are laid out in memory.
+    const SceneLightData *lights = reinterpret_cast<const SceneLightData *>(cache.data() + header.lightOffset);
+    renderData.lights.assign(lights, lights + header.lightCount);
+
+    std::string_view strings(reinterpret_cast<const char *>(cache.data() + header.stringsOffset), header.stringsSize);
+    bool corrupt = false;
+    const CachedPrimitive *primitives = reinterpret_cast<const CachedPrimitive *>(cache.data() + header.primitiveOffset);
+
+    renderData.primitives.clear();
+    renderData.primitives.resize(header.primitiveCount);
+    for (uint64_t i = 0; i < header.primitiveCount; i++) {
+        CachedPrimitive cached;
+        std::memcpy(&cached, primitives + i, sizeof(CachedPrimitive));
+
+        ScenePrimitive &primitive = renderData.primitives[i];
+        primitive.type = cached.type;
+        corrupt |= !restoreString(cached.meshfile, strings, primitive.meshfile);
+
+        SceneMaterial &mat = primitive.material;
+        mat.cAmbient = cached.cAmbient;
+        mat.cDiffuse = cached.cDiffuse;
+        mat.cSpecular = cached.cSpecular;
+        mat.cReflective = cached.cReflective;
+        mat.cTransparent = cached.cTransparent;
+        mat.cEmissive = cached.cEmissive;
+        mat.shininess = cached.shininess;
+        mat.ior = cached.ior;
+        mat.blend = cached.blend;
+        corrupt |= !restoreFileMap(cached.textureMap, strings, mat.textureMap);
+        corrupt |= !restoreFileMap(cached.bumpMap, strings, mat.bumpMap);
+    }
+
+    // Shape instances are plain data and are copied as they are. Their material
+    // indices are rebuilt by the caller.
+    const RenderShapeData *shapes = reinterpret_cast<const RenderShapeData *>(cache.data() + header.shapeOffset);
+    renderData.shapes.assign(shapes, shapes + header.shapeCount);
+
+    const uint64_t *shapeKeys = reinterpret_cast<const uint64_t *>(cache.data() + header.shapeKeyOffset);
+    renderData.shapeKeys.assign(shapeKeys, shapeKeys + header.shapeCount);
+
+    const CachedChunk *chunks = reinterpret_cast<const CachedChunk *>(cache.data() + header.chunkOffset);
+    renderData.chunks.clear();
+    renderData.chunks.resize(header.chunkCount);
+    for (uint64_t i = 0; i < header.chunkCount; i++) {
+        CachedChunk cached;
+        std::memcpy(&cached, chunks + i, sizeof(CachedChunk));
+
+        RenderChunk &chunk = renderData.chunks[i];
+        corrupt |= !restoreString(cached.filename, strings, chunk.filename);
+        chunk.ctm = cached.ctm;
+        chunk.boundsMin = cached.boundsMin;
+        chunk.boundsMax = cached.boundsMax;
+    }
+
+    for (const RenderShapeData &shape : renderData.shapes) {
+        corrupt |= shape.primitive >= header.primitiveCount;
+    }
+    if (corrupt) {
+        std::cout << "scene cache " << cachePath(scenePath) << " is corrupt" << std::endl;
+        renderData.primitives.clear();
+        renderData.shapes.clear();
+        renderData.shapeKeys.clear();
+        renderData.chunks.clear();
+        return false;
+    }
+
+    std::cout << "Loaded cached scene " << cachePath(scenePath) << std::endl;
+    return true;
+}
+
+bool SceneCache::store(const std::string &scenePath, const RenderData &renderData) {
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(CacheHeader));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(CacheHeader);
+
+    if (!hashSourceFile(scenePath, header.sourceHash, header.sourceSize)) {
+        return false;
+    }
+
+    header.globalData = renderData.globalData;
+    header.cameraData = renderData.cameraData;
+
+    StringTable strings;
+    std::vector<CachedPrimitive> primitives(renderData.primitives.size());
+    for (size_t i = 0; i < renderData.primitives.size(); i++) {
+        const ScenePrimitive &primitive = renderData.primitives[i];
+        const SceneMaterial &mat = primitive.material;
+
+        CachedPrimitive &cached = primitives[i];
+        std::memset(&cached, 0, sizeof(CachedPrimitive));
+        cached.type = primitive.type;
+        cached.cAmbient = mat.cAmbient;
+        cached.cDiffuse = mat.cDiffuse;
+        cached.cSpecular = mat.cSpecular;
+        cached.cReflective = mat.cReflective;
+        cached.cTransparent = mat.cTransparent;
+        cached.cEmissive = mat.cEmissive;
+        cached.shininess = mat.shininess;
+        cached.ior = mat.ior;
+        cached.blend = mat.blend;
+        cached.textureMap = cacheFileMap(mat.textureMap, strings);
+        cached.bumpMap = cacheFileMap(mat.bumpMap, strings);
+        cached.meshfile = strings.add(primitive.meshfile);
+    }
+
+    std::vector<CachedChunk> chunks(renderData.chunks.size());
+    for (size_t i = 0; i < renderData.chunks.size(); i++) {
+        const RenderChunk &chunk = renderData.chunks[i];
+
+        CachedChunk &cached = chunks[i];
+        std::memset(&cached, 0, sizeof(CachedChunk));
+        cached.filename = strings.add(chunk.filename);
+        cached.ctm = chunk.ctm;
+        cached.boundsMin = chunk.boundsMin;
+        cached.boundsMax = chunk.boundsMax;
+    }
+
+    header.lightCount = renderData.lights.size();
+    header.lightOffset = alignUp(sizeof(CacheHeader));
+    header.primitiveCount = primitives.size();
+    header.primitiveOffset = alignUp(header.lightOffset + header.lightCount * sizeof(SceneLightData));
+    header.shapeCount = renderData.shapes.size();
+    header.shapeOffset = alignUp(header.primitiveOffset + header.primitiveCount * sizeof(CachedPrimitive));
+    header.shapeKeyOffset = alignUp(header.shapeOffset + header.shapeCount * sizeof(RenderShapeData));
+    header.stringsSize = strings.data().size();
+    header.chunkCount = chunks.size();
+    header.chunkOffset = alignUp(header.shapeKeyOffset + header.shapeCount * sizeof(uint64_t));
+    header.stringsOffset = alignUp(header.chunkOffset + header.chunkCount * sizeof(CachedChunk));
+
+    std::string path = cachePath(scenePath);
+    QSaveFile file(QString::fromStdString(path));
+    if (!file.open(QFile::WriteOnly)) {
+        std::cout << "could not write scene cache " << path << std::endl;
+        return false;
+    }
+
+    uint64_t written = 0;
+    auto writeAt = [&](uint64_t offset, const void *data, uint64_t size) {
+        static const char padding[16] = {};
+        file.write(padding, offset - written);
+        file.write(static_cast<const char *>(data), size);
+        written = offset + size;
+    };
+
+    writeAt(0, &header, sizeof(CacheHeader));
+    writeAt(header.lightOffset, renderData.lights.data(), header.lightCount * sizeof(SceneLightData));
+    writeAt(header.primitiveOffset, primitives.data(), header.primitiveCount * sizeof(CachedPrimitive));
+    writeAt(header.shapeOffset, renderData.shapes.data(), header.shapeCount * sizeof(RenderShapeData));
+    writeAt(header.shapeKeyOffset, renderData.shapeKeys.data(), header.shapeCount * sizeof(uint64_t));
+    writeAt(header.chunkOffset, chunks.data(), header.chunkCount * sizeof(CachedChunk));
+    writeAt(header.stringsOffset, strings.data().data(), header.stringsSize);
+
+    if (!file.commit()) {
+        std::cout << "could not write scene cache " << path << ": "
+                  << file.errorString().toStdString() << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "sceneparser.h"
+
+#include <string>
+
+// Compiled binary form of a flattened scene (".rtscene"), stored next to the
+// source JSON. The cache is keyed by a content hash of the JSON, so editing the
+// scene file invalidates it automatically.
+class SceneCache {
+public:
+    // Path of the cache file belonging to a scene file.
+    static std::string cachePath(const std::string &scenePath);
+
+    // Load the cached flattened scene for scenePath by memory-mapping the cache file.
+    // @return  false if there is no cache, or it is stale, corrupt, or from another version.
+    static bool load(const std::string &scenePath, RenderData &renderData);
+
+    // Write renderData as the cache for scenePath.
+    // @return  false if the cache could not be written.
+    static bool store(const std::string &scenePath, const RenderData &renderData);
+};
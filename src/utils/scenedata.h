@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <memory_resource>
 
 #include <glm/glm.hpp>
 
@@ -160,10 +161,34 @@ struct SceneTransformation {
     glm::mat4 matrix;    // Only applicable when transforming by a custom matrix. This is that custom matrix.
 };
 
+// Struct which contains data for a top-level group whose contents are kept in a separate
+// chunk file, to be streamed in when the camera comes near
+struct SceneChunk {
+    std::string filename;
+    glm::vec3 boundsMin; // Bounding box of the chunk's contents, in the group's space
+    glm::vec3 boundsMax;
+};
+
 // Struct which represents a node in the scene graph/tree, to be parsed by the student's `SceneParser`.
+// The lists allocate from the given memory resource, normally the arena of the ScenefileReader
+// that owns the node.
 struct SceneNode {
-    std::vector<SceneTransformation*> transformations; // Note the order of transformations described in lab 5
-    std::vector<ScenePrimitive*> primitives;
-    std::vector<SceneLight*> lights;
-    std::vector<SceneNode*> children;
+    explicit SceneNode(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : transformations(resource), primitives(resource), lights(resource), children(resource) {}
+
+    std::pmr::vector<SceneTransformation*> transformations; // Note the order of transformations described in lab 5
+    std::pmr::vector<ScenePrimitive*> primitives;
+    std::pmr::vector<SceneLight*> lights;
+    std::pmr::vector<SceneNode*> children;
+
+    // The transformations above folded into one matrix by the reader, so flattening
+    // does not have to rebuild it on every visit
+    glm::mat4 localMatrix = glm::mat4(1.0f);
+    bool isIdentity = true;
+
+    // Set on the roots of template groups, which can be referenced from many places
+    bool isTemplate = false;
+
+    // Set on top-level groups that reference a chunk file
+    SceneChunk *chunk = nullptr;
 };
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "hash.h"
+#include "scenedata.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+// Every key that may appear on an object in a scene file. Within each object, required
+// fields are listed in the order their "missing required field" errors are reported.
+enum class SceneField : uint8_t {
+    // root
+    GlobalData, CameraData, TemplateGroups, Groups, Name,
+    // globalData
+    AmbientCoeff, DiffuseCoeff, SpecularCoeff, TransparentCoeff,
+    // cameraData
+    Position, Up, HeightAngle, Aperture, FocalLength, Look, Focus,
+    // groups and templateGroups
+    Translate, Rotate, Scale, Matrix, Lights, Primitives, ChunkFile, Bounds,
+    // primitives
+    Type, MeshFile, Ambient, Diffuse, Specular, Reflective, Transparent, Shininess, Ior, Blend,
+    TextureFile, TextureU, TextureV, BumpMapFile, BumpMapU, BumpMapV,
+    // lights
+    Color, Direction, Penumbra, Angle, AttenuationCoeff,
+
+    Count,
+    Unknown = Count,
+};
+
+inline constexpr std::array<std::string_view, size_t(SceneField::Count)> kSceneFieldNames = {
+    "globalData", "cameraData", "templateGroups", "groups", "name",
+    "ambientCoeff", "diffuseCoeff", "specularCoeff", "transparentCoeff",
+    "position", "up", "heightAngle", "aperture", "focalLength", "look", "focus",
+    "translate", "rotate", "scale", "matrix", "lights", "primitives", "chunkFile", "bounds",
+    "type", "meshFile", "ambient", "diffuse", "specular", "reflective", "transparent", "shininess", "ior", "blend",
+    "textureFile", "textureU", "textureV", "bumpMapFile", "bumpMapU", "bumpMapV",
+    "color", "direction", "penumbra", "angle", "attenuationCoeff",
+};
+
+// Open-addressed hash table from string keys to enum values, built at compile time.
+// Capacity must be a power of two, at least twice the number of keys.
+template <typename Enum, size_t Capacity>
+class KeyTable {
+public:
+    template <size_t N>
+    constexpr KeyTable(const std::array<std::pair<std::string_view, Enum>, N> &entries) {
+        static_assert((Capacity & (Capacity - 1)) == 0 && Capacity >= 2 * N);
+        for (const auto &[key, value] : entries) {
+            size_t slot = fnv1a64(key) & (Capacity - 1);
+            while (!m_keys[slot].empty()) {
+                slot = (slot + 1) & (Capacity - 1);
+            }
+            m_keys[slot] = key;
+            m_values[slot] = value;
+        }
+    }
+
+    // Look up key and store its value in value.
+    // @return  false if key is not in the table.
+    constexpr bool find(std::string_view key, Enum &value) const {
+        size_t slot = fnv1a64(key) & (Capacity - 1);
+        while (!m_keys[slot].empty()) {
+            if (m_keys[slot] == key) {
+                value = m_values[slot];
+                return true;
+            }
+            slot = (slot + 1) & (Capacity - 1);
+        }
+        return false;
+    }
+
+private:
+    std::array<std::string_view, Capacity> m_keys{};
+    std::array<Enum, Capacity> m_values{};
+};
+
+namespace scenefields {
+
+constexpr auto fieldEntries() {
+    std::array<std::pair<std::string_view, SceneField>, size_t(SceneField::Count)> entries;
+    for (size_t i = 0; i < entries.size(); i++) {
+        entries[i] = {kSceneFieldNames[i], SceneField(i)};
+    }
+    return entries;
+}
+
+inline constexpr KeyTable<SceneField, 128> kFields(fieldEntries());
+
+inline constexpr KeyTable<PrimitiveType, 16> kPrimitiveTypes(std::array<std::pair<std::string_view, PrimitiveType>, 5>{{
+    {"cube", PrimitiveType::PRIMITIVE_CUBE},
+    {"cone", PrimitiveType::PRIMITIVE_CONE},
+    {"cylinder", PrimitiveType::PRIMITIVE_CYLINDER},
+    {"sphere", PrimitiveType::PRIMITIVE_SPHERE},
+    {"mesh", PrimitiveType::PRIMITIVE_MESH},
+}});
+
+inline constexpr KeyTable<LightType, 8> kLightTypes(std::array<std::pair<std::string_view, LightType>, 3>{{
+    {"point", LightType::LIGHT_POINT},
+    {"directional", LightType::LIGHT_DIRECTIONAL},
+    {"spot", LightType::LIGHT_SPOT},
+}});
+
+}
+
+constexpr SceneField sceneField(std::string_view key) {
+    SceneField field = SceneField::Unknown;
+    scenefields::kFields.find(key, field);
+    return field;
+}
+
+constexpr std::string_view sceneFieldName(SceneField field) {
+    return field == SceneField::Unknown ? std::string_view("?") : kSceneFieldNames[size_t(field)];
+}
+
+// @return  false if name is not a primitive type.
+constexpr bool primitiveTypeFromName(std::string_view name, PrimitiveType &type) {
+    return scenefields::kPrimitiveTypes.find(name, type);
+}
+
+// @return  false if name is not a light type.
+constexpr bool lightTypeFromName(std::string_view name, LightType &type) {
+    return scenefields::kLightTypes.find(name, type);
+}
+
+static_assert(sceneField("bumpMapV") == SceneField::BumpMapV);
+static_assert(sceneField("attenuationCoeff") == SceneField::AttenuationCoeff);
+static_assert(sceneField("bogus") == SceneField::Unknown);
+
+// Set of fields as a bitmask, one bit per SceneField.
+using SceneFieldSet = uint64_t;
+static_assert(size_t(SceneField::Count) <= 64);
+
+constexpr SceneFieldSet fieldBit(SceneField field) {
+    return field == SceneField::Unknown ? 0 : SceneFieldSet(1) << size_t(field);
+}
+
+template <typename... Fields>
+constexpr SceneFieldSet fieldSet(Fields... fields) {
+    return (fieldBit(fields) | ... | 0);
+}
+
+// Which fields an object of a given kind must and may have.
+struct SceneObjectSchema {
+    std::string_view name; // as used in error messages
+    SceneFieldSet required;
+    SceneFieldSet allowed;
+    bool requiredFirst = false; // missing fields are reported before unknown ones
+
+    constexpr bool allows(SceneField field) const {
+        return (allowed & fieldBit(field)) != 0;
+    }
+
+    // @return  the first required field missing from present, or SceneField::Unknown.
+    constexpr SceneField firstMissing(SceneFieldSet present) const {
+        SceneFieldSet missing = required & ~present;
+        for (size_t i = 0; i < size_t(SceneField::Count); i++) {
+            if (missing & (SceneFieldSet(1) << i)) {
+                return SceneField(i);
+            }
+        }
+        return SceneField::Unknown;
+    }
+};
+
+namespace scenefields {
+
+using F = SceneField;
+
+inline constexpr SceneFieldSet kGroupFields =
+    fieldSet(F::Name, F::Translate, F::Rotate, F::Scale, F::Matrix, F::Lights, F::Primitives, F::Groups);
+inline constexpr SceneFieldSet kLightFields =
+    fieldSet(F::Type, F::Color, F::Name, F::AttenuationCoeff, F::Direction, F::Penumbra, F::Angle);
+
+}
+
+// The root is the one object whose required fields are checked before its unknown ones
+inline constexpr SceneObjectSchema kRootSchema = {
+    "root",
+    fieldSet(SceneField::GlobalData, SceneField::CameraData),
+    fieldSet(SceneField::GlobalData, SceneField::CameraData, SceneField::Name, SceneField::Groups, SceneField::TemplateGroups),
+    true,
+};
+
+// Chunk files hold only groups; global and camera data come from the scene that references them
+inline constexpr SceneObjectSchema kChunkRootSchema = {
+    "chunk",
+    0,
+    fieldSet(SceneField::Name, SceneField::Groups, SceneField::TemplateGroups),
+};
+
+inline constexpr SceneObjectSchema kGlobalDataSchema = {
+    "globalData",
+    fieldSet(SceneField::AmbientCoeff, SceneField::DiffuseCoeff, SceneField::SpecularCoeff),
+    fieldSet(SceneField::AmbientCoeff, SceneField::DiffuseCoeff, SceneField::SpecularCoeff, SceneField::TransparentCoeff),
+};
+
+inline constexpr SceneObjectSchema kCameraDataSchema = {
+    "cameraData",
+    fieldSet(SceneField::Position, SceneField::Up, SceneField::HeightAngle),
+    fieldSet(SceneField::Position, SceneField::Up, SceneField::HeightAngle, SceneField::Aperture,
+             SceneField::FocalLength, SceneField::Look, SceneField::Focus),
+};
+
+inline constexpr SceneObjectSchema kTemplateGroupSchema = {
+    "templateGroup",
+    fieldSet(SceneField::Name),
+    scenefields::kGroupFields,
+};
+
+inline constexpr SceneObjectSchema kGroupSchema = {
+    "group",
+    0,
+    scenefields::kGroupFields,
+};
+
+// Groups directly under the root of a scene may also reference a chunk file
+inline constexpr SceneObjectSchema kTopLevelGroupSchema = {
+    "group",
+    0,
+    scenefields::kGroupFields | fieldSet(SceneField::ChunkFile, SceneField::Bounds),
+};
+
+inline constexpr SceneObjectSchema kPrimitiveSchema = {
+    "primitive",
+    fieldSet(SceneField::Type),
+    fieldSet(SceneField::Type, SceneField::MeshFile, SceneField::Ambient, SceneField::Diffuse, SceneField::Specular,
+             SceneField::Reflective, SceneField::Transparent, SceneField::Shininess, SceneField::Ior, SceneField::Blend,
+             SceneField::TextureFile, SceneField::TextureU, SceneField::TextureV, SceneField::BumpMapFile,
+             SceneField::BumpMapU, SceneField::BumpMapV),
+};
+
+inline constexpr SceneObjectSchema kLightSchema = {
+    "light",
+    fieldSet(SceneField::Type, SceneField::Color),
+    scenefields::kLightFields,
+};
+
+// Spot lights need everything the cone and falloff are computed from
+inline constexpr SceneObjectSchema kSpotLightSchema = {
+    "spotlight",
+    fieldSet(SceneField::Direction, SceneField::Penumbra, SceneField::Angle, SceneField::AttenuationCoeff),
+    scenefields::kLightFields,
+};
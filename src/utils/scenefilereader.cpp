@@ -1,7 +1,9 @@
 #include "scenefilereader.h"
 #include "scenedata.h"
+#include "scenefields.h"
 
 #include "glm/gtc/type_ptr.hpp"
+#include "glm/gtx/transform.hpp"
 
 #include <cassert>
 #include <cstring>
@@ -17,42 +19,138 @@
 #define UNSUPPORTED_ELEMENT(e) std::cout << ERROR_AT(e) << "unsupported element <" \
                                          << e.tagName().toStdString() << ">" << std::endl;
 
+namespace {
+
+// Looks up a JSON key without converting it to a std::string. Scene keys are short and
+// ASCII, so anything else cannot be a known field.
+SceneField fieldOf(const QString &key) {
+    char buffer[32];
+    if (key.size() > qsizetype(sizeof(buffer))) {
+        return SceneField::Unknown;
+    }
+    const QChar *chars = key.constData();
+    for (qsizetype i = 0; i < key.size(); i++) {
+        if (chars[i].unicode() > 0x7f) {
+            return SceneField::Unknown;
+        }
+        buffer[i] = char(chars[i].unicode());
+    }
+    return sceneField(std::string_view(buffer, key.size()));
+}
+
+// Checks the keys of object against schema, with one table lookup per key. The first
+// unknown field in key order is reported before a missing one, unless the schema asks
+// for required fields first.
+// @return  false, after printing why, if a field is unknown or a required one is missing.
+bool checkFields(const QJsonObject &object, const SceneObjectSchema &schema) {
+    SceneFieldSet present = 0;
+    auto unknown = object.end();
+    for (auto it = object.begin(); it != object.end(); ++it) {
+        SceneField field = fieldOf(it.key());
+        if (!schema.allows(field)) {
+            if (!schema.requiredFirst) {
+                std::cout << "unknown field \"" << it.key().toStdString() << "\" on " << schema.name << " object" << std::endl;
+                return false;
+            }
+            if (unknown == object.end()) {
+                unknown = it;
+            }
+            continue;
+        }
+        present |= fieldBit(field);
+    }
+
+    SceneField missing = schema.firstMissing(present);
+    if (missing != SceneField::Unknown) {
+        std::cout << "missing required field \"" << sceneFieldName(missing) << "\" on " << schema.name << " object" << std::endl;
+        return false;
+    }
+    if (unknown != object.end()) {
+        std::cout << "unknown field \"" << unknown.key().toStdString() << "\" on " << schema.name << " object" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
 // Students, please ignore this file.
-ScenefileReader::ScenefileReader(const std::string &name) {
+ScenefileReader::ScenefileReader(const std::string &name, bool isChunk) : m_arena(64 * 1024) {
     file_name = name;
+    m_isChunk = isChunk;
 
     memset(&m_cameraData, 0, sizeof(SceneCameraData));
     memset(&m_globalData, 0, sizeof(SceneGlobalData));
 
-    m_root = new SceneNode;
-
     m_templates.clear();
-    m_nodes.clear();
 
-    m_nodes.push_back(m_root);
+    m_root = newNode();
 }
 
 ScenefileReader::~ScenefileReader() {
-    // Delete all Scene Nodes
-    for (unsigned int node = 0; node < m_nodes.size(); node++) {
-        for (size_t i = 0; i < (m_nodes[node])->transformations.size(); i++)
-        {
-            delete (m_nodes[node])->transformations[i];
-        }
-        for (size_t i = 0; i < (m_nodes[node])->primitives.size(); i++)
-        {
-            delete (m_nodes[node])->primitives[i];
-        }
-        (m_nodes[node])->transformations.clear();
-        (m_nodes[node])->primitives.clear();
-        (m_nodes[node])->children.clear();
-        delete m_nodes[node];
+    // Everything else lives in m_arena, which frees its memory in one go
+    for (ScenePrimitive *primitive : m_primitives) {
+        primitive->~ScenePrimitive();
+    }
+    for (SceneChunk *chunk : m_chunks) {
+        chunk->~SceneChunk();
     }
 
-    m_nodes.clear();
+    m_primitives.clear();
+    m_chunks.clear();
     m_templates.clear();
 }
 
+SceneNode *ScenefileReader::newNode() {
+    return new (m_arena.allocate(sizeof(SceneNode), alignof(SceneNode))) SceneNode(&m_arena);
+}
+
+SceneTransformation *ScenefileReader::newTransformation() {
+    return new (m_arena.allocate(sizeof(SceneTransformation), alignof(SceneTransformation))) SceneTransformation();
+}
+
+ScenePrimitive *ScenefileReader::newPrimitive() {
+    ScenePrimitive *primitive = new (m_arena.allocate(sizeof(ScenePrimitive), alignof(ScenePrimitive))) ScenePrimitive();
+    m_primitives.push_back(primitive);
+    return primitive;
+}
+
+SceneLight *ScenefileReader::newLight() {
+    return new (m_arena.allocate(sizeof(SceneLight), alignof(SceneLight))) SceneLight();
+}
+
+// Chunk paths are relative to the directory of the scene file referencing them
+SceneChunk *ScenefileReader::newChunk(const std::string &relativePath) {
+    SceneChunk *chunk = new (m_arena.allocate(sizeof(SceneChunk), alignof(SceneChunk))) SceneChunk();
+    m_chunks.push_back(chunk);
+    chunk->filename = (std::filesystem::path(file_name).parent_path() / relativePath).string();
+    return chunk;
+}
+
+void ScenefileReader::bakeLocalMatrix(SceneNode *node) {
+    glm::mat4 localMatrix = glm::mat4(1.0f);
+
+    for (SceneTransformation *transform : node->transformations) {
+        switch (transform->type) {
+        case TransformationType::TRANSFORMATION_TRANSLATE:
+            localMatrix *= glm::translate(transform->translate);
+            break;
+        case TransformationType::TRANSFORMATION_ROTATE:
+            localMatrix *= glm::rotate(transform->angle, transform->rotate);
+            break;
+        case TransformationType::TRANSFORMATION_SCALE:
+            localMatrix *= glm::scale(transform->scale);
+            break;
+        case TransformationType::TRANSFORMATION_MATRIX:
+            localMatrix *= transform->matrix;
+            break;
+        }
+    }
+
+    node->localMatrix = localMatrix;
+    node->isIdentity = localMatrix == glm::mat4(1.0f);
+}
+
 SceneGlobalData ScenefileReader::getGlobalData() const {
     return m_globalData;
 }
@@ -65,6 +163,20 @@ SceneNode *ScenefileReader::getRootNode() const {
     return m_root;
 }
 
+void ScenefileReader::setProgress(std::atomic<float> *progress, float begin, float end) {
+    m_progress = progress;
+    m_progressBegin = begin;
+    m_progressEnd = end;
+}
+
+void ScenefileReader::reportProgress(size_t bytesRead, size_t fileSize) {
+    if (m_progress == nullptr || fileSize == 0) {
+        return;
+    }
+    float fraction = static_cast<float>(bytesRead) / static_cast<float>(fileSize);
+    m_progress->store(m_progressBegin + (m_progressEnd - m_progressBegin) * fraction, std::memory_order_relaxed);
+}
+
 // This is where it all goes down...
 bool ScenefileReader::readJSON() {
     // Read the file
@@ -94,34 +206,19 @@ bool ScenefileReader::readJSON() {
     // Get the root element
     QJsonObject scenefile = doc.object();
 
-    if (!scenefile.contains("globalData")) {
-        std::cout << "missing required field \"globalData\" on root object" << std::endl;
-        return false;
-    }
-    if (!scenefile.contains("cameraData")) {
-        std::cout << "missing required field \"cameraData\" on root object" << std::endl;
+    // If other fields are present, or required ones are missing, raise an error
+    if (!checkFields(scenefile, m_isChunk ? kChunkRootSchema : kRootSchema)) {
         return false;
     }
 
-    QStringList requiredFields = {"globalData", "cameraData"};
-    QStringList optionalFields = {"name", "groups", "templateGroups"};
-    // If other fields are present, raise an error
-    QStringList allFields = requiredFields + optionalFields;
-    for (auto &field : scenefile.keys()) {
-        if (!allFields.contains(field)) {
-            std::cout << "unknown field \"" << field.toStdString() << "\" on root object" << std::endl;
-            return false;
-        }
-    }
-
     // Parse the global data
-    if (!parseGlobalData(scenefile["globalData"].toObject())) {
+    if (!m_isChunk && !parseGlobalData(scenefile["globalData"].toObject())) {
         std::cout << "could not parse \"globalData\"" << std::endl;
         return false;
     }
 
     // Parse the camera data
-    if (!parseCameraData(scenefile["cameraData"].toObject())) {
+    if (!m_isChunk && !parseCameraData(scenefile["cameraData"].toObject())) {
         std::cout << "could not parse \"cameraData\"" << std::endl;
         return false;
     }
@@ -140,6 +237,7 @@ bool ScenefileReader::readJSON() {
         }
     }
 
+    reportProgress(1, 1);
     std::cout << "Finished reading " << file_name << std::endl;
     return true;
 }
@@ -148,20 +246,8 @@ bool ScenefileReader::readJSON() {
  * Parse a globalData field and fill in m_globalData.
  */
 bool ScenefileReader::parseGlobalData(const QJsonObject &globalData) {
-    QStringList requiredFields = {"ambientCoeff", "diffuseCoeff", "specularCoeff"};
-    QStringList optionalFields = {"transparentCoeff"};
-    QStringList allFields = requiredFields + optionalFields;
-    for (auto field : globalData.keys()) {
-        if (!allFields.contains(field)) {
-            std::cout << "unknown field \"" << field.toStdString() << "\" on globalData object" << std::endl;
-            return false;
-        }
-    }
-    for (auto field : requiredFields) {
-        if (!globalData.contains(field)) {
-            std::cout << "missing required field \"" << field.toStdString() << "\" on globalData object" << std::endl;
-            return false;
-        }
+    if (!checkFields(globalData, kGlobalDataSchema)) {
+        return false;
     }
 
     // Parse the global data
@@ -203,24 +289,12 @@ bool ScenefileReader::parseGlobalData(const QJsonObject &globalData) {
  * Parse a Light and add a new CS123SceneLightData to m_lights.
  */
 bool ScenefileReader::parseLightData(const QJsonObject &lightData, SceneNode *node) {
-    QStringList requiredFields = {"type", "color"};
-    QStringList optionalFields = {"name", "attenuationCoeff", "direction", "penumbra", "angle"};
-    QStringList allFields = requiredFields + optionalFields;
-    for (auto &field : lightData.keys()) {
-        if (!allFields.contains(field)) {
-            std::cout << "unknown field \"" << field.toStdString() << "\" on light object" << std::endl;
-            return false;
-        }
-    }
-    for (auto &field : requiredFields) {
-        if (!lightData.contains(field)) {
-            std::cout << "missing required field \"" << field.toStdString() << "\" on light object" << std::endl;
-            return false;
-        }
+    if (!checkFields(lightData, kLightSchema)) {
+        return false;
     }
 
     // Create a default light
-    SceneLight *light = new SceneLight();
+    SceneLight *light = newLight();
     memset(light, 0, sizeof(SceneLight));
     node->lights.push_back(light);
 
@@ -251,10 +325,13 @@ bool ScenefileReader::parseLightData(const QJsonObject &lightData, SceneNode *no
         return false;
     }
     std::string lightType = lightData["type"].toString().toStdString();
+    if (!lightTypeFromName(lightType, light->type)) {
+        std::cout << "unknown light type \"" << lightType << "\"" << std::endl;
+        return false;
+    }
 
     // parse directional light
-    if (lightType == "directional") {
-        light->type = LightType::LIGHT_DIRECTIONAL;
+    if (light->type == LightType::LIGHT_DIRECTIONAL) {
 
         // parse direction
         if (!lightData.contains("direction")) {
@@ -278,8 +355,7 @@ bool ScenefileReader::parseLightData(const QJsonObject &lightData, SceneNode *no
         light->dir.y = directionArray[1].toDouble();
         light->dir.z = directionArray[2].toDouble();
     }
-    else if (lightType == "point") {
-        light->type = LightType::LIGHT_POINT;
+    else if (light->type == LightType::LIGHT_POINT) {
 
         // parse the attenuation coefficient
         if (!lightData.contains("attenuationCoeff")) {
@@ -303,15 +379,10 @@ bool ScenefileReader::parseLightData(const QJsonObject &lightData, SceneNode *no
         light->function.y = attenuationArray[1].toDouble();
         light->function.z = attenuationArray[2].toDouble();
     }
-    else if (lightType == "spot") {
-        QStringList pointRequiredFields = {"direction", "penumbra", "angle", "attenuationCoeff"};
-        for (auto &field : pointRequiredFields) {
-            if (!lightData.contains(field)) {
-                std::cout << "missing required field \"" << field.toStdString() << "\" on spotlight object" << std::endl;
-                return false;
-            }
+    else {
+        if (!checkFields(lightData, kSpotLightSchema)) {
+            return false;
         }
-        light->type = LightType::LIGHT_SPOT;
 
         // parse direction
         if (!lightData["direction"].isArray()) {
@@ -363,10 +434,6 @@ bool ScenefileReader::parseLightData(const QJsonObject &lightData, SceneNode *no
         }
         light->angle = lightData["angle"].toDouble() * M_PI / 180.f;
     }
-    else {
-        std::cout << "unknown light type \"" << lightType << "\"" << std::endl;
-        return false;
-    }
 
     return true;
 }
@@ -375,20 +442,8 @@ bool ScenefileReader::parseLightData(const QJsonObject &lightData, SceneNode *no
  * Parse cameraData and fill in m_cameraData.
  */
 bool ScenefileReader::parseCameraData(const QJsonObject &cameradata) {
-    QStringList requiredFields = {"position", "up", "heightAngle"};
-    QStringList optionalFields = {"aperture", "focalLength", "look", "focus"};
-    QStringList allFields = requiredFields + optionalFields;
-    for (auto &field : cameradata.keys()) {
-        if (!allFields.contains(field)) {
-            std::cout << "unknown field \"" << field.toStdString() << "\" on cameraData object" << std::endl;
-            return false;
-        }
-    }
-    for (auto &field : requiredFields) {
-        if (!cameradata.contains(field)) {
-            std::cout << "missing required field \"" << field.toStdString() << "\" on cameraData object" << std::endl;
-            return false;
-        }
+    if (!checkFields(cameradata, kCameraDataSchema)) {
+        return false;
     }
 
     // Must have either look or focus, but not both
@@ -542,21 +597,8 @@ bool ScenefileReader::parseTemplateGroups(const QJsonValue &templateGroups) {
 }
 
 bool ScenefileReader::parseTemplateGroupData(const QJsonObject &templateGroup) {
-    QStringList requiredFields = {"name"};
-    QStringList optionalFields = {"translate", "rotate", "scale", "matrix", "lights", "primitives", "groups"};
-    QStringList allFields = requiredFields + optionalFields;
-    for (auto &field : templateGroup.keys()) {
-        if (!allFields.contains(field)) {
-            std::cout << "unknown field \"" << field.toStdString() << "\" on templateGroup object" << std::endl;
-            return false;
-        }
-    }
-
-    for (auto &field : requiredFields) {
-        if (!templateGroup.contains(field)) {
-            std::cout << "missing required field \"" << field.toStdString() << "\" on templateGroup object" << std::endl;
-            return false;
-        }
+    if (!checkFields(templateGroup, kTemplateGroupSchema)) {
+        return false;
     }
 
     if (!templateGroup["name"].isString()) {
@@ -566,25 +608,20 @@ bool ScenefileReader::parseTemplateGroupData(const QJsonObject &templateGroup) {
         std::cout << "templateGroups cannot have the same" << std::endl;
     }
 
-    SceneNode *templateNode = new SceneNode;
-    m_nodes.push_back(templateNode);
+    SceneNode *templateNode = newNode();
+    templateNode->isTemplate = true;
     m_templates[templateGroup["name"].toString().toStdString()] = templateNode;
 
-    return parseGroupData(templateGroup, templateNode);
+    return parseGroupData(templateGroup, templateNode, kGroupSchema);
 }
 
 /**
  * Parse a group object and create a new CS123SceneNode in m_nodes.
  * NAME OF NODE CANNOT REFERENCE TEMPLATE NODE
  */
-bool ScenefileReader::parseGroupData(const QJsonObject &object, SceneNode *node) {
-    QStringList optionalFields = {"name", "translate", "rotate", "scale", "matrix", "lights", "primitives", "groups"};
-    QStringList allFields = optionalFields;
-    for (auto &field : object.keys()) {
-        if (!allFields.contains(field)) {
-            std::cout << "unknown field \"" << field.toStdString() << "\" on group object" << std::endl;
-            return false;
-        }
+bool ScenefileReader::parseGroupData(const QJsonObject &object, SceneNode *node, const SceneObjectSchema &schema) {
+    if (!checkFields(object, schema)) {
+        return false;
     }
 
     // parse translation if defined
@@ -604,7 +641,7 @@ bool ScenefileReader::parseGroupData(const QJsonObject &object, SceneNode *node)
             return false;
         }
 
-        SceneTransformation *translation = new SceneTransformation();
+        SceneTransformation *translation = newTransformation();
         translation->type = TransformationType::TRANSFORMATION_TRANSLATE;
         translation->translate.x = translateArray[0].toDouble();
         translation->translate.y = translateArray[1].toDouble();
@@ -630,7 +667,7 @@ bool ScenefileReader::parseGroupData(const QJsonObject &object, SceneNode *node)
             return false;
         }
 
-        SceneTransformation *rotation = new SceneTransformation();
+        SceneTransformation *rotation = newTransformation();
         rotation->type = TransformationType::TRANSFORMATION_ROTATE;
         rotation->rotate.x = rotateArray[0].toDouble();
         rotation->rotate.y = rotateArray[1].toDouble();
@@ -657,7 +694,7 @@ bool ScenefileReader::parseGroupData(const QJsonObject &object, SceneNode *node)
             return false;
         }
 
-        SceneTransformation *scale = new SceneTransformation();
+        SceneTransformation *scale = newTransformation();
         scale->type = TransformationType::TRANSFORMATION_SCALE;
         scale->scale.x = scaleArray[0].toDouble();
         scale->scale.y = scaleArray[1].toDouble();
@@ -679,7 +716,7 @@ bool ScenefileReader::parseGroupData(const QJsonObject &object, SceneNode *node)
             return false;
         }
 
-        SceneTransformation *matrixTransformation = new SceneTransformation();
+        SceneTransformation *matrixTransformation = newTransformation();
         matrixTransformation->type = TransformationType::TRANSFORMATION_MATRIX;
 
         float *matrixPtr = glm::value_ptr(matrixTransformation->matrix);
@@ -713,6 +750,15 @@ bool ScenefileReader::parseGroupData(const QJsonObject &object, SceneNode *node)
         node->transformations.push_back(matrixTransformation);
     }
 
+    bakeLocalMatrix(node);
+
+    // parse chunk reference if defined
+    if (object.contains("chunkFile") || object.contains("bounds")) {
+        if (!parseChunkReference(object, node)) {
+            return false;
+        }
+    }
+
     // parse lights if any
     if (object.contains("lights")) {
         if (!object["lights"].isArray()) {
@@ -789,11 +835,11 @@ bool ScenefileReader::parseGroups(const QJsonValue &groups, SceneNode *parent) {
             }
         }
 
-        SceneNode *node = new SceneNode;
-        m_nodes.push_back(node);
+        SceneNode *node = newNode();
         parent->children.push_back(node);
 
-        if (!parseGroupData(group.toObject(), node)) {
+        bool topLevel = parent == m_root && !m_isChunk;
+        if (!parseGroupData(group.toObject(), node, topLevel ? kTopLevelGroupSchema : kGroupSchema)) {
             return false;
         }
     }
@@ -802,26 +848,58 @@ bool ScenefileReader::parseGroups(const QJsonValue &groups, SceneNode *parent) {
 }
 
 /**
- * Parse an <object type="primitive"> tag into node.
+ * Parse the chunkFile and bounds fields of a top-level group into node->chunk.
  */
-bool ScenefileReader::parsePrimitive(const QJsonObject &prim, SceneNode *node) {
-    QStringList requiredFields = {"type"};
-    QStringList optionalFields = {
-        "meshFile", "ambient", "diffuse", "specular", "reflective", "transparent", "shininess", "ior",
-        "blend", "textureFile", "textureU", "textureV", "bumpMapFile", "bumpMapU", "bumpMapV"};
+bool ScenefileReader::parseChunkReference(const QJsonObject &object, SceneNode *node) {
+    if (!object.contains("chunkFile")) {
+        std::cout << "group bounds requires field \"chunkFile\"" << std::endl;
+        return false;
+    }
+    if (!object["chunkFile"].isString()) {
+        std::cout << "group chunkFile must be of type string" << std::endl;
+        return false;
+    }
+    if (!object.contains("bounds")) {
+        std::cout << "group with chunkFile must contain field \"bounds\"" << std::endl;
+        return false;
+    }
 
-    QStringList allFields = requiredFields + optionalFields;
-    for (auto field : prim.keys()) {
-        if (!allFields.contains(field)) {
-            std::cout << "unknown field \"" << field.toStdString() << "\" on primitive object" << std::endl;
+    QJsonArray boundsArray = object["bounds"].toArray();
+    if (!object["bounds"].isArray() || boundsArray.size() != 2) {
+        std::cout << "group bounds must be an array of two corners" << std::endl;
+        return false;
+    }
+
+    glm::vec3 corners[2];
+    for (int i = 0; i < 2; i++) {
+        QJsonArray cornerArray = boundsArray[i].toArray();
+        if (!boundsArray[i].isArray() || cornerArray.size() != 3) {
+            std::cout << "group bounds corners must have 3 elements" << std::endl;
             return false;
         }
-    }
-    for (auto field : requiredFields) {
-        if (!prim.contains(field)) {
-            std::cout << "missing required field \"" << field.toStdString() << "\" on primitive object" << std::endl;
+        if (!cornerArray[0].isDouble() || !cornerArray[1].isDouble() || !cornerArray[2].isDouble()) {
+            std::cout << "group bounds must contain floating-point values" << std::endl;
             return false;
         }
+        corners[i] = glm::vec3(cornerArray[0].toDouble(), cornerArray[1].toDouble(), cornerArray[2].toDouble());
+    }
+    if (glm::any(glm::greaterThan(corners[0], corners[1]))) {
+        std::cout << "group bounds minimum must not exceed its maximum" << std::endl;
+        return false;
+    }
+
+    node->chunk = newChunk(object["chunkFile"].toString().toStdString());
+    node->chunk->boundsMin = corners[0];
+    node->chunk->boundsMax = corners[1];
+    return true;
+}
+
+/**
+ * Parse an <object type="primitive"> tag into node.
+ */
+bool ScenefileReader::parsePrimitive(const QJsonObject &prim, SceneNode *node) {
+    if (!checkFields(prim, kPrimitiveSchema)) {
+        return false;
     }
 
     if (!prim["type"].isString()) {
@@ -831,7 +909,7 @@ bool ScenefileReader::parsePrimitive(const QJsonObject &prim, SceneNode *node) {
     std::string primType = prim["type"].toString().toStdString();
 
     // Default primitive
-    ScenePrimitive *primitive = new ScenePrimitive();
+    ScenePrimitive *primitive = newPrimitive();
     SceneMaterial &mat = primitive->material;
     mat.clear();
     primitive->type = PrimitiveType::PRIMITIVE_CUBE;
@@ -841,16 +919,11 @@ bool ScenefileReader::parsePrimitive(const QJsonObject &prim, SceneNode *node) {
     node->primitives.push_back(primitive);
 
     std::filesystem::path basepath = std::filesystem::path(file_name).parent_path().parent_path();
-    if (primType == "sphere")
-        primitive->type = PrimitiveType::PRIMITIVE_SPHERE;
-    else if (primType == "cube")
-        primitive->type = PrimitiveType::PRIMITIVE_CUBE;
-    else if (primType == "cylinder")
-        primitive->type = PrimitiveType::PRIMITIVE_CYLINDER;
-    else if (primType == "cone")
-        primitive->type = PrimitiveType::PRIMITIVE_CONE;
-    else if (primType == "mesh") {
-        primitive->type = PrimitiveType::PRIMITIVE_MESH;
+    if (!primitiveTypeFromName(primType, primitive->type)) {
+        std::cout << "unknown primitive type \"" << primType << "\"" << std::endl;
+        return false;
+    }
+    if (primitive->type == PrimitiveType::PRIMITIVE_MESH) {
         if (!prim.contains("meshFile")) {
             std::cout << "primitive type mesh must contain field meshFile" << std::endl;
             return false;
@@ -863,10 +936,6 @@ bool ScenefileReader::parsePrimitive(const QJsonObject &prim, SceneNode *node) {
         std::filesystem::path relativePath(prim["meshFile"].toString().toStdString());
         primitive->meshfile = (basepath / relativePath).string();
     }
-    else {
-        std::cout << "unknown primitive type \"" << primType << "\"" << std::endl;
-        return false;
-    }
 
     if (prim.contains("ambient")) {
         if (!prim["ambient"].isArray()) {
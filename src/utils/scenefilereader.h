@@ -1,9 +1,12 @@
 #pragma once
 
 #include "scenedata.h"
+#include "scenefields.h"
 
+#include <atomic>
 #include <vector>
 #include <map>
+#include <memory_resource>
 
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -11,8 +14,9 @@
 // This class parses the scene graph specified by the CS123 Xml file format.
 class ScenefileReader {
 public:
-    // Create a ScenefileReader, passing it the scene file.
-    ScenefileReader(const std::string &filename);
+    // Create a ScenefileReader, passing it the scene file. Chunk files (see SceneChunk)
+    // have no global or camera data and cannot reference further chunks.
+    ScenefileReader(const std::string &filename, bool isChunk = false);
 
     // Clean up all data for the scene
     ~ScenefileReader();
@@ -20,13 +24,24 @@ public:
     // Parse the XML scene file. Returns false if scene is invalid.
     bool readJSON();
 
+    // Same as readJSON(), but parses the memory-mapped file in a single streaming pass
+    // instead of building a QJsonDocument first. Returns false if scene is invalid.
+    bool readJSONStreaming();
+
     SceneGlobalData getGlobalData() const;
 
     SceneCameraData getCameraData() const;
 
     SceneNode *getRootNode() const;
 
+    // While reading, store how far through the file we are into progress, scaled to
+    // the range [begin, end]. The streaming reader reports per group, readJSON() only
+    // once it is done.
+    void setProgress(std::atomic<float> *progress, float begin, float end);
+
 private:
+    friend class JsonSceneStream;
+
     // The filename should be contained within this parser implementation.
     // If you want to parse a new file, instantiate a different parser.
     bool parseGlobalData(const QJsonObject &globaldata);
@@ -34,11 +49,31 @@ private:
     bool parseTemplateGroups(const QJsonValue &templateGroups);
     bool parseTemplateGroupData(const QJsonObject &templateGroup);
     bool parseGroups(const QJsonValue &groups, SceneNode *parent);
-    bool parseGroupData(const QJsonObject &object, SceneNode *node);
+    bool parseGroupData(const QJsonObject &object, SceneNode *node, const SceneObjectSchema &schema);
+    bool parseChunkReference(const QJsonObject &object, SceneNode *node);
     bool parsePrimitive(const QJsonObject &prim, SceneNode *node);
     bool parseLightData(const QJsonObject &lightData, SceneNode *node);
 
+    // Scene graph objects are bump-allocated from m_arena and released all at once
+    // with the reader. Only primitives and chunks own heap memory (their strings), so
+    // they are the only objects whose destructors are run.
+    SceneNode *newNode();
+    SceneTransformation *newTransformation();
+    ScenePrimitive *newPrimitive();
+    SceneLight *newLight();
+    SceneChunk *newChunk(const std::string &relativePath);
+
+    // Fold node->transformations into node->localMatrix once they are all parsed.
+    static void bakeLocalMatrix(SceneNode *node);
+
+    void reportProgress(size_t bytesRead, size_t fileSize);
+
     std::string file_name;
+    bool m_isChunk;
+
+    std::pmr::monotonic_buffer_resource m_arena;
+    std::vector<ScenePrimitive *> m_primitives;
+    std::vector<SceneChunk *> m_chunks;
 
     mutable std::map<std::string, SceneNode *> m_templates;
 
@@ -46,5 +81,8 @@ private:
     SceneCameraData m_cameraData;
 
     SceneNode *m_root;
-    std::vector<SceneNode *> m_nodes;
+
+    std::atomic<float> *m_progress = nullptr;
+    float m_progressBegin = 0.f;
+    float m_progressEnd = 1.f;
 };
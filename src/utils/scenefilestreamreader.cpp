@@ -0,0 +1,1148 @@
+#include "scenefilereader.h"
+#include "scenedata.h"
+#include "jsoncursor.h"
+#include "scenefields.h"
+#include "mappedfile.h"
+
+#include "glm/gtc/type_ptr.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <filesystem>
+
+// Streaming counterpart of ScenefileReader::readJSON(). The scene file is memory-mapped
+// and walked once with a JsonCursor; every object is built straight into the scene graph
+// without an intermediate QJsonDocument.
+//
+// Small objects (globalData, cameraData, lights, primitives and the transforms of a
+// group) are collected into slots first and then validated in the same order and with
+// the same messages as the Qt reader. A group's keys are scanned once before its members
+// are parsed, since a template reference skips the whole group. Child lights, primitives
+// and groups are parsed as they are reached. On an invalid file the first message reported can therefore differ
+// from the Qt reader; on a valid file the resulting scene graph is identical.
+
+namespace {
+
+using Type = JsonCursor::Type;
+
+// A JSON number (or something that should have been one).
+struct NumberSlot {
+    bool present = false;
+    bool isDouble = false;
+    double value = 0;
+};
+
+struct StringSlot {
+    bool present = false;
+    bool isString = false;
+    std::string value;
+};
+
+// A fixed-size array of numbers. Only the first four elements are kept, which is
+// enough for every array in the format.
+struct ArraySlot {
+    bool present = false;
+    bool isArray = false;
+    int size = 0;
+    bool allDoubles = true;
+    double values[4] = {};
+};
+
+// Array of arrays, for the group "matrix" field.
+struct MatrixSlot {
+    bool present = false;
+    bool isArray = false;
+    int size = 0;
+    ArraySlot rows[4];
+};
+
+// Each read() returns false only on a syntax error. A value of the wrong type is
+// skipped and recorded in the slot, so validation can report it later.
+bool read(JsonCursor &in, NumberSlot &slot) {
+    slot = NumberSlot();
+    slot.present = true;
+    if (in.peek() != Type::Number) {
+        return in.skipValue();
+    }
+    slot.isDouble = true;
+    return in.readNumber(slot.value);
+}
+
+bool read(JsonCursor &in, StringSlot &slot) {
+    slot = StringSlot();
+    slot.present = true;
+    if (in.peek() != Type::String) {
+        return in.skipValue();
+    }
+    slot.isString = true;
+    return in.readString(slot.value);
+}
+
+bool read(JsonCursor &in, ArraySlot &slot) {
+    slot = ArraySlot();
+    slot.present = true;
+    if (in.peek() != Type::Array) {
+        return in.skipValue();
+    }
+    slot.isArray = true;
+    in.beginArray();
+    while (in.nextElement()) {
+        if (in.peek() == Type::Number) {
+            double value;
+            if (!in.readNumber(value)) {
+                return false;
+            }
+            if (slot.size < 4) {
+                slot.values[slot.size] = value;
+            }
+        }
+        else {
+            slot.allDoubles = false;
+            if (!in.skipValue()) {
+                return false;
+            }
+        }
+        slot.size++;
+    }
+    return !in.failed();
+}
+
+bool read(JsonCursor &in, MatrixSlot &slot) {
+    slot = MatrixSlot();
+    slot.present = true;
+    if (in.peek() != Type::Array) {
+        return in.skipValue();
+    }
+    slot.isArray = true;
+    in.beginArray();
+    while (in.nextElement()) {
+        if (slot.size < 4) {
+            if (!read(in, slot.rows[slot.size])) {
+                return false;
+            }
+        }
+        else if (!in.skipValue()) {
+            return false;
+        }
+        slot.size++;
+    }
+    return !in.failed();
+}
+
+bool unknownField(std::string_view field, const char *object) {
+    std::cout << "unknown field \"" << field << "\" on " << object << " object" << std::endl;
+    return false;
+}
+
+bool missingField(const char *field, const char *object) {
+    std::cout << "missing required field \"" << field << "\" on " << object << " object" << std::endl;
+    return false;
+}
+
+// The unknown field of an object that the Qt reader would name: the first in sorted key
+// order. Unknown fields are skipped while the object is read and reported once it has
+// been, before its missing fields (after them on the root object).
+struct UnknownField {
+    bool present = false;
+    std::string key;
+
+    bool skip(JsonCursor &in, std::string_view field) {
+        if (!present || field < key) {
+            present = true;
+            key = field;
+        }
+        return in.skipValue();
+    }
+};
+
+// Validation shared by the five primitive colors.
+bool parseColor(const ArraySlot &slot, const char *field, SceneColor &color) {
+    if (!slot.isArray) {
+        std::cout << "primitive " << field << " must be of type array" << std::endl;
+        return false;
+    }
+    if (slot.size != 3) {
+        std::cout << "primitive " << field << " array must be of size 3" << std::endl;
+        return false;
+    }
+    if (!slot.allDoubles) {
+        std::cout << "primitive " << field << " must contain floating-point values" << std::endl;
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        color[i] = slot.values[i];
+    }
+    return true;
+}
+
+// Validation shared by the camera vectors.
+bool parseCameraVector(const ArraySlot &slot, const char *field, glm::vec4 &vector, float w) {
+    if (!slot.isArray) {
+        std::cout << "cameraData " << field << " must be an array" << std::endl;
+        return false;
+    }
+    if (slot.size != 3) {
+        std::cout << "cameraData " << field << " must have 3 elements" << std::endl;
+        return false;
+    }
+    if (!slot.allDoubles) {
+        std::cout << "cameraData " << field << " must be a floating-point value" << std::endl;
+        return false;
+    }
+    vector = glm::vec4(slot.values[0], slot.values[1], slot.values[2], w);
+    return true;
+}
+
+// Validation shared by translate, rotate and scale.
+bool checkTransform(const ArraySlot &slot, const char *field, int size) {
+    if (!slot.isArray) {
+        std::cout << "group " << field << " must be of type array" << std::endl;
+        return false;
+    }
+    if (slot.size != size) {
+        std::cout << "group " << field << " must have " << size << " elements" << std::endl;
+        return false;
+    }
+    if (!slot.allDoubles) {
+        std::cout << "group " << field << " must contain floating-point values" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+class JsonSceneStream {
+public:
+    JsonSceneStream(ScenefileReader &reader, JsonCursor &in) : m_reader(reader), m_in(in) {}
+
+    bool parseScene();
+
+private:
+    bool parseGlobalData();
+    bool parseCameraData();
+    bool parseTemplateGroups();
+    bool parseTemplateGroupsAhead();
+    bool parseTemplateGroup();
+    bool parseGroups(SceneNode *parent);
+    bool parseGroupData(SceneNode *node, bool isTemplate, bool topLevel, StringSlot &name, bool &isReference);
+    bool parseChunkReference(const StringSlot &chunkFile, const MatrixSlot &bounds, SceneNode *node);
+    bool parsePrimitive(SceneNode *node);
+    bool parseLightData(SceneNode *node);
+
+    ScenefileReader &m_reader;
+    JsonCursor &m_in;
+
+    bool m_templatesParsed = false;
+};
+
+bool JsonSceneStream::parseScene() {
+    if (m_in.peek() == Type::Array) {
+        if (!m_in.skipValue() || !m_in.expectEnd()) {
+            return false;
+        }
+        std::cout << "document is not an object" << std::endl;
+        return false;
+    }
+    if (!m_in.beginObject()) {
+        return false;
+    }
+
+    bool hasGlobalData = false;
+    bool hasCameraData = false;
+    UnknownField unknown;
+
+    std::string_view key;
+    while (m_in.nextMember(key)) {
+        SceneField field = sceneField(key);
+        if (m_reader.m_isChunk && !kChunkRootSchema.allows(field)) {
+            if (!unknown.skip(m_in, key)) {
+                return false;
+            }
+        }
+        else if (field == SceneField::GlobalData) {
+            hasGlobalData = true;
+            if (!parseGlobalData()) {
+                if (!m_in.failed()) {
+                    std::cout << "could not parse \"globalData\"" << std::endl;
+                }
+                return false;
+            }
+        }
+        else if (field == SceneField::CameraData) {
+            hasCameraData = true;
+            if (!parseCameraData()) {
+                if (!m_in.failed()) {
+                    std::cout << "could not parse \"cameraData\"" << std::endl;
+                }
+                return false;
+            }
+        }
+        else if (field == SceneField::TemplateGroups) {
+            if (m_templatesParsed ? !m_in.skipValue() : !parseTemplateGroups()) {
+                return false;
+            }
+            m_templatesParsed = true;
+        }
+        else if (field == SceneField::Groups) {
+            if (!m_templatesParsed && !parseTemplateGroupsAhead()) {
+                return false;
+            }
+            if (!parseGroups(m_reader.m_root)) {
+                return false;
+            }
+        }
+        else if (field == SceneField::Name) {
+            if (!m_in.skipValue()) {
+                return false;
+            }
+        }
+        else if (!unknown.skip(m_in, key)) {
+            return false;
+        }
+    }
+    if (m_in.failed() || !m_in.expectEnd()) {
+        return false;
+    }
+
+    if (!hasGlobalData && !m_reader.m_isChunk) {
+        std::cout << "missing required field \"globalData\" on root object" << std::endl;
+        return false;
+    }
+    if (!hasCameraData && !m_reader.m_isChunk) {
+        std::cout << "missing required field \"cameraData\" on root object" << std::endl;
+        return false;
+    }
+    if (unknown.present) {
+        return unknownField(unknown.key, m_reader.m_isChunk ? "chunk" : "root");
+    }
+
+    return true;
+}
+
+/**
+ * The Qt reader parses templateGroups before groups, which may reference them. Groups
+ * that come first in the file (as they do with sorted keys) are skipped to find the
+ * templateGroups, which are parsed before coming back to the groups.
+ */
+bool JsonSceneStream::parseTemplateGroupsAhead() {
+    JsonCursor::Mark groups = m_in.mark();
+    if (!m_in.skipValue()) {
+        return false;
+    }
+    std::string_view key;
+    while (m_in.nextMember(key)) {
+        if (sceneField(key) == SceneField::TemplateGroups) {
+            if (!parseTemplateGroups()) {
+                return false;
+            }
+            break;
+        }
+        if (!m_in.skipValue()) {
+            return false;
+        }
+    }
+    if (m_in.failed()) {
+        return false;
+    }
+    m_templatesParsed = true;
+    m_in.rewind(groups);
+    return true;
+}
+
+/**
+ * Parse a globalData field and fill in m_globalData.
+ */
+bool JsonSceneStream::parseGlobalData() {
+    NumberSlot ambient, diffuse, specular, transparent;
+    UnknownField unknown;
+
+    // Anything that is not an object reads as an empty one, like QJsonValue::toObject()
+    if (m_in.peek() != Type::Object) {
+        if (!m_in.skipValue()) {
+            return false;
+        }
+    }
+    else {
+        m_in.beginObject();
+        std::string_view key;
+        while (m_in.nextMember(key)) {
+            bool ok;
+            switch (sceneField(key)) {
+            case SceneField::AmbientCoeff: ok = read(m_in, ambient); break;
+            case SceneField::DiffuseCoeff: ok = read(m_in, diffuse); break;
+            case SceneField::SpecularCoeff: ok = read(m_in, specular); break;
+            case SceneField::TransparentCoeff: ok = read(m_in, transparent); break;
+            default: ok = unknown.skip(m_in, key); break;
+            }
+            if (!ok) return false;
+        }
+        if (m_in.failed()) {
+            return false;
+        }
+    }
+
+    if (unknown.present) return unknownField(unknown.key, "globalData");
+    if (!ambient.present) return missingField("ambientCoeff", "globalData");
+    if (!diffuse.present) return missingField("diffuseCoeff", "globalData");
+    if (!specular.present) return missingField("specularCoeff", "globalData");
+
+    SceneGlobalData &globalData = m_reader.m_globalData;
+    if (!ambient.isDouble) {
+        std::cout << "globalData ambientCoeff must be a floating-point value" << std::endl;
+        return false;
+    }
+    globalData.ka = ambient.value;
+    if (!diffuse.isDouble) {
+        std::cout << "globalData diffuseCoeff must be a floating-point value" << std::endl;
+        return false;
+    }
+    globalData.kd = diffuse.value;
+    if (!specular.isDouble) {
+        std::cout << "globalData specularCoeff must be a floating-point value" << std::endl;
+        return false;
+    }
+    globalData.ks = specular.value;
+    if (transparent.present) {
+        if (!transparent.isDouble) {
+            std::cout << "globalData transparentCoeff must be a floating-point value" << std::endl;
+            return false;
+        }
+        globalData.kt = transparent.value;
+    }
+
+    return true;
+}
+
+/**
+ * Parse cameraData and fill in m_cameraData.
+ */
+bool JsonSceneStream::parseCameraData() {
+    ArraySlot position, up, look, focus;
+    NumberSlot heightAngle, aperture, focalLength;
+    UnknownField unknown;
+
+    if (m_in.peek() != Type::Object) {
+        if (!m_in.skipValue()) {
+            return false;
+        }
+    }
+    else {
+        m_in.beginObject();
+        std::string_view key;
+        while (m_in.nextMember(key)) {
+            bool ok;
+            switch (sceneField(key)) {
+            case SceneField::Position: ok = read(m_in, position); break;
+            case SceneField::Up: ok = read(m_in, up); break;
+            case SceneField::HeightAngle: ok = read(m_in, heightAngle); break;
+            case SceneField::Aperture: ok = read(m_in, aperture); break;
+            case SceneField::FocalLength: ok = read(m_in, focalLength); break;
+            case SceneField::Look: ok = read(m_in, look); break;
+            case SceneField::Focus: ok = read(m_in, focus); break;
+            default: ok = unknown.skip(m_in, key); break;
+            }
+            if (!ok) return false;
+        }
+        if (m_in.failed()) {
+            return false;
+        }
+    }
+
+    if (unknown.present) return unknownField(unknown.key, "cameraData");
+    if (!position.present) return missingField("position", "cameraData");
+    if (!up.present) return missingField("up", "cameraData");
+    if (!heightAngle.present) return missingField("heightAngle", "cameraData");
+
+    // Must have either look or focus, but not both
+    if (look.present && focus.present) {
+        std::cout << "cameraData cannot contain both \"look\" and \"focus\"" << std::endl;
+        return false;
+    }
+
+    SceneCameraData &cameraData = m_reader.m_cameraData;
+    if (!parseCameraVector(position, "position", cameraData.pos, 1.f)) {
+        return false;
+    }
+    if (!parseCameraVector(up, "up", cameraData.up, 0.f)) {
+        return false;
+    }
+
+    if (!heightAngle.isDouble) {
+        std::cout << "cameraData heightAngle must be a floating-point value" << std::endl;
+        return false;
+    }
+    cameraData.heightAngle = heightAngle.value * M_PI / 180.f;
+
+    if (aperture.present) {
+        if (!aperture.isDouble) {
+            std::cout << "cameraData aperture must be a floating-point value" << std::endl;
+            return false;
+        }
+        cameraData.aperture = aperture.value;
+    }
+
+    if (focalLength.present) {
+        if (!focalLength.isDouble) {
+            std::cout << "cameraData focalLength must be a floating-point value" << std::endl;
+            return false;
+        }
+        cameraData.focalLength = focalLength.value;
+    }
+
+    // Parse the look or focus
+    // if the focus is specified, it is converted to a look vector from the camera position
+    if (look.present) {
+        if (!parseCameraVector(look, "look", cameraData.look, 0.f)) {
+            return false;
+        }
+    }
+    else if (focus.present) {
+        if (!parseCameraVector(focus, "focus", cameraData.look, 1.f)) {
+            return false;
+        }
+        cameraData.look -= cameraData.pos;
+    }
+
+    return true;
+}
+
+bool JsonSceneStream::parseTemplateGroups() {
+    if (m_in.peek() != Type::Array) {
+        if (m_in.skipValue()) {
+            std::cout << "templateGroups must be an array" << std::endl;
+        }
+        return false;
+    }
+
+    m_in.beginArray();
+    while (m_in.nextElement()) {
+        if (m_in.peek() != Type::Object) {
+            if (m_in.skipValue()) {
+                std::cout << "templateGroup items must be of type object" << std::endl;
+            }
+            return false;
+        }
+
+        if (!parseTemplateGroup()) {
+            return false;
+        }
+    }
+
+    return !m_in.failed();
+}
+
+bool JsonSceneStream::parseTemplateGroup() {
+    SceneNode *templateNode = m_reader.newNode();
+    templateNode->isTemplate = true;
+
+    StringSlot name;
+    bool isReference = false;
+    if (!parseGroupData(templateNode, true, false, name, isReference)) {
+        return false;
+    }
+
+    if (!name.isString) {
+        std::cout << "templateGroup name must be a string" << std::endl;
+    }
+    if (m_reader.m_templates.contains(name.value)) {
+        std::cout << "templateGroups cannot have the same" << std::endl;
+    }
+
+    // Registered once complete, so a template can never contain itself
+    m_reader.m_templates[name.value] = templateNode;
+    return true;
+}
+
+bool JsonSceneStream::parseGroups(SceneNode *parent) {
+    if (m_in.peek() != Type::Array) {
+        if (m_in.skipValue()) {
+            std::cout << "groups must be of type array" << std::endl;
+        }
+        return false;
+    }
+
+    m_in.beginArray();
+    while (m_in.nextElement()) {
+        if (m_in.peek() != Type::Object) {
+            if (m_in.skipValue()) {
+                std::cout << "group items must be of type object" << std::endl;
+            }
+            return false;
+        }
+
+        // Template references leave the node unused in the arena
+        SceneNode *node = m_reader.newNode();
+        parent->children.push_back(node);
+        size_t index = parent->children.size() - 1;
+
+        StringSlot name;
+        bool isReference = false;
+        bool topLevel = parent == m_reader.m_root && !m_reader.m_isChunk;
+        if (!parseGroupData(node, false, topLevel, name, isReference)) {
+            return false;
+        }
+
+        // if its a reference to a template group append it instead
+        if (isReference) {
+            parent->children[index] = m_reader.m_templates[name.value];
+        }
+
+        m_reader.reportProgress(m_in.offset(), m_in.size());
+    }
+
+    return !m_in.failed();
+}
+
+/**
+ * Parse a group object into node. For plain groups, a name that references a template
+ * sets isReference and the rest of the object is skipped. Only top-level groups may
+ * reference a chunk file.
+ */
+bool JsonSceneStream::parseGroupData(SceneNode *node, bool isTemplate, bool topLevel,
+                                     StringSlot &name, bool &isReference) {
+    const SceneObjectSchema &schema = isTemplate ? kTemplateGroupSchema
+                                      : topLevel ? kTopLevelGroupSchema : kGroupSchema;
+
+    // The Qt reader looks at a group's name and fields before anything inside it, and
+    // skips a template reference whole, so the keys are read once before the members.
+    // Children are skipped over in this pass, which makes nested groups cost a pass per
+    // level above them.
+    JsonCursor::Mark start = m_in.mark();
+    UnknownField unknown;
+    m_in.beginObject();
+    std::string_view key;
+    while (m_in.nextMember(key)) {
+        SceneField field = sceneField(key);
+        bool ok = field == SceneField::Name ? read(m_in, name)
+                  : schema.allows(field)    ? m_in.skipValue()
+                                            : unknown.skip(m_in, key);
+        if (!ok) return false;
+    }
+    if (m_in.failed()) {
+        return false;
+    }
+
+    if (!isTemplate && name.present) {
+        if (!name.isString) {
+            std::cout << "group name must be of type string" << std::endl;
+            return false;
+        }
+        if (m_reader.m_templates.contains(name.value)) {
+            isReference = true;
+            return true;
+        }
+    }
+    if (unknown.present) {
+        return unknownField(unknown.key, schema.name.data());
+    }
+    if (isTemplate && !name.present) {
+        return missingField("name", "templateGroup");
+    }
+
+    ArraySlot translate, rotate, scale;
+    MatrixSlot matrix, bounds;
+    StringSlot chunkFile;
+
+    m_in.rewind(start);
+    m_in.beginObject();
+    while (m_in.nextMember(key)) {
+        bool ok = true;
+        SceneField field = sceneField(key);
+        if (field == SceneField::Name) ok = m_in.skipValue();
+        else if (field == SceneField::Translate) ok = read(m_in, translate);
+        else if (field == SceneField::Rotate) ok = read(m_in, rotate);
+        else if (field == SceneField::Scale) ok = read(m_in, scale);
+        else if (field == SceneField::Matrix) ok = read(m_in, matrix);
+        else if (field == SceneField::Lights) {
+            if (m_in.peek() != Type::Array) {
+                if (m_in.skipValue()) {
+                    std::cout << "group lights must be of type array" << std::endl;
+                }
+                return false;
+            }
+            m_in.beginArray();
+            while (m_in.nextElement()) {
+                if (m_in.peek() != Type::Object) {
+                    if (m_in.skipValue()) {
+                        std::cout << "light must be of type object" << std::endl;
+                    }
+                    return false;
+                }
+                if (!parseLightData(node)) {
+                    return false;
+                }
+            }
+        }
+        else if (field == SceneField::Primitives) {
+            if (m_in.peek() != Type::Array) {
+                if (m_in.skipValue()) {
+                    std::cout << "group primitives must be of type array" << std::endl;
+                }
+                return false;
+            }
+            m_in.beginArray();
+            while (m_in.nextElement()) {
+                if (m_in.peek() != Type::Object) {
+                    if (m_in.skipValue()) {
+                        std::cout << "primitive must be of type object" << std::endl;
+                    }
+                    return false;
+                }
+                if (!parsePrimitive(node)) {
+                    return false;
+                }
+            }
+        }
+        else if (field == SceneField::Groups) ok = parseGroups(node);
+        else if (field == SceneField::ChunkFile && topLevel) ok = read(m_in, chunkFile);
+        else if (field == SceneField::Bounds && topLevel) ok = read(m_in, bounds);
+        else ok = m_in.skipValue();
+
+        if (!ok || m_in.failed()) return false;
+    }
+    if (m_in.failed()) {
+        return false;
+    }
+
+    // Transformations are always applied in this order, whatever order the fields are in
+    if (translate.present) {
+        if (!checkTransform(translate, "translate", 3)) {
+            return false;
+        }
+        SceneTransformation *translation = m_reader.newTransformation();
+        translation->type = TransformationType::TRANSFORMATION_TRANSLATE;
+        translation->translate = glm::vec3(translate.values[0], translate.values[1], translate.values[2]);
+        node->transformations.push_back(translation);
+    }
+
+    if (rotate.present) {
+        if (!checkTransform(rotate, "rotate", 4)) {
+            return false;
+        }
+        SceneTransformation *rotation = m_reader.newTransformation();
+        rotation->type = TransformationType::TRANSFORMATION_ROTATE;
+        rotation->rotate = glm::vec3(rotate.values[0], rotate.values[1], rotate.values[2]);
+        rotation->angle = rotate.values[3] * M_PI / 180.f;
+        node->transformations.push_back(rotation);
+    }
+
+    if (scale.present) {
+        if (!checkTransform(scale, "scale", 3)) {
+            return false;
+        }
+        SceneTransformation *scaling = m_reader.newTransformation();
+        scaling->type = TransformationType::TRANSFORMATION_SCALE;
+        scaling->scale = glm::vec3(scale.values[0], scale.values[1], scale.values[2]);
+        node->transformations.push_back(scaling);
+    }
+
+    if (matrix.present) {
+        if (!matrix.isArray) {
+            std::cout << "group matrix must be of type array of array" << std::endl;
+            return false;
+        }
+        if (matrix.size != 4) {
+            std::cout << "group matrix must be 4x4" << std::endl;
+            return false;
+        }
+
+        SceneTransformation *matrixTransformation = m_reader.newTransformation();
+        matrixTransformation->type = TransformationType::TRANSFORMATION_MATRIX;
+
+        float *matrixPtr = glm::value_ptr(matrixTransformation->matrix);
+        for (int row = 0; row < 4; row++) {
+            const ArraySlot &rowSlot = matrix.rows[row];
+            if (!rowSlot.isArray) {
+                std::cout << "group matrix must be of type array of array" << std::endl;
+                return false;
+            }
+            if (rowSlot.size != 4) {
+                std::cout << "group matrix must be 4x4" << std::endl;
+                return false;
+            }
+            if (!rowSlot.allDoubles) {
+                std::cout << "group matrix must contain all floating-point values" << std::endl;
+                return false;
+            }
+
+            // fill in column-wise
+            for (int col = 0; col < 4; col++) {
+                matrixPtr[col * 4 + row] = (float)rowSlot.values[col];
+            }
+        }
+
+        node->transformations.push_back(matrixTransformation);
+    }
+
+    ScenefileReader::bakeLocalMatrix(node);
+
+    if (chunkFile.present || bounds.present) {
+        return parseChunkReference(chunkFile, bounds, node);
+    }
+    return true;
+}
+
+/**
+ * Parse the chunkFile and bounds fields of a top-level group into node->chunk.
+ */
+bool JsonSceneStream::parseChunkReference(const StringSlot &chunkFile, const MatrixSlot &bounds, SceneNode *node) {
+    if (!chunkFile.present) {
+        std::cout << "group bounds requires field \"chunkFile\"" << std::endl;
+        return false;
+    }
+    if (!chunkFile.isString) {
+        std::cout << "group chunkFile must be of type string" << std::endl;
+        return false;
+    }
+    if (!bounds.present) {
+        std::cout << "group with chunkFile must contain field \"bounds\"" << std::endl;
+        return false;
+    }
+    if (!bounds.isArray || bounds.size != 2) {
+        std::cout << "group bounds must be an array of two corners" << std::endl;
+        return false;
+    }
+
+    glm::vec3 corners[2];
+    for (int i = 0; i < 2; i++) {
+        const ArraySlot &corner = bounds.rows[i];
+        if (!corner.isArray || corner.size != 3) {
+            std::cout << "group bounds corners must have 3 elements" << std::endl;
+            return false;
+        }
+        if (!corner.allDoubles) {
+            std::cout << "group bounds must contain floating-point values" << std::endl;
+            return false;
+        }
+        corners[i] = glm::vec3(corner.values[0], corner.values[1], corner.values[2]);
+    }
+    if (glm::any(glm::greaterThan(corners[0], corners[1]))) {
+        std::cout << "group bounds minimum must not exceed its maximum" << std::endl;
+        return false;
+    }
+
+    node->chunk = m_reader.newChunk(chunkFile.value);
+    node->chunk->boundsMin = corners[0];
+    node->chunk->boundsMax = corners[1];
+    return true;
+}
+
+/**
+ * Parse a primitive object into node.
+ */
+bool JsonSceneStream::parsePrimitive(SceneNode *node) {
+    StringSlot type, meshFile, textureFile, bumpMapFile;
+    ArraySlot ambient, diffuse, specular, reflective, transparent;
+    NumberSlot shininess, ior, blend, textureU, textureV, bumpMapU, bumpMapV;
+    UnknownField unknown;
+
+    m_in.beginObject();
+    std::string_view key;
+    while (m_in.nextMember(key)) {
+        bool ok;
+        switch (sceneField(key)) {
+        case SceneField::Type: ok = read(m_in, type); break;
+        case SceneField::MeshFile: ok = read(m_in, meshFile); break;
+        case SceneField::Ambient: ok = read(m_in, ambient); break;
+        case SceneField::Diffuse: ok = read(m_in, diffuse); break;
+        case SceneField::Specular: ok = read(m_in, specular); break;
+        case SceneField::Reflective: ok = read(m_in, reflective); break;
+        case SceneField::Transparent: ok = read(m_in, transparent); break;
+        case SceneField::Shininess: ok = read(m_in, shininess); break;
+        case SceneField::Ior: ok = read(m_in, ior); break;
+        case SceneField::Blend: ok = read(m_in, blend); break;
+        case SceneField::TextureFile: ok = read(m_in, textureFile); break;
+        case SceneField::TextureU: ok = read(m_in, textureU); break;
+        case SceneField::TextureV: ok = read(m_in, textureV); break;
+        case SceneField::BumpMapFile: ok = read(m_in, bumpMapFile); break;
+        case SceneField::BumpMapU: ok = read(m_in, bumpMapU); break;
+        case SceneField::BumpMapV: ok = read(m_in, bumpMapV); break;
+        default: ok = unknown.skip(m_in, key); break;
+        }
+        if (!ok) return false;
+    }
+    if (m_in.failed()) {
+        return false;
+    }
+
+    if (unknown.present) {
+        return unknownField(unknown.key, "primitive");
+    }
+    if (!type.present) {
+        return missingField("type", "primitive");
+    }
+    if (!type.isString) {
+        std::cout << "primitive type must be of type string" << std::endl;
+        return false;
+    }
+
+    // Default primitive
+    ScenePrimitive *primitive = m_reader.newPrimitive();
+    SceneMaterial &mat = primitive->material;
+    mat.clear();
+    primitive->type = PrimitiveType::PRIMITIVE_CUBE;
+    mat.textureMap.isUsed = false;
+    mat.bumpMap.isUsed = false;
+    mat.cDiffuse.r = mat.cDiffuse.g = mat.cDiffuse.b = 1;
+    node->primitives.push_back(primitive);
+
+    std::filesystem::path basepath = std::filesystem::path(m_reader.file_name).parent_path().parent_path();
+    const std::string &primType = type.value;
+    if (!primitiveTypeFromName(primType, primitive->type)) {
+        std::cout << "unknown primitive type \"" << primType << "\"" << std::endl;
+        return false;
+    }
+    if (primitive->type == PrimitiveType::PRIMITIVE_MESH) {
+        if (!meshFile.present) {
+            std::cout << "primitive type mesh must contain field meshFile" << std::endl;
+            return false;
+        }
+        if (!meshFile.isString) {
+            std::cout << "primitive meshFile must be of type string" << std::endl;
+            return false;
+        }
+
+        primitive->meshfile = (basepath / std::filesystem::path(meshFile.value)).string();
+    }
+
+    if (ambient.present && !parseColor(ambient, "ambient", mat.cAmbient)) return false;
+    if (diffuse.present && !parseColor(diffuse, "diffuse", mat.cDiffuse)) return false;
+    if (specular.present && !parseColor(specular, "specular", mat.cSpecular)) return false;
+    if (reflective.present && !parseColor(reflective, "reflective", mat.cReflective)) return false;
+    if (transparent.present && !parseColor(transparent, "transparent", mat.cTransparent)) return false;
+
+    if (shininess.present) {
+        if (!shininess.isDouble) {
+            std::cout << "primitive shininess must be of type float" << std::endl;
+            return false;
+        }
+        mat.shininess = (float)shininess.value;
+    }
+
+    if (ior.present) {
+        if (!ior.isDouble) {
+            std::cout << "primitive ior must be of type float" << std::endl;
+            return false;
+        }
+        mat.ior = (float)ior.value;
+    }
+
+    if (blend.present) {
+        if (!blend.isDouble) {
+            std::cout << "primitive blend must be of type float" << std::endl;
+            return false;
+        }
+        mat.blend = (float)blend.value;
+    }
+
+    if (textureFile.present) {
+        if (!textureFile.isString) {
+            std::cout << "primitive textureFile must be of type string" << std::endl;
+            return false;
+        }
+        mat.textureMap.filename = (basepath / std::filesystem::path(textureFile.value)).string();
+        mat.textureMap.repeatU = textureU.isDouble ? textureU.value : 1;
+        mat.textureMap.repeatV = textureV.isDouble ? textureV.value : 1;
+        mat.textureMap.isUsed = true;
+    }
+
+    if (bumpMapFile.present) {
+        if (!bumpMapFile.isString) {
+            std::cout << "primitive bumpMapFile must be of type string" << std::endl;
+            return false;
+        }
+        mat.bumpMap.filename = (basepath / std::filesystem::path(bumpMapFile.value)).string();
+        mat.bumpMap.repeatU = bumpMapU.isDouble ? bumpMapU.value : 1;
+        mat.bumpMap.repeatV = bumpMapV.isDouble ? bumpMapV.value : 1;
+        mat.bumpMap.isUsed = true;
+    }
+
+    return true;
+}
+
+/**
+ * Parse a light object and add a new SceneLight to node.
+ */
+bool JsonSceneStream::parseLightData(SceneNode *node) {
+    StringSlot type;
+    ArraySlot color, attenuation, direction;
+    NumberSlot penumbra, angle;
+    UnknownField unknown;
+
+    m_in.beginObject();
+    std::string_view key;
+    while (m_in.nextMember(key)) {
+        bool ok;
+        switch (sceneField(key)) {
+        case SceneField::Type: ok = read(m_in, type); break;
+        case SceneField::Color: ok = read(m_in, color); break;
+        case SceneField::AttenuationCoeff: ok = read(m_in, attenuation); break;
+        case SceneField::Direction: ok = read(m_in, direction); break;
+        case SceneField::Penumbra: ok = read(m_in, penumbra); break;
+        case SceneField::Angle: ok = read(m_in, angle); break;
+        case SceneField::Name: ok = m_in.skipValue(); break;
+        default: ok = unknown.skip(m_in, key); break;
+        }
+        if (!ok) return false;
+    }
+    if (m_in.failed()) {
+        return false;
+    }
+
+    if (unknown.present) return unknownField(unknown.key, "light");
+    if (!type.present) return missingField("type", "light");
+    if (!color.present) return missingField("color", "light");
+
+    // Create a default light
+    SceneLight *light = m_reader.newLight();
+    memset(light, 0, sizeof(SceneLight));
+    node->lights.push_back(light);
+
+    light->dir = glm::vec4(0.f, 0.f, 0.f, 0.f);
+    light->function = glm::vec3(1, 0, 0);
+
+    // parse the color
+    if (!color.isArray) {
+        std::cout << "light color must be of type array" << std::endl;
+        return false;
+    }
+    if (color.size != 3) {
+        std::cout << "light color must be of size 3" << std::endl;
+        return false;
+    }
+    if (!color.allDoubles) {
+        std::cout << "light color must contain floating-point values" << std::endl;
+        return false;
+    }
+    light->color.r = color.values[0];
+    light->color.g = color.values[1];
+    light->color.b = color.values[2];
+
+    // parse the type
+    if (!type.isString) {
+        std::cout << "light type must be of type string" << std::endl;
+        return false;
+    }
+    const std::string &lightType = type.value;
+    if (!lightTypeFromName(lightType, light->type)) {
+        std::cout << "unknown light type \"" << lightType << "\"" << std::endl;
+        return false;
+    }
+
+    if (light->type == LightType::LIGHT_DIRECTIONAL) {
+
+        if (!direction.present) {
+            std::cout << "directional light must contain field \"direction\"" << std::endl;
+            return false;
+        }
+        if (!direction.isArray) {
+            std::cout << "directional light direction must be of type array" << std::endl;
+            return false;
+        }
+        if (direction.size != 3) {
+            std::cout << "directional light direction must be of size 3" << std::endl;
+            return false;
+        }
+        if (!direction.allDoubles) {
+            std::cout << "directional light direction must contain floating-point values" << std::endl;
+            return false;
+        }
+        light->dir.x = direction.values[0];
+        light->dir.y = direction.values[1];
+        light->dir.z = direction.values[2];
+    }
+    else if (light->type == LightType::LIGHT_POINT) {
+
+        if (!attenuation.present) {
+            std::cout << "point light must contain field \"attenuationCoeff\"" << std::endl;
+            return false;
+        }
+        if (!attenuation.isArray) {
+            std::cout << "point light attenuationCoeff must be of type array" << std::endl;
+            return false;
+        }
+        if (attenuation.size != 3) {
+            std::cout << "point light attenuationCoeff must be of size 3" << std::endl;
+            return false;
+        }
+        if (!attenuation.allDoubles) {
+            std::cout << "ppoint light attenuationCoeff must contain floating-point values" << std::endl;
+            return false;
+        }
+        light->function = glm::vec3(attenuation.values[0], attenuation.values[1], attenuation.values[2]);
+    }
+    else {
+        if (!direction.present) return missingField("direction", "spotlight");
+        if (!penumbra.present) return missingField("penumbra", "spotlight");
+        if (!angle.present) return missingField("angle", "spotlight");
+        if (!attenuation.present) return missingField("attenuationCoeff", "spotlight");
+
+        if (!direction.isArray) {
+            std::cout << "spotlight direction must be of type array" << std::endl;
+            return false;
+        }
+        if (direction.size != 3) {
+            std::cout << "spotlight direction must be of size 3" << std::endl;
+            return false;
+        }
+        if (!direction.allDoubles) {
+            std::cout << "spotlight direction must contain floating-point values" << std::endl;
+            return false;
+        }
+        light->dir.x = direction.values[0];
+        light->dir.y = direction.values[1];
+        light->dir.z = direction.values[2];
+
+        if (!attenuation.isArray) {
+            std::cout << "spotlight attenuationCoeff must be of type array" << std::endl;
+            return false;
+        }
+        if (attenuation.size != 3) {
+            std::cout << "spotlight attenuationCoeff must be of size 3" << std::endl;
+            return false;
+        }
+        if (!attenuation.allDoubles) {
+            std::cout << "spotlight direction must contain floating-point values" << std::endl;
+            return false;
+        }
+        light->function = glm::vec3(attenuation.values[0], attenuation.values[1], attenuation.values[2]);
+
+        if (!penumbra.isDouble) {
+            std::cout << "spotlight penumbra must be of type float" << std::endl;
+            return false;
+        }
+        light->penumbra = penumbra.value * M_PI / 180.f;
+
+        if (!angle.isDouble) {
+            std::cout << "spotlight angle must be of type float" << std::endl;
+            return false;
+        }
+        light->angle = angle.value * M_PI / 180.f;
+    }
+
+    return true;
+}
+
+bool ScenefileReader::readJSONStreaming() {
+    MappedFile file(file_name);
+    if (!file.isOpen()) {
+        std::cout << "could not open " << file_name << std::endl;
+        return false;
+    }
+
+    JsonCursor in(file.chars(), file.chars() + file.size());
+    JsonSceneStream stream(*this, in);
+    if (!stream.parseScene()) {
+        if (in.failed()) {
+            std::cout << "could not parse " << file_name << std::endl;
+            std::cout << "parse error at line " << in.errorOffset() << ": " << in.error() << std::endl;
+        }
+        return false;
+    }
+
+    reportProgress(1, 1);
+    std::cout << "Finished reading " << file_name << std::endl;
+    return true;
+}
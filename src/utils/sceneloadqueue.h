@@ -0,0 +1,48 @@
+#pragma once
+
+#include <optional>
+
+// Decides which scene load runs next. Only one load runs at a time; loads requested while
+// it runs collapse into one queued load of the newest file.
+//
+// A hot reload patches the resident scene, so a queued load may only be one if everything
+// it stands in for was one too. A hot reload queued behind a full load would otherwise
+// throw the full load away and patch the old scene with the new file.
+class SceneLoadQueue {
+public:
+    // @return  true if the load should start now, false if it was queued behind the
+    //          running one
+    bool start(bool hotReload) {
+        if (m_running) {
+            m_queuedHotReload = hotReload && m_runningHotReload && (!m_queued || m_queuedHotReload);
+            m_queued = true;
+            return false;
+        }
+        m_running = true;
+        m_runningHotReload = hotReload;
+        return true;
+    }
+
+    // The running load finished.
+    // @return  whether the queued load is a hot reload, or nothing if none was queued.
+    //          A queued load supersedes the finished one, and should be started with start()
+    std::optional<bool> finish() {
+        m_running = false;
+        if (!m_queued) {
+            return std::nullopt;
+        }
+        m_queued = false;
+        return m_queuedHotReload;
+    }
+
+    bool running() const { return m_running; }
+
+    // Whether the running load patches the resident scene instead of replacing it
+    bool isHotReload() const { return m_runningHotReload; }
+
+private:
+    bool m_running = false;
+    bool m_runningHotReload = false;
+    bool m_queued = false;                  // the scene file changed again mid-load
+    bool m_queuedHotReload = false;
+};
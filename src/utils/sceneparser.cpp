@@ -1,61 +1,410 @@
 #include "sceneparser.h"
 #include "scenefilereader.h"
-#include <glm/gtx/transform.hpp>
+#include "scenecache.h"
+#include "settings.h"
+#include "profiling.h"
+#include "hash.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
 
-void nodeTraversal(SceneNode* node, RenderData &renderData, glm::mat4 ctm) {
+namespace {
 
-    if (node == NULL) {
-        return;
+// Key of the group at child slot index under the group with key parent. Shapes are keyed
+// by the path of the group they were declared in plus their position within it, so a
+// shape keeps its key across edits that do not restructure the groups above it.
+uint64_t childKey(uint64_t parent, uint64_t index) {
+    return hashCombine(parent, index);
+}
+
+const uint64_t kRootKey = fnv1a64("root");
+const uint64_t kTemplateKey = fnv1a64("template");
+
+// Primitives that hot reloads have left unreferenced are kept, so that the indices of
+// the rest stay valid, until there are more than this many
+const size_t kMaxStalePrimitives = 64;
+
+// Flattened output, either of a template relative to its own root or of a segment.
+struct FlatSubtree {
+    std::vector<RenderShapeData> shapes;
+    std::vector<uint64_t> shapeKeys;
+    std::vector<SceneLightData> lights;
+};
+
+// A contiguous piece of the flattened scene. Concatenating the output of all segments in
+// order gives exactly the output of one depth-first traversal from the root.
+struct Segment {
+    enum class Kind {
+        Subtree,  // node and everything below it, with ctm being the parent's ctm
+        Children, // optionally the node's own primitives and lights, then children
+                  // [begin, end) with ctm being the node's own ctm
+    };
+
+    Kind kind;
+    SceneNode *node;
+    glm::mat4 ctm;
+    uint64_t key;
+    bool own = false;
+    size_t begin = 0;
+    size_t end = 0;
+
+    // Output. Primitive indices in shapes are local to the worker that flattened it.
+    int worker = -1;
+    FlatSubtree out;
+};
+
+// Flattens segments of the scene graph on one thread. Each ScenePrimitive gets a
+// worker-local index the first time it is seen, and template subtrees are flattened
+// only once per worker and then stamped out with the ctm of every reference, so the
+// work done per reference is one matrix multiply per shape and light.
+class FlattenWorker {
+public:
+    void flatten(Segment &segment) {
+        if (segment.kind == Segment::Kind::Subtree) {
+            traverse(segment.node, segment.ctm, segment.key, segment.out);
+            return;
+        }
+
+        if (segment.own) {
+            emitOwn(segment.node, segment.ctm, segment.key, segment.out);
+        }
+        for (size_t i = segment.begin; i < segment.end; i++) {
+            traverse(segment.node->children[i], segment.ctm, childKey(segment.key, i), segment.out);
+        }
     }
 
-    glm::mat4 culCTM = glm::mat4(1.0f);
+    const std::vector<const ScenePrimitive *> &primitives() const { return m_primitives; }
 
-    for (SceneTransformation* transform : node->transformations) {
-        switch (transform->type) {
-        case TransformationType::TRANSFORMATION_TRANSLATE:
-            culCTM *= glm::translate(glm::mat4(1.0f), transform->translate);
-            break;
-        case TransformationType::TRANSFORMATION_ROTATE:
-            culCTM *= glm::rotate(glm::mat4(1.0f), transform->angle, transform->rotate);
-            break;
-        case TransformationType::TRANSFORMATION_SCALE:
-            culCTM *= glm::scale(glm::mat4(1.0f), transform->scale);
-            break;
-        case TransformationType::TRANSFORMATION_MATRIX:
-            culCTM *= transform->matrix;
+private:
+    uint32_t primitiveIndex(const ScenePrimitive *prim) {
+        auto [it, inserted] = m_primitiveIndices.emplace(prim, m_primitives.size());
+        if (inserted) {
+            m_primitives.push_back(prim);
+        }
+        return it->second;
+    }
+
+    const FlatSubtree &flattenTemplate(SceneNode *node) {
+        auto it = m_templates.find(node);
+        if (it != m_templates.end()) {
+            return it->second;
+        }
+
+        FlatSubtree flat;
+        traverseNode(node, glm::mat4(1.0f), kTemplateKey, flat);
+        return m_templates.emplace(node, std::move(flat)).first->second;
+    }
+
+    void traverse(SceneNode *node, const glm::mat4 &ctm, uint64_t key, FlatSubtree &out) {
+        if (node == NULL) {
+            return;
+        }
+
+        if (!node->isTemplate) {
+            traverseNode(node, ctm, key, out);
+            return;
+        }
+
+        const FlatSubtree &flat = flattenTemplate(node);
+        for (size_t i = 0; i < flat.shapes.size(); i++) {
+            const RenderShapeData &shape = flat.shapes[i];
+            out.shapes.push_back({shape.primitive, shape.material, ctm * shape.ctm});
+            out.shapeKeys.push_back(hashCombine(key, flat.shapeKeys[i]));
+        }
+        for (SceneLightData light : flat.lights) {
+            light.pos = ctm * light.pos;
+            light.dir = ctm * light.dir;
+            out.lights.push_back(light);
+        }
+    }
+
+    void traverseNode(SceneNode *node, glm::mat4 ctm, uint64_t key, FlatSubtree &out) {
+        // The reader already folded the node's transformations into localMatrix
+        if (!node->isIdentity) {
+            ctm *= node->localMatrix;
+        }
+
+        emitOwn(node, ctm, key, out);
+
+        for (size_t i = 0; i < node->children.size(); i++) {
+            traverse(node->children[i], ctm, childKey(key, i), out);
+        }
+    }
+
+    void emitOwn(SceneNode *node, const glm::mat4 &ctm, uint64_t key, FlatSubtree &out) {
+        for (size_t i = 0; i < node->primitives.size(); i++) {
+            out.shapes.push_back({primitiveIndex(node->primitives[i]), 0, ctm});
+            out.shapeKeys.push_back(hashCombine(key, i));
+        }
+
+        for (SceneLight *light : node->lights) {
+            glm::vec4 lightPos = {0, 0, 0, 1};
+            SceneLightData lighting = {light->id, light->type, light->color, light->function, ctm * lightPos, ctm * light->dir, light->penumbra, light->angle, light->width, light->height};
+            out.lights.push_back(lighting);
+        }
+    }
+
+    std::vector<const ScenePrimitive *> m_primitives;
+    std::unordered_map<const ScenePrimitive *, uint32_t> m_primitiveIndices;
+    std::unordered_map<const SceneNode *, FlatSubtree> m_templates;
+};
+
+// Cuts the graph into roughly target segments by repeatedly opening up Subtree segments,
+// a few levels deep at most. Templates are never opened, so each stays a cached unit.
+std::vector<Segment> splitIntoSegments(SceneNode *root, size_t target) {
+    const int maxDepth = 8;
+
+    std::vector<Segment> segments;
+    segments.push_back({Segment::Kind::Subtree, root, glm::mat4(1.0f), kRootKey});
+
+    for (int depth = 0; depth < maxDepth && segments.size() < target; depth++) {
+        std::vector<Segment> next;
+        bool split = false;
+
+        for (Segment &segment : segments) {
+            SceneNode *node = segment.node;
+            if (segment.kind != Segment::Kind::Subtree || node == NULL || node->isTemplate || node->children.empty()) {
+                next.push_back(std::move(segment));
+                continue;
+            }
+            split = true;
+
+            glm::mat4 ctm = segment.ctm;
+            if (!node->isIdentity) {
+                ctm *= node->localMatrix;
+            }
+
+            if (!node->primitives.empty() || !node->lights.empty()) {
+                next.push_back({Segment::Kind::Children, node, ctm, segment.key, true, 0, 0});
+            }
+
+            // Single children become Subtree segments so the next round can open them up
+            size_t count = node->children.size();
+            size_t ranges = std::min(count, target);
+            for (size_t r = 0; r < ranges; r++) {
+                size_t begin = count * r / ranges;
+                size_t end = count * (r + 1) / ranges;
+                if (end - begin == 1) {
+                    next.push_back({Segment::Kind::Subtree, node->children[begin], ctm, childKey(segment.key, begin)});
+                }
+                else {
+                    next.push_back({Segment::Kind::Children, node, ctm, segment.key, false, begin, end});
+                }
+            }
+        }
+
+        segments.swap(next);
+        if (!split) {
             break;
         }
     }
 
-    ctm *= culCTM;
+    return segments;
+}
+
+// Flattens the scene graph into renderData, on several threads if parallel is set.
+// The output is identical either way: segments are concatenated in scene order, and
+// primitives are numbered by their first appearance in that order.
+void flattenScene(SceneNode *root, RenderData &renderData, bool parallel) {
+    size_t threadCount = parallel ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+
+    std::vector<Segment> segments;
+    if (threadCount > 1) {
+        segments = splitIntoSegments(root, threadCount * 4);
+    }
+    else {
+        segments.push_back({Segment::Kind::Subtree, root, glm::mat4(1.0f), kRootKey});
+    }
+    threadCount = std::min(threadCount, segments.size());
+
+    std::vector<FlattenWorker> workers(threadCount);
+    std::atomic<size_t> nextSegment = 0;
+    auto work = [&](int worker) {
+        for (size_t i = nextSegment++; i < segments.size(); i = nextSegment++) {
+            segments[i].worker = worker;
+            workers[worker].flatten(segments[i]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(work, i);
+    }
+    work(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // Merge, renumbering worker-local primitive indices into renderData.primitives
+    size_t shapeCount = 0, lightCount = 0;
+    for (const Segment &segment : segments) {
+        shapeCount += segment.out.shapes.size();
+        lightCount += segment.out.lights.size();
+    }
+    renderData.shapes.reserve(shapeCount);
+    renderData.shapeKeys.reserve(shapeCount);
+    renderData.lights.reserve(lightCount);
 
-    for (ScenePrimitive* prim : node->primitives) {
-        RenderShapeData primitive = {*prim, ctm};
-        renderData.shapes.push_back(primitive);
+    std::unordered_map<const ScenePrimitive *, uint32_t> primitiveIndices;
+    std::vector<std::vector<uint32_t>> remap(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        remap[i].assign(workers[i].primitives().size(), UINT32_MAX);
     }
 
-    for (SceneLight* light : node->lights) {
-        glm::vec4 lightPos = {0, 0, 0, 1};
-        SceneLightData lighting = {light->id, light->type, light->color, light->function, ctm * lightPos, ctm * light->dir, light->penumbra, light->angle, light->width, light->height};
-        renderData.lights.push_back(lighting);
+    for (Segment &segment : segments) {
+        std::vector<uint32_t> &workerRemap = remap[segment.worker];
+        const std::vector<const ScenePrimitive *> &workerPrimitives = workers[segment.worker].primitives();
+
+        for (RenderShapeData &shape : segment.out.shapes) {
+            uint32_t &index = workerRemap[shape.primitive];
+            if (index == UINT32_MAX) {
+                const ScenePrimitive *prim = workerPrimitives[shape.primitive];
+                auto [it, inserted] = primitiveIndices.emplace(prim, renderData.primitives.size());
+                if (inserted) {
+                    renderData.primitives.push_back(*prim);
+                }
+                index = it->second;
+            }
+            shape.primitive = index;
+        }
+
+        renderData.shapes.insert(renderData.shapes.end(), segment.out.shapes.begin(), segment.out.shapes.end());
+        renderData.shapeKeys.insert(renderData.shapeKeys.end(), segment.out.shapeKeys.begin(), segment.out.shapeKeys.end());
+        renderData.lights.insert(renderData.lights.end(), segment.out.lights.begin(), segment.out.lights.end());
+        segment.out = FlatSubtree();
     }
+}
+
+// Rebuilds renderData.materials from its primitives, in order of first use.
+// @return  the material index of each primitive
+std::vector<uint32_t> internMaterials(RenderData &renderData) {
+    renderData.materials.clear();
 
-    for (SceneNode* child : node->children) {
-        nodeTraversal(child, renderData, ctm);
+    std::unordered_map<std::string, uint32_t> materialIndices;
+    std::vector<uint32_t> primitiveMaterials(renderData.primitives.size());
+    for (size_t i = 0; i < renderData.primitives.size(); i++) {
+        const SceneMaterial &mat = renderData.primitives[i].material;
+        auto [it, inserted] = materialIndices.emplace(SceneParser::materialKey(mat), renderData.materials.size());
+        if (inserted) {
+            renderData.materials.push_back(mat);
+        }
+        primitiveMaterials[i] = it->second;
     }
+    return primitiveMaterials;
+}
 
+// Drops the primitives that are not referenced, and the materials only they used, and
+// points the shapes at the new indices of the rest.
+// @return  the shapes whose primitive or material index changed, in order
+std::vector<uint32_t> compactPrimitives(RenderData &renderData, const std::vector<bool> &referenced) {
+    std::vector<uint32_t> remap(renderData.primitives.size());
+    uint32_t kept = 0;
+    for (size_t i = 0; i < renderData.primitives.size(); i++) {
+        if (!referenced[i]) {
+            continue;
+        }
+        if (kept != i) {
+            renderData.primitives[kept] = std::move(renderData.primitives[i]);
+        }
+        remap[i] = kept++;
+    }
+    renderData.primitives.resize(kept);
+
+    std::vector<uint32_t> primitiveMaterials = internMaterials(renderData);
+    std::vector<uint32_t> moved;
+    for (size_t i = 0; i < renderData.shapes.size(); i++) {
+        RenderShapeData &shape = renderData.shapes[i];
+        uint32_t primitive = remap[shape.primitive];
+        uint32_t material = primitiveMaterials[primitive];
+        if (primitive != shape.primitive || material != shape.material) {
+            shape.primitive = primitive;
+            shape.material = material;
+            moved.push_back(i);
+        }
+    }
+    return moved;
 }
 
-bool SceneParser::parse(std::string filepath, RenderData &renderData) {
-    ScenefileReader fileReader = ScenefileReader(filepath);
+std::string primitiveKey(const ScenePrimitive &prim) {
+    std::string key = SceneParser::materialKey(prim.material);
+    key.append(reinterpret_cast<const char *>(&prim.type), sizeof(prim.type));
+    key += prim.meshfile;
+    return key;
+}
 
-    bool success = fileReader.readJSON();
+bool sameLight(const SceneLightData &a, const SceneLightData &b) {
+    return a.id == b.id && a.type == b.type && a.color == b.color && a.function == b.function
+           && a.pos == b.pos && a.dir == b.dir && a.penumbra == b.penumbra && a.angle == b.angle
+           && a.width == b.width && a.height == b.height;
+}
+
+bool sameCamera(const SceneCameraData &a, const SceneCameraData &b) {
+    return a.pos == b.pos && a.look == b.look && a.up == b.up && a.heightAngle == b.heightAngle
+           && a.aperture == b.aperture && a.focalLength == b.focalLength;
+}
+
+bool sameGlobal(const SceneGlobalData &a, const SceneGlobalData &b) {
+    return a.ka == b.ka && a.kd == b.kd && a.ks == b.ks && a.kt == b.kt;
+}
+
+bool sameChunk(const RenderChunk &a, const RenderChunk &b) {
+    return a.filename == b.filename && a.ctm == b.ctm && a.boundsMin == b.boundsMin && a.boundsMax == b.boundsMax;
+}
+
+// Chunks can only be referenced from top-level groups, so only the root's children are checked
+void collectChunks(SceneNode *root, RenderData &renderData) {
+    renderData.chunks.clear();
+    for (SceneNode *node : root->children) {
+        if (node->chunk == nullptr) {
+            continue;
+        }
+
+        RenderChunk chunk;
+        chunk.filename = node->chunk->filename;
+        chunk.ctm = root->localMatrix * node->localMatrix;
+
+        // World-space box around the eight transformed corners
+        chunk.boundsMin = glm::vec3(INFINITY);
+        chunk.boundsMax = glm::vec3(-INFINITY);
+        for (int i = 0; i < 8; i++) {
+            glm::vec3 corner = glm::vec3(i & 1 ? node->chunk->boundsMax.x : node->chunk->boundsMin.x,
+                                         i & 2 ? node->chunk->boundsMax.y : node->chunk->boundsMin.y,
+                                         i & 4 ? node->chunk->boundsMax.z : node->chunk->boundsMin.z);
+            glm::vec3 world = glm::vec3(chunk.ctm * glm::vec4(corner, 1.f));
+            chunk.boundsMin = glm::min(chunk.boundsMin, world);
+            chunk.boundsMax = glm::max(chunk.boundsMax, world);
+        }
+        renderData.chunks.push_back(chunk);
+    }
+}
+
+// Reads filepath with the reader chosen in options and flattens it into renderData.
+// Progress is reported up to 0.9; the rest is left to the caller.
+bool readAndFlatten(const std::string &filepath, bool isChunk, const SceneParseOptions &options,
+                    RenderData &renderData, std::atomic<float> *progress) {
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t startRSS = currentRSSKilobytes();
+    ScenefileReader fileReader = ScenefileReader(filepath, isChunk);
+    fileReader.setProgress(progress, 0.f, 0.7f);
+
+    bool success = options.streamingReader ? fileReader.readJSONStreaming() : fileReader.readJSON();
     if (!success) {
         return false;
     }
+    auto readTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime);
+    // The peak RSS of the process would repeat the first load's high-water mark, so this
+    // reports what the parsed scene graph still holds. Peaks are measured by scenebench.
+    int64_t graphKilobytes = int64_t(currentRSSKilobytes()) - int64_t(startRSS);
+    std::cout << (options.streamingReader ? "Streaming" : "Qt") << " reader took "
+              << readTime.count() << " ms, RSS " << (graphKilobytes >= 0 ? "+" : "") << graphKilobytes / 1024
+              << " MB" << std::endl;
 
     // Task 5: populate renderData with global data, and camera data;
     renderData.cameraData = fileReader.getCameraData();
@@ -66,12 +415,213 @@ bool SceneParser::parse(std::string filepath, RenderData &renderData) {
     //         create a helper function to do so!
 
     auto rootNode = fileReader.getRootNode();
+    renderData.primitives.clear();
     renderData.shapes.clear();
+    renderData.shapeKeys.clear();
     renderData.lights.clear();
 
-    nodeTraversal(rootNode, renderData, glm::mat4(1.0f));
+    auto flattenStart = std::chrono::steady_clock::now();
+    flattenScene(rootNode, renderData, options.parallelFlattening);
+    collectChunks(rootNode, renderData);
+    auto flattenTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - flattenStart);
+    std::cout << "Flattened " << renderData.shapes.size() << " shapes in " << flattenTime.count() << " ms" << std::endl;
+    if (progress != nullptr) {
+        progress->store(0.9f, std::memory_order_relaxed);
+    }
+    SceneParser::buildMaterialTable(renderData);
 
     return true;
+}
+
+}
+
+std::string SceneParser::materialKey(const SceneMaterial &mat) {
+    std::string key;
+    auto append = [&key](const void *data, size_t size) {
+        key.append(static_cast<const char *>(data), size);
+    };
+    auto appendFileMap = [&](const SceneFileMap &map) {
+        append(&map.isUsed, sizeof(map.isUsed));
+        append(&map.repeatU, sizeof(map.repeatU));
+        append(&map.repeatV, sizeof(map.repeatV));
+        key += map.filename;
+        key += '\0';
+    };
+
+    append(&mat.cAmbient, sizeof(SceneColor));
+    append(&mat.cDiffuse, sizeof(SceneColor));
+    append(&mat.cSpecular, sizeof(SceneColor));
+    append(&mat.cReflective, sizeof(SceneColor));
+    append(&mat.cTransparent, sizeof(SceneColor));
+    append(&mat.cEmissive, sizeof(SceneColor));
+    append(&mat.shininess, sizeof(float));
+    append(&mat.ior, sizeof(float));
+    append(&mat.blend, sizeof(float));
+    appendFileMap(mat.textureMap);
+    appendFileMap(mat.bumpMap);
+    return key;
+}
+
+SceneParseOptions SceneParseOptions::fromSettings() {
+    SceneParseOptions options;
+    options.useSceneCache = settings.useSceneCache;
+    options.streamingReader = settings.streamingSceneReader;
+    options.parallelFlattening = settings.parallelFlattening;
+    return options;
+}
 
+void SceneParser::buildMaterialTable(RenderData &renderData) {
+    std::vector<uint32_t> primitiveMaterials = internMaterials(renderData);
+    for (RenderShapeData &shape : renderData.shapes) {
+        shape.material = primitiveMaterials[shape.primitive];
+    }
 }
 
+ScenePatch SceneParser::patch(RenderData &resident, RenderData &updated) {
+    ScenePatch result;
+
+    // Move updated's primitives into resident's table, appending the ones it lacks.
+    // Primitives with equal contents are compared by their first index in the table.
+    std::unordered_map<std::string, uint32_t> primitiveIndices;
+    std::vector<uint32_t> canonical(resident.primitives.size());
+    for (size_t i = 0; i < resident.primitives.size(); i++) {
+        canonical[i] = primitiveIndices.emplace(primitiveKey(resident.primitives[i]), i).first->second;
+    }
+    std::vector<uint32_t> remap(updated.primitives.size());
+    for (size_t i = 0; i < updated.primitives.size(); i++) {
+        auto [it, inserted] = primitiveIndices.emplace(primitiveKey(updated.primitives[i]), resident.primitives.size());
+        if (inserted) {
+            resident.primitives.push_back(std::move(updated.primitives[i]));
+        }
+        remap[i] = it->second;
+    }
+
+    // Material indices of existing primitives survive, since the table is only appended to
+    // until it is compacted below
+    std::vector<uint32_t> primitiveMaterials = internMaterials(resident);
+    for (RenderShapeData &shape : updated.shapes) {
+        shape.primitive = remap[shape.primitive];
+        shape.material = primitiveMaterials[shape.primitive];
+    }
+
+    if (resident.shapeKeys == updated.shapeKeys) {
+        for (size_t i = 0; i < updated.shapes.size(); i++) {
+            RenderShapeData &shape = resident.shapes[i];
+            const RenderShapeData &update = updated.shapes[i];
+            if (canonical[shape.primitive] != update.primitive || shape.ctm != update.ctm) {
+                shape = update;
+                result.dirtyShapes.push_back(i);
+            }
+        }
+    }
+    else {
+        result.restructured = true;
+
+        std::unordered_map<uint64_t, uint32_t> residentIndices;
+        residentIndices.reserve(resident.shapeKeys.size());
+        for (size_t i = 0; i < resident.shapeKeys.size(); i++) {
+            residentIndices.emplace(resident.shapeKeys[i], i);
+        }
+
+        // Everything moves when the structure changes, so all shapes count as dirty
+        size_t kept = 0;
+        for (size_t i = 0; i < updated.shapes.size(); i++) {
+            auto it = residentIndices.find(updated.shapeKeys[i]);
+            if (it == residentIndices.end()) {
+                result.addedShapes++;
+            }
+            else {
+                kept++;
+            }
+            result.dirtyShapes.push_back(i);
+        }
+        result.removedShapes = resident.shapes.size() - kept;
+
+        resident.shapes = std::move(updated.shapes);
+        resident.shapeKeys = std::move(updated.shapeKeys);
+    }
+
+    // Compact the table once it holds enough dead entries, or whenever every shape is
+    // dirty anyway. Shapes that are not already dirty become dirty if their indices move.
+    std::vector<bool> referenced(resident.primitives.size(), false);
+    for (const RenderShapeData &shape : resident.shapes) {
+        referenced[shape.primitive] = true;
+    }
+    size_t stale = std::count(referenced.begin(), referenced.end(), false);
+    if (stale > 0 && (result.restructured || stale > kMaxStalePrimitives)) {
+        std::vector<uint32_t> moved = compactPrimitives(resident, referenced);
+        if (!result.restructured && !moved.empty()) {
+            std::vector<uint32_t> dirty;
+            dirty.reserve(result.dirtyShapes.size() + moved.size());
+            std::set_union(result.dirtyShapes.begin(), result.dirtyShapes.end(), moved.begin(), moved.end(),
+                           std::back_inserter(dirty));
+            result.dirtyShapes = std::move(dirty);
+        }
+        std::cout << "Compacted " << stale << " unused primitives" << std::endl;
+    }
+
+    result.lightsChanged = resident.lights.size() != updated.lights.size()
+                           || !std::equal(resident.lights.begin(), resident.lights.end(), updated.lights.begin(), sameLight);
+    if (result.lightsChanged) {
+        resident.lights = std::move(updated.lights);
+    }
+
+    result.cameraChanged = !sameCamera(resident.cameraData, updated.cameraData);
+    resident.cameraData = updated.cameraData;
+
+    result.globalChanged = !sameGlobal(resident.globalData, updated.globalData);
+    resident.globalData = updated.globalData;
+
+    result.chunksChanged = resident.chunks.size() != updated.chunks.size()
+                           || !std::equal(resident.chunks.begin(), resident.chunks.end(), updated.chunks.begin(), sameChunk);
+    if (result.chunksChanged) {
+        resident.chunks = std::move(updated.chunks);
+    }
+
+    return result;
+}
+
+bool SceneParser::parse(std::string filepath, RenderData &renderData, const SceneParseOptions &options,
+                        std::atomic<float> *progress) {
+    auto setProgress = [progress](float value) {
+        if (progress != nullptr) {
+            progress->store(value, std::memory_order_relaxed);
+        }
+    };
+    setProgress(0.f);
+
+    // Reuse the compiled scene if the JSON has not changed since it was written
+    if (options.useSceneCache && SceneCache::load(filepath, renderData)) {
+        buildMaterialTable(renderData);
+        setProgress(1.f);
+        return true;
+    }
+
+    if (!readAndFlatten(filepath, false, options, renderData, progress)) {
+        return false;
+    }
+
+    if (options.useSceneCache) {
+        SceneCache::store(filepath, renderData);
+    }
+    setProgress(1.f);
+
+    return true;
+
+}
+
+bool SceneParser::parseChunk(const std::string &filepath, RenderData &renderData, const SceneParseOptions &options) {
+    if (options.useSceneCache && SceneCache::load(filepath, renderData)) {
+        buildMaterialTable(renderData);
+        return true;
+    }
+
+    if (!readAndFlatten(filepath, true, options, renderData, nullptr)) {
+        return false;
+    }
+
+    if (options.useSceneCache) {
+        SceneCache::store(filepath, renderData);
+    }
+    return true;
+}
@@ -1,13 +1,27 @@
 #pragma once
 
 #include "scenedata.h"
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <string>
 
-// Struct which contains data for a single primitive, to be used for rendering
+// Struct which contains data for a single instance of a primitive, to be used for rendering.
+// Instances of the same scene primitive (e.g. from a template group used many times)
+// all point at one shared entry in RenderData::primitives.
 struct RenderShapeData {
-    ScenePrimitive primitive;
-    glm::mat4 ctm; // the cumulative transformation matrix
+    uint32_t primitive; // index into RenderData::primitives
+    uint32_t material;  // index into RenderData::materials
+    glm::mat4 ctm;      // the cumulative transformation matrix
+};
+
+// A chunk file referenced by a top-level group (see SceneChunk), streamed in separately
+// from the rest of the scene.
+struct RenderChunk {
+    std::string filename;
+    glm::mat4 ctm;       // places the chunk's contents in the world
+    glm::vec3 boundsMin; // world-space bounding box of the chunk
+    glm::vec3 boundsMax;
 };
 
 // Struct which contains all the data needed to render a scene
@@ -16,7 +30,38 @@ struct RenderData {
     SceneCameraData cameraData;
 
     std::vector<SceneLightData> lights;
-    std::vector<RenderShapeData> shapes;
+    std::vector<ScenePrimitive> primitives; // unique primitives, each stored once
+    std::vector<SceneMaterial> materials;   // unique materials, shared between primitives
+    std::vector<RenderShapeData> shapes;    // one per instance
+    std::vector<uint64_t> shapeKeys;        // per shape, stable across edits (see SceneParser::patch)
+    std::vector<RenderChunk> chunks;        // not part of shapes until streamed in (see ChunkStreamer)
+
+    const ScenePrimitive &primitiveOf(const RenderShapeData &shape) const {
+        return primitives[shape.primitive];
+    }
+};
+
+// What SceneParser::patch changed in the resident scene.
+struct ScenePatch {
+    bool restructured = false;           // groups were added, removed or reordered
+    std::vector<uint32_t> dirtyShapes;   // indices into shapes whose data changed
+    size_t addedShapes = 0;
+    size_t removedShapes = 0;
+    bool lightsChanged = false;
+    bool cameraChanged = false;
+    bool globalChanged = false;
+    bool chunksChanged = false;          // chunk references were added, removed or moved
+};
+
+// The settings a parse depends on. Parses run off the GUI thread while the settings can
+// still change, so they are copied when the parse is started.
+struct SceneParseOptions {
+    bool useSceneCache = true;
+    bool streamingReader = false;
+    bool parallelFlattening = true;
+
+    // Must be called on the GUI thread, which owns settings
+    static SceneParseOptions fromSettings();
 };
 
 class SceneParser {
@@ -24,6 +69,34 @@ public:
     // Parse the scene and store the results in renderData.
     // @param filepath    The path of the scene file to load.
     // @param renderData  On return, this will contain the metadata of the loaded scene.
+    // @param options     How to read the file.
+    // @param progress    If set, updated from 0 to 1 as loading proceeds. Safe to read
+    //                    from another thread.
     // @return            A boolean value indicating whether the parse was successful.
-    static bool parse(std::string filepath, RenderData &renderData);
+    static bool parse(std::string filepath, RenderData &renderData, const SceneParseOptions &options,
+                      std::atomic<float> *progress = nullptr);
+
+    // Parse a chunk file into renderData, in the space of the chunk itself; its ctm is
+    // applied when it is composed into the scene. Global and camera data are left unset.
+    // @return  A boolean value indicating whether the parse was successful.
+    static bool parseChunk(const std::string &filepath, RenderData &renderData, const SceneParseOptions &options);
+
+    // Byte string that is equal for two materials exactly when all their fields are, for
+    // interning them.
+    static std::string materialKey(const SceneMaterial &material);
+
+    // Deduplicate the materials of renderData.primitives into renderData.materials and
+    // point the material index of every shape at its entry.
+    static void buildMaterialTable(RenderData &renderData);
+
+    // Bring the resident scene up to date with a freshly parsed version of the same file,
+    // touching only what differs. Shapes are matched by the path of the group they come
+    // from (child indices from the root, so inserting a group also moves the paths of
+    // the siblings after it). If the group structure is unchanged, shapes are updated in
+    // place and their indices stay valid; otherwise the shape list is replaced. Primitives are
+    // appended, so existing primitive and material indices keep their meaning, until
+    // enough are unreferenced that the table is compacted; shapes whose indices that
+    // moves are reported dirty. A restructure always compacts.
+    // updated is left in an unspecified state.
+    static ScenePatch patch(RenderData &resident, RenderData &updated);
 };
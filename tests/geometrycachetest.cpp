@@ -0,0 +1,134 @@
+// GeometryCache eviction test.
+//
+// Fills a cache with a small budget with large tessellations, then moves to small ones so
+// the large ones are evicted, and checks that compact() shrinks the shape buffers to fit
+// what is still resident, that the shapes still hold their vertices afterwards, and that
+// an arena left empty deletes its buffers.
+//
+// Needs an OpenGL 4.1 context; exits with 77 (skipped) if none can be created.
+
+#include "shapes/geometrycache.h"
+#include "shapes/sphere.h"
+#include "shapes/vertexcache.h"
+
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QSurfaceFormat>
+
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+const int kSkipped = 77;
+
+int failures = 0;
+
+void check(bool condition, const char *what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+// Requests every level of every primitive, as Realtime::initializeShapeGeometry() does
+void requestShapes(GeometryCache &cache, int param1, int param2, VertexFormat format) {
+    for (int lod = 0; lod < GeometryCache::kLodLevels; lod++) {
+        cache.get(PrimitiveType::PRIMITIVE_SPHERE, param1, param2, lod, format);
+        cache.get(PrimitiveType::PRIMITIVE_CUBE, param1, param2, lod, format);
+        cache.get(PrimitiveType::PRIMITIVE_CYLINDER, param1, param2, lod, format);
+        cache.get(PrimitiveType::PRIMITIVE_CONE, param1, param2, lod, format);
+    }
+}
+
+// Reads back the first vertex of a float shape
+glm::vec3 firstPosition(const ShapeGeometry &geometry) {
+    GLint vbo = 0;
+    glBindVertexArray(geometry.vao);
+    glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vbo);
+    glBindVertexArray(0);
+
+    glm::vec3 position;
+    glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, size_t(geometry.baseVertex) * 6 * sizeof(GLfloat),
+                       sizeof(position), &position);
+    return position;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+#if defined(__linux__)
+    // Without a display, ask Qt for a context without a window system
+    if (!qEnvironmentVariableIsSet("DISPLAY") && !qEnvironmentVariableIsSet("WAYLAND_DISPLAY")
+        && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+#endif
+    QGuiApplication app(argc, argv);
+
+    QSurfaceFormat format;
+    format.setVersion(4, 1);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+
+    QOpenGLContext context;
+    context.setFormat(format);
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        std::cerr << "No OpenGL 4.1 context; skipped" << std::endl;
+        return kSkipped;
+    }
+
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        std::cerr << "Could not initialize GLEW; skipped" << std::endl;
+        return kSkipped;
+    }
+
+    {
+        // No budget, so only the most recently requested shapes stay resident
+        GeometryCache cache(0);
+
+        requestShapes(cache, 100, 100, VertexFormat::Float);
+        requestShapes(cache, 100, 100, VertexFormat::Packed);
+        size_t peakBytes = cache.arenaBytes();
+
+        // Two small chains, so the large ones are no longer among the most recent
+        requestShapes(cache, 8, 8, VertexFormat::Float);
+        requestShapes(cache, 6, 6, VertexFormat::Float);
+        check(cache.residentBytes() < peakBytes / 8, "the large tessellations are evicted");
+        check(cache.arenaBytes() == peakBytes, "eviction alone keeps the buffers");
+
+        check(cache.compact(), "sparse arenas are compacted");
+        check(!cache.compact(), "compacted arenas are not compacted again");
+        check(cache.arenaBytes() < peakBytes / 4, "compaction shrinks the buffers");
+        check(cache.arenaBytes() >= cache.residentBytes(), "the buffers still hold every resident shape");
+
+        // The packed arena lost all of its shapes, and was deleted
+        const ShapeGeometry &packed = cache.get(PrimitiveType::PRIMITIVE_SPHERE, 6, 6, 0, VertexFormat::Packed);
+        check(packed.baseVertex == 0 && packed.firstIndex == 0, "an emptied arena starts over");
+
+        // The shapes that stayed resident were moved with their contents
+        const ShapeGeometry &sphere = cache.get(PrimitiveType::PRIMITIVE_SPHERE, 6, 6, 0, VertexFormat::Float);
+        ShapeMesh mesh = Sphere::generateSphereData(6, 6);
+        optimizeMesh(mesh);
+        glm::vec3 expected(mesh.vertices[0], mesh.vertices[1], mesh.vertices[2]);
+        check(glm::all(glm::equal(firstPosition(sphere), expected)), "moved shapes keep their vertices");
+
+        cache.clear();
+        check(cache.arenaBytes() == 0, "clear() deletes the buffers");
+        check(glGetError() == GL_NO_ERROR, "no GL errors");
+    }
+
+    context.doneCurrent();
+
+    if (failures > 0) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "geometrycachetest passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+// SceneLoadQueue ordering test.
+//
+// Requests loads while others run, in the orders the file watcher and the scene picker
+// produce them, and checks that a queued load is only a hot reload when nothing it
+// stands in for was a full load.
+
+#include "utils/sceneloadqueue.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+}
+
+int main() {
+    {
+        SceneLoadQueue queue;
+        check(queue.start(false), "a load starts when none runs");
+        check(!queue.isHotReload(), "a full load is not a hot reload");
+        check(!queue.finish().has_value(), "nothing is queued behind a lone load");
+        check(!queue.running(), "a finished load no longer runs");
+    }
+    {
+        // The file watcher fires while a scene switch is loading
+        SceneLoadQueue queue;
+        queue.start(false);
+        check(!queue.start(true), "a hot reload waits for the running full load");
+        std::optional<bool> next = queue.finish();
+        check(next.has_value() && !*next, "a hot reload queued behind a full load becomes a full load");
+        check(queue.start(*next) && !queue.isHotReload(), "the queued full load starts");
+    }
+    {
+        // The file changes twice while it is being hot reloaded
+        SceneLoadQueue queue;
+        queue.start(true);
+        queue.start(true);
+        queue.start(true);
+        std::optional<bool> next = queue.finish();
+        check(next.has_value() && *next, "hot reloads queued behind a hot reload stay hot reloads");
+    }
+    {
+        // A scene switch and then a file change, both while a hot reload runs
+        SceneLoadQueue queue;
+        queue.start(true);
+        queue.start(false);
+        queue.start(true);
+        std::optional<bool> next = queue.finish();
+        check(next.has_value() && !*next, "a later hot reload does not downgrade a queued full load");
+    }
+
+    if (failures > 0) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "sceneloadqueuetest passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+// Scene reader agreement test: scenereadertest <directory of tests/scenes>
+//
+// Reads each scene with both the Qt reader and the streaming reader. Valid scenes must
+// give the same scene graph, and invalid ones the same messages. Malformed JSON only has
+// to be rejected by both, as the readers word syntax errors differently.
+
+#include "utils/scenefilereader.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const std::string &what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+enum class Expect { Valid, Invalid, Malformed };
+
+struct Case {
+    const char *file;
+    Expect expect;
+};
+
+const Case kCases[] = {
+    {"valid.json", Expect::Valid},
+    {"reference_name_last.json", Expect::Valid},
+    {"reference_before_templates.json", Expect::Valid},
+    {"unknown_before_missing_primitive.json", Expect::Invalid},
+    {"unknown_before_missing_light.json", Expect::Invalid},
+    {"unknown_before_missing_globaldata.json", Expect::Invalid},
+    {"unknown_before_missing_template.json", Expect::Invalid},
+    {"missing_before_unknown_root.json", Expect::Invalid},
+    {"group_unknown_before_members.json", Expect::Invalid},
+    {"malformed_leading_zero.json", Expect::Malformed},
+    {"malformed_minus.json", Expect::Malformed},
+    {"malformed_fraction.json", Expect::Malformed},
+    {"malformed_control_character.json", Expect::Malformed},
+    {"malformed_control_character_escaped.json", Expect::Malformed},
+};
+
+void dumpVec(std::ostream &out, const float *values, int count) {
+    for (int i = 0; i < count; i++) {
+        out << ' ' << values[i];
+    }
+}
+
+// Template nodes are shared, so each node is written once and referred to by number after
+void dumpNode(std::ostream &out, const SceneNode *node, std::map<const SceneNode *, int> &seen, int depth) {
+    std::string indent(depth * 2, ' ');
+    auto [it, inserted] = seen.emplace(node, int(seen.size()));
+    out << indent << "node " << it->second;
+    if (!inserted) {
+        out << " (again)\n";
+        return;
+    }
+    out << (node->isTemplate ? " template" : "") << " matrix";
+    dumpVec(out, &node->localMatrix[0][0], 16);
+    out << '\n';
+    if (node->chunk != nullptr) {
+        out << indent << " chunk " << node->chunk->filename << '\n';
+    }
+    for (const ScenePrimitive *primitive : node->primitives) {
+        out << indent << " primitive " << int(primitive->type) << ' ' << primitive->meshfile << " diffuse";
+        dumpVec(out, &primitive->material.cDiffuse[0], 4);
+        out << '\n';
+    }
+    for (const SceneLight *light : node->lights) {
+        out << indent << " light " << int(light->type) << " color";
+        dumpVec(out, &light->color[0], 4);
+        out << " dir";
+        dumpVec(out, &light->dir[0], 4);
+        out << '\n';
+    }
+    for (const SceneNode *child : node->children) {
+        dumpNode(out, child, seen, depth + 1);
+    }
+}
+
+struct Result {
+    bool ok;
+    std::string output; // everything the reader printed
+    std::string graph;
+};
+
+Result read(const std::string &path, bool streaming) {
+    std::ostringstream output;
+    std::streambuf *console = std::cout.rdbuf(output.rdbuf());
+    ScenefileReader reader(path);
+    bool ok = streaming ? reader.readJSONStreaming() : reader.readJSON();
+    std::cout.rdbuf(console);
+
+    std::ostringstream graph;
+    if (ok) {
+        SceneGlobalData global = reader.getGlobalData();
+        SceneCameraData camera = reader.getCameraData();
+        graph << "global " << global.ka << ' ' << global.kd << ' ' << global.ks << ' ' << global.kt << '\n';
+        graph << "camera";
+        dumpVec(graph, &camera.pos[0], 4);
+        dumpVec(graph, &camera.look[0], 4);
+        dumpVec(graph, &camera.up[0], 4);
+        graph << ' ' << camera.heightAngle << '\n';
+        std::map<const SceneNode *, int> seen;
+        dumpNode(graph, reader.getRootNode(), seen, 0);
+    }
+    return {ok, output.str(), graph.str()};
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: scenereadertest <scene directory>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    for (const Case &test : kCases) {
+        std::string path = std::string(argv[1]) + "/" + test.file;
+        Result qt = read(path, false);
+        Result streaming = read(path, true);
+
+        std::string name = test.file;
+        check(qt.ok == (test.expect == Expect::Valid), name + ": Qt reader result");
+        check(streaming.ok == qt.ok, name + ": streaming reader result");
+        if (test.expect == Expect::Valid) {
+            check(streaming.graph == qt.graph, name + ": scene graphs differ\n" + qt.graph + "--- streaming:\n" + streaming.graph);
+        }
+        if (test.expect == Expect::Invalid) {
+            check(streaming.output == qt.output, name + ": messages differ\n" + qt.output + "--- streaming:\n" + streaming.output);
+        }
+    }
+
+    if (failures > 0) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "scenereadertest passed" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+// Scene reader throughput benchmark.
+//
+// Usage: scenebench <scene.json> [iterations] [qt|streaming]
+//
+// Parses the scene repeatedly with both readers and reports scene objects (groups,
+// primitives and lights) parsed per second, then times the per-key field validation on
+// its own: the table lookup the readers use against the QStringList scans it replaced.
+//
+// Given a reader, only that one runs and the peak RSS of the process is reported. Peak
+// RSS never goes down, so compare readers (or builds) with one process per run.
+
+#include "utils/scenefilereader.h"
+#include "utils/scenefields.h"
+#include "utils/profiling.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+#include <QStringList>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Templates are counted once, however often they are referenced
+size_t countObjects(SceneNode *node, std::unordered_set<SceneNode *> &visited) {
+    if (node == nullptr || !visited.insert(node).second) {
+        return 0;
+    }
+    size_t count = 1 + node->primitives.size() + node->lights.size();
+    for (SceneNode *child : node->children) {
+        count += countObjects(child, visited);
+    }
+    return count;
+}
+
+bool benchReader(const std::string &path, int iterations, bool streaming) {
+    size_t objects = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        ScenefileReader reader(path);
+        if (!(streaming ? reader.readJSONStreaming() : reader.readJSON())) {
+            return false;
+        }
+        std::unordered_set<SceneNode *> visited;
+        objects += countObjects(reader.getRootNode(), visited);
+    }
+    double seconds = secondsSince(start);
+
+    std::cout << (streaming ? "streaming reader: " : "Qt reader:        ")
+              << objects / iterations << " objects, " << seconds * 1000 / iterations << " ms per parse, "
+              << objects / seconds << " objects/s" << std::endl;
+    return true;
+}
+
+void benchFieldLookup() {
+    const int rounds = 200000;
+    size_t found = 0;
+
+    // Every primitive key, as in a fully specified primitive object
+    std::vector<std::string_view> keys;
+    QStringList qtKeys;
+    for (size_t i = size_t(SceneField::Type); i <= size_t(SceneField::BumpMapV); i++) {
+        keys.push_back(kSceneFieldNames[i]);
+        qtKeys.append(QString::fromStdString(std::string(kSceneFieldNames[i])));
+    }
+
+    auto start = Clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (std::string_view key : keys) {
+            found += kPrimitiveSchema.allows(sceneField(key));
+        }
+    }
+    double tableSeconds = secondsSince(start);
+
+    start = Clock::now();
+    for (int round = 0; round < rounds; round++) {
+        // What parsePrimitive used to build and scan for every primitive
+        QStringList requiredFields = {"type"};
+        QStringList optionalFields = {
+            "meshFile", "ambient", "diffuse", "specular", "reflective", "transparent", "shininess", "ior",
+            "blend", "textureFile", "textureU", "textureV", "bumpMapFile", "bumpMapU", "bumpMapV"};
+        QStringList allFields = requiredFields + optionalFields;
+        for (const QString &key : qtKeys) {
+            found += allFields.contains(key);
+        }
+    }
+    double listSeconds = secondsSince(start);
+
+    std::cout << "primitive field validation, " << keys.size() << " keys: table "
+              << rounds / tableSeconds << " objects/s, QStringList " << rounds / listSeconds
+              << " objects/s (" << found << " hits)" << std::endl;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string reader = argc > 3 ? argv[3] : "";
+    if (argc < 2 || (argc > 3 && reader != "qt" && reader != "streaming")) {
+        std::cerr << "usage: scenebench <scene.json> [iterations] [qt|streaming]" << std::endl;
+        return 1;
+    }
+    std::string path = argv[1];
+    int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    if (!reader.empty()) {
+        if (!benchReader(path, iterations, reader == "streaming")) {
+            std::cerr << "could not read " << path << std::endl;
+            return 1;
+        }
+        std::cout << "peak RSS: " << peakRSSKilobytes() / 1024 << " MB" << std::endl;
+        return 0;
+    }
+
+    if (!benchReader(path, iterations, false) || !benchReader(path, iterations, true)) {
+        std::cerr << "could not read " << path << std::endl;
+        return 1;
+    }
+    benchFieldLookup();
+    return 0;
+}
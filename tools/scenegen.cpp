@@ -0,0 +1,466 @@
+// Procedural stress-scene generator.
+//
+// Usage: scenegen <output.json> [--primitives N] [--lights N] [--depth N] [--flat] [--chunks K] [--seed N]
+//
+// Writes a city of houses, towers and trees in the regular scene-file schema with
+// exactly N primitives (default 10000). The city is built from nested template groups:
+// "block" holds 16 primitives and each "district<i>" is a 2x2 grid of the level below,
+// up to --depth levels (default 3, 1024 primitives). The scene references the deepest
+// template as often as fits, and the remainder is made of individual buildings.
+// --flat writes every primitive explicitly instead, which stresses the readers with
+// unique objects rather than the flattener with template instances.
+//
+// --chunks K splits the city into a KxK grid of chunk files next to the output, named
+// <output>_<x>_<z>.json, which the scene references from top-level groups with their
+// bounds. Each chunk file carries its own copy of the templates.
+//
+// The first light is directional and the rest are point lights spread over the city;
+// the phong shader only uses the first 8. The same arguments always produce the same
+// file, on every platform.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// splitmix64, so output does not depend on the standard library's distributions
+class Random {
+public:
+    explicit Random(uint64_t seed) : m_state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (m_state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [min, max), rounded to what the writer prints
+    double uniform(double min, double max) {
+        double t = (next() >> 11) * (1.0 / 9007199254740992.0);
+        return std::round((min + t * (max - min)) * 1000.0) / 1000.0;
+    }
+
+    int below(int n) { return static_cast<int>(next() % n); }
+
+private:
+    uint64_t m_state;
+};
+
+struct Options {
+    std::string output;
+    uint64_t primitives = 10000;
+    int lights = 8;
+    int depth = 3;
+    bool flat = false;
+    int chunks = 0;
+    uint64_t seed = 1230;
+};
+
+// Small JSON writer for the scene schema. Numbers are printed with a fixed precision so
+// output is byte-for-byte reproducible.
+class SceneWriter {
+public:
+    explicit SceneWriter(std::ostream &out) : m_out(out) {}
+
+    void raw(const char *text) { m_out << text; }
+
+    void number(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+        // Trim trailing zeros to keep big scenes small
+        char *end = buffer + std::strlen(buffer) - 1;
+        while (*end == '0') *end-- = '\0';
+        if (*end == '.') *end = '\0';
+        m_out << (std::strcmp(buffer, "-0") == 0 ? "0" : buffer);
+    }
+
+    void vec3(const char *key, double x, double y, double z) {
+        m_out << '"' << key << "\": [";
+        number(x); m_out << ", ";
+        number(y); m_out << ", ";
+        number(z); m_out << ']';
+    }
+
+    void primitive(const char *type, double tx, double ty, double tz, double sx, double sy, double sz,
+                   const double diffuse[3]) {
+        m_out << "{";
+        vec3("translate", tx, ty, tz);
+        m_out << ", ";
+        vec3("scale", sx, sy, sz);
+        m_out << ", \"primitives\": [{\"type\": \"" << type << "\", ";
+        vec3("diffuse", diffuse[0], diffuse[1], diffuse[2]);
+        m_out << ", ";
+        vec3("specular", 0.3, 0.3, 0.3);
+        m_out << ", \"shininess\": 15}]}";
+    }
+
+    // A group holding one reference to the template called name
+    void reference(const char *name, double tx, double tz, int quarterTurns) {
+        m_out << "{";
+        vec3("translate", tx, 0, tz);
+        if (quarterTurns != 0) {
+            m_out << ", \"rotate\": [0, 1, 0, " << quarterTurns * 90 << ']';
+        }
+        m_out << ", \"groups\": [{\"name\": \"" << name << "\"}]}";
+    }
+
+private:
+    std::ostream &m_out;
+};
+
+const double kWall[3] = {0.8, 0.75, 0.7};
+const double kRoof[3] = {0.6, 0.2, 0.15};
+const double kGlass[3] = {0.4, 0.55, 0.7};
+const double kTrunk[3] = {0.4, 0.25, 0.1};
+const double kLeaves[3] = {0.2, 0.6, 0.2};
+
+// Each building kind is two primitives, with its footprint centered on the origin
+enum class Building { House, Tower, Tree };
+
+void writeBuilding(SceneWriter &out, Building kind, double x, double z, double height, const double color[3]) {
+    switch (kind) {
+    case Building::House:
+        out.primitive("cube", x, height / 2, z, 0.8, height, 0.8, color);
+        out.raw(", ");
+        out.primitive("cone", x, height + 0.25, z, 1.0, 0.5, 1.0, kRoof);
+        break;
+    case Building::Tower:
+        out.primitive("cylinder", x, height / 2, z, 0.7, height, 0.7, color);
+        out.raw(", ");
+        out.primitive("cone", x, height + 0.4, z, 0.7, 0.8, 0.7, kRoof);
+        break;
+    case Building::Tree:
+        out.primitive("cylinder", x, 0.3, z, 0.15, 0.6, 0.15, kTrunk);
+        out.raw(", ");
+        out.primitive("cone", x, 0.6 + height / 2, z, 0.6, height, 0.6, kLeaves);
+        break;
+    }
+}
+
+const uint64_t kBlockPrimitives = 16;
+const double kBlockSize = 4.0;
+const double kStreet = 1.0;
+
+// Footprint of the template at level: 0 is "block", i is "district<i>"
+double templateSize(int level) {
+    double size = kBlockSize;
+    for (int i = 0; i < level; i++) {
+        size = 2 * size + kStreet;
+    }
+    return size;
+}
+
+uint64_t templatePrimitives(int level) {
+    return kBlockPrimitives << (2 * level);
+}
+
+std::string templateName(int level) {
+    return level == 0 ? "block" : "district" + std::to_string(level);
+}
+
+void writeTemplates(SceneWriter &out, int depth) {
+    out.raw("  \"templateGroups\": [\n");
+
+    // A block is 8 buildings on a 4x2 grid
+    const Building pattern[8] = {
+        Building::House, Building::Tower, Building::House, Building::Tree,
+        Building::Tree, Building::House, Building::Tower, Building::House,
+    };
+    const double heights[8] = {1.0, 3.0, 1.5, 1.0, 1.2, 1.0, 4.0, 1.2};
+    out.raw("    {\"name\": \"block\", \"groups\": [");
+    for (int i = 0; i < 8; i++) {
+        if (i > 0) out.raw(", ");
+        writeBuilding(out, pattern[i], -1.5 + (i % 4), i < 4 ? -1.0 : 1.0, heights[i],
+                      pattern[i] == Building::Tower ? kGlass : kWall);
+    }
+    out.raw("]}");
+
+    for (int level = 1; level <= depth; level++) {
+        std::string child = templateName(level - 1);
+        double offset = (templateSize(level - 1) + kStreet) / 2;
+
+        out.raw(",\n    {\"name\": \"");
+        out.raw(templateName(level).c_str());
+        out.raw("\", \"groups\": [");
+        for (int i = 0; i < 4; i++) {
+            if (i > 0) out.raw(", ");
+            out.reference(child.c_str(), i % 2 ? offset : -offset, i < 2 ? -offset : offset, i);
+        }
+        out.raw("]}");
+    }
+
+    out.raw("\n  ],\n");
+}
+
+// Lays count cells of the given size out on a square grid centered on the origin
+struct Grid {
+    Grid(uint64_t count, double cellSize) : cellSize(cellSize) {
+        columns = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::sqrt(double(count)))));
+        origin = -(double(columns) - 1) * cellSize / 2;
+    }
+
+    double x(uint64_t i) const { return origin + (i % columns) * cellSize; }
+    double z(uint64_t i) const { return origin + (i / columns) * cellSize; }
+    double extent() const { return columns * cellSize; }
+
+    uint64_t columns;
+    double cellSize;
+    double origin;
+};
+
+// A "groups" array being written, one group at a time
+class GroupList {
+public:
+    explicit GroupList(std::ostream &out, bool empty = true) : m_writer(out), m_empty(empty) {}
+
+    // Writer positioned for the next group
+    SceneWriter &next() {
+        m_writer.raw(m_empty ? "    " : ",\n    ");
+        m_empty = false;
+        return m_writer;
+    }
+
+    bool empty() const { return m_empty; }
+
+private:
+    SceneWriter m_writer;
+    bool m_empty;
+};
+
+// Buildings are at most this tall, roofs included
+const double kMaxHeight = 5.0;
+
+// One file of a chunked city, covering a square cell of the grid
+struct ChunkFile {
+    std::string name;
+    std::ofstream file;
+    std::unique_ptr<GroupList> groups;
+    double minX, minZ, maxX, maxZ; // bounds of what was written to it
+};
+
+bool writeScene(const Options &options) {
+    Random random(options.seed);
+
+    // References to the deepest template first, then loose buildings for the rest
+    uint64_t topPrimitives = templatePrimitives(options.depth);
+    uint64_t references = options.flat ? 0 : options.primitives / topPrimitives;
+    uint64_t loose = options.primitives - references * topPrimitives;
+
+    Grid districts(references, templateSize(options.depth) + kStreet);
+    Grid buildings((loose + 1) / 2, 2.0);
+    double extent = std::max(districts.extent(), buildings.extent());
+
+    // Offset the loose buildings so they do not overlap the districts
+    double looseOffset = references > 0 ? districts.extent() / 2 + buildings.extent() / 2 + kStreet : 0;
+
+    // Lights stay in the scene file, even when the city is chunked
+    std::ostringstream lights;
+    GroupList lightGroups(lights);
+    for (int i = 0; i < options.lights; i++) {
+        SceneWriter &out = lightGroups.next();
+        if (i == 0) {
+            out.raw("{\"lights\": [{\"type\": \"directional\", \"color\": [0.8, 0.8, 0.8], ");
+            out.vec3("direction", -0.3, -1, -0.2);
+            out.raw("}]}");
+            continue;
+        }
+        Grid grid(options.lights - 1, extent / std::ceil(std::sqrt(double(options.lights - 1))));
+        out.raw("{");
+        out.vec3("translate", grid.x(i - 1), 8, grid.z(i - 1));
+        out.raw(", \"lights\": [{\"type\": \"point\", ");
+        out.vec3("color", random.uniform(0.5, 1), random.uniform(0.5, 1), random.uniform(0.5, 1));
+        out.raw(", \"attenuationCoeff\": [1, 0.05, 0]}]}");
+    }
+
+    std::ofstream file(options.output, std::ios::binary);
+    if (!file) {
+        std::cerr << "could not open " << options.output << std::endl;
+        return false;
+    }
+    SceneWriter out(file);
+
+    out.raw("{\n  \"globalData\": {\"ambientCoeff\": 0.5, \"diffuseCoeff\": 0.5, \"specularCoeff\": 0.5},\n");
+    out.raw("  \"cameraData\": {");
+    out.vec3("position", 0, extent * 0.4 + 5, extent * 0.6 + 10);
+    out.raw(", ");
+    out.vec3("look", 0, -0.5, -1);
+    out.raw(", ");
+    out.vec3("up", 0, 1, 0);
+    out.raw(", \"heightAngle\": 45},\n");
+
+    // The chunk grid covers the centers of everything in the city
+    double cityMinX = references > 0 ? districts.x(0) : buildings.x(0) + looseOffset;
+    double cityMinZ = std::min(references > 0 ? districts.z(0) : INFINITY, loose > 0 ? buildings.z(0) : INFINITY);
+    double citySize = std::max({
+        references > 0 ? districts.x(districts.columns - 1) - cityMinX : 0,
+        loose > 0 ? buildings.x(buildings.columns - 1) + looseOffset - cityMinX : 0,
+        references > 0 ? districts.z(references - 1) - cityMinZ : 0,
+        loose > 0 ? buildings.z((loose - 1) / 2) - cityMinZ : 0,
+    }) + 1e-6;
+
+    std::vector<ChunkFile> chunks(options.chunks * options.chunks);
+    std::string stem = options.output.substr(0, options.output.rfind(".json"));
+    for (int i = 0; i < int(chunks.size()); i++) {
+        ChunkFile &chunk = chunks[i];
+        chunk.name = stem + "_" + std::to_string(i % options.chunks) + "_" + std::to_string(i / options.chunks) + ".json";
+        chunk.file.open(chunk.name, std::ios::binary);
+        if (!chunk.file) {
+            std::cerr << "could not open " << chunk.name << std::endl;
+            return false;
+        }
+        chunk.minX = chunk.minZ = INFINITY;
+        chunk.maxX = chunk.maxZ = -INFINITY;
+
+        SceneWriter header(chunk.file);
+        header.raw("{\n");
+        if (!options.flat) {
+            writeTemplates(header, options.depth);
+        }
+        header.raw("  \"groups\": [\n");
+        chunk.groups = std::make_unique<GroupList>(chunk.file);
+    }
+
+    // The scene's groups are the lights, then either the city or references to its chunks
+    GroupList groups(file, lightGroups.empty());
+    if (chunks.empty()) {
+        if (!options.flat) {
+            writeTemplates(out, options.depth);
+        }
+        out.raw("  \"groups\": [\n");
+        out.raw(lights.str().c_str());
+    }
+
+    // Picks the file for something centered at x, z that reaches halfSize around it
+    auto groupsAt = [&](double x, double z, double halfSize) -> SceneWriter & {
+        if (chunks.empty()) {
+            return groups.next();
+        }
+        int cellX = std::min(options.chunks - 1, int((x - cityMinX) / citySize * options.chunks));
+        int cellZ = std::min(options.chunks - 1, int((z - cityMinZ) / citySize * options.chunks));
+        ChunkFile &chunk = chunks[cellZ * options.chunks + cellX];
+        chunk.minX = std::min(chunk.minX, x - halfSize);
+        chunk.maxX = std::max(chunk.maxX, x + halfSize);
+        chunk.minZ = std::min(chunk.minZ, z - halfSize);
+        chunk.maxZ = std::max(chunk.maxZ, z + halfSize);
+        return chunk.groups->next();
+    };
+
+    // Rotated districts fit in a circle around their center
+    double districtHalfSize = templateSize(options.depth) * 0.75;
+    for (uint64_t i = 0; i < references; i++) {
+        int quarterTurns = random.below(4);
+        groupsAt(districts.x(i), districts.z(i), districtHalfSize)
+            .reference(templateName(options.depth).c_str(), districts.x(i), districts.z(i), quarterTurns);
+    }
+
+    for (uint64_t i = 0; i < loose; i += 2) {
+        double x = buildings.x(i / 2) + looseOffset;
+        double z = buildings.z(i / 2);
+        double color[3] = {random.uniform(0.3, 1), random.uniform(0.3, 1), random.uniform(0.3, 1)};
+        SceneWriter &building = groupsAt(x, z, 1.0);
+
+        if (i + 1 == loose) {
+            // Odd count: a single cube finishes it off
+            building.primitive("cube", x, 0.5, z, 0.8, 1, 0.8, color);
+            continue;
+        }
+        Building kind = static_cast<Building>(random.below(3));
+        building.raw("{\"groups\": [");
+        writeBuilding(building, kind, x, z, random.uniform(1, 4), color);
+        building.raw("]}");
+    }
+
+    if (!chunks.empty()) {
+        out.raw("  \"groups\": [\n");
+        out.raw(lights.str().c_str());
+    }
+
+    size_t chunkCount = 0;
+    for (ChunkFile &chunk : chunks) {
+        chunk.file << "\n  ]\n}\n";
+        chunk.file.close();
+        if (!chunk.file) {
+            std::cerr << "could not write " << chunk.name << std::endl;
+            return false;
+        }
+        if (chunk.groups->empty()) {
+            std::remove(chunk.name.c_str());
+            continue;
+        }
+
+        chunkCount++;
+        SceneWriter &reference = groups.next();
+        std::string relativePath = chunk.name.substr(chunk.name.find_last_of("/\\") + 1);
+        reference.raw("{\"chunkFile\": \"");
+        reference.raw(relativePath.c_str());
+        reference.raw("\", \"bounds\": [[");
+        reference.number(chunk.minX); reference.raw(", 0, ");
+        reference.number(chunk.minZ); reference.raw("], [");
+        reference.number(chunk.maxX); reference.raw(", ");
+        reference.number(kMaxHeight); reference.raw(", ");
+        reference.number(chunk.maxZ); reference.raw("]]}");
+    }
+    out.raw("\n  ]\n}\n");
+
+    file.close();
+    if (!file) {
+        std::cerr << "could not write " << options.output << std::endl;
+        return false;
+    }
+
+    std::cout << "Wrote " << options.output << ": " << options.primitives << " primitives ("
+              << references << " x " << templateName(options.depth) << ", " << loose << " loose), "
+              << options.lights << " lights";
+    if (!chunks.empty()) {
+        std::cout << ", " << chunkCount << " chunk files";
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+bool parseArguments(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--primitives" && hasValue) options.primitives = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--lights" && hasValue) options.lights = std::atoi(argv[++i]);
+        else if (arg == "--depth" && hasValue) options.depth = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue) options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--chunks" && hasValue) options.chunks = std::atoi(argv[++i]);
+        else if (arg == "--flat") options.flat = true;
+        else if (arg.rfind("--", 0) != 0 && options.output.empty()) options.output = arg;
+        else {
+            std::cerr << "unknown argument \"" << arg << "\"" << std::endl;
+            return false;
+        }
+    }
+    // Every chunk file is open at once, so keep their number well below descriptor limits
+    if (options.output.empty() || options.lights < 0 || options.depth < 0 || options.depth > 10
+        || options.chunks < 0 || options.chunks > 16) {
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::cerr << "usage: scenegen <output.json> [--primitives N] [--lights N] [--depth N] [--flat] [--chunks K] [--seed N]"
+                  << std::endl;
+        return 1;
+    }
+    return writeScene(options) ? 0 : 1;
+}
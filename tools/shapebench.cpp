@@ -0,0 +1,92 @@
+// Shape tessellation benchmark.
+//
+// Usage: shapebench [param1] [param2] [iterations]
+//
+// Generates each unit primitive at the given tessellation (1000 x 1000 by default) and
+// reports the time per mesh and the size of its vertex and index buffers, with the
+// vertices as floats and packed.
+//
+// Then, for each primitive at every level of detail of that tessellation, reports how
+// well its triangles reuse the post-transform vertex cache before and after
+// optimizeMesh(): ACMR (vertices transformed per triangle) and ATVR (per vertex).
+
+#include "shapes/cube.h"
+#include "shapes/sphere.h"
+#include "shapes/cone.h"
+#include "shapes/cylinder.h"
+#include "shapes/geometrycache.h"
+#include "shapes/vertexcache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void benchShape(const char *name, int iterations, const std::function<ShapeMesh()> &generate) {
+    ShapeMesh mesh;
+    auto start = Clock::now();
+    for (int i = 0; i < iterations; i++) {
+        mesh = generate();
+    }
+    double seconds = secondsSince(start);
+
+    start = Clock::now();
+    std::vector<PackedVertex> packed = packVertices(mesh.vertices);
+    double packSeconds = secondsSince(start);
+
+    size_t vertices = mesh.vertices.size() / 6;
+    size_t indexBytes = mesh.indices.size() * sizeof(GLuint);
+    double floatMegabytes = (mesh.vertices.size() * sizeof(float) + indexBytes) / (1024.0 * 1024.0);
+    double packedMegabytes = (packed.size() * sizeof(PackedVertex) + indexBytes) / (1024.0 * 1024.0);
+    std::cout << name << seconds * 1000 / iterations << " ms, " << vertices << " vertices, "
+              << mesh.indices.size() / 3 << " triangles, " << floatMegabytes << " MB; packed in "
+              << packSeconds * 1000 << " ms to " << packedMegabytes << " MB" << std::endl;
+}
+
+void benchVertexCache(const char *name, int param1, int param2,
+                      const std::function<ShapeMesh(int, int)> &generate) {
+    for (int lod = 0; lod < GeometryCache::kLodLevels; lod++) {
+        int lodParam1 = std::max(1, param1 >> lod);
+        int lodParam2 = std::max(1, param2 >> lod);
+
+        ShapeMesh mesh = generate(lodParam1, lodParam2);
+
+        auto start = Clock::now();
+        auto [before, after] = optimizeMesh(mesh);
+        double seconds = secondsSince(start);
+
+        std::cout << name << lodParam1 << " x " << lodParam2 << ": ACMR " << before.acmr << " -> " << after.acmr
+                  << ", ATVR " << before.atvr << " -> " << after.atvr << ", optimized in "
+                  << seconds * 1000 << " ms" << std::endl;
+    }
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    int param1 = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1000;
+    int param2 = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000;
+    int iterations = argc > 3 ? std::max(1, std::atoi(argv[3])) : 5;
+
+    std::cout << "param1 = " << param1 << ", param2 = " << param2 << std::endl;
+    benchShape("sphere:   ", iterations, [&]() { return Sphere::generateSphereData(param1, param2); });
+    benchShape("cube:     ", iterations, [&]() { return Cube::generateCubeData(param1); });
+    benchShape("cylinder: ", iterations, [&]() { return Cylinder::generateCylinderData(param1, param2); });
+    benchShape("cone:     ", iterations, [&]() { return Cone::generateConeData(param1, param2); });
+
+    std::cout << "vertex cache, " << kVertexCacheSize << " entries:" << std::endl;
+    benchVertexCache("sphere   ", param1, param2, Sphere::generateSphereData);
+    benchVertexCache("cube     ", param1, param2, [](int p1, int) { return Cube::generateCubeData(p1); });
+    benchVertexCache("cylinder ", param1, param2, Cylinder::generateCylinderData);
+    benchVertexCache("cone     ", param1, param2, Cone::generateConeData);
+    return 0;
+}